@@ -4,41 +4,126 @@
 
 // Include all our custom headers
 #include "config.h"
+#include "metrics.h"
+#include "clip_index.h"
+#include "battery_monitor.h"
 #include "button_manager.h"
 #include "audio_manager.h"
 #include "web_server.h"
+#include "udp_trigger.h"
+#include "clock_sync.h"
 #include "ota_manager.h"
 #include "power_manager.h"
+#include "wifi_manager.h"
 
 // Create instances of our managers
 ButtonManager buttonManager;
 AudioManager audioManager;
 WebServerManager webServer;
+UdpTrigger udpTrigger;
+ClockSync clockSync;
 OTAManager otaManager;
 PowerManager powerManager;
 
 // Timing variables for power management
 unsigned long lastActivityCheck = 0;
 
+// Web, OTA, UDP and clock sync start the first time the network comes up
+bool networkStarted = false;
+
 // Callback functions
+// Runs on the button task
 void onButtonPressed(int buttonNum) {
     powerManager.updateActivity(); // Update activity on button press
-    audioManager.playButtonSound(buttonNum);
+    if (CLOCK_SYNC_ENABLED && clockSync.isSynced()) {
+        unsigned long startAt = clockSync.playEverywhere(buttonNum, 1.0f);
+        audioManager.scheduleButtonSound(buttonNum, startAt, 1.0f, AUDIO_SOURCE_BUTTONS);
+    } else {
+        audioManager.playButtonSound(buttonNum, 1.0f, AUDIO_SOURCE_BUTTONS);
+    }
 }
 
+// Web callbacks run on the AsyncTCP task
 void onTestButtonPressed(int buttonNum) {
     powerManager.updateActivity(); // Update activity on web test
-    audioManager.playButtonSound(buttonNum);
+    audioManager.playButtonSound(buttonNum, 1.0f, AUDIO_SOURCE_WEB);
+}
+
+bool onSchedule(const CueRequest *cues, int count) {
+    powerManager.updateActivity(); // Awake from now until the cues have played
+    ScheduledCue batch[SCHEDULE_MAX_BATCH];
+    for (int i = 0; i < count; i++) {
+        batch[i] = {cues[i].startAt, cues[i].buttonNum, cues[i].gain};
+    }
+    return audioManager.scheduleCues(batch, count, AUDIO_SOURCE_WEB);
 }
 
 void onStopAudio() {
     powerManager.updateActivity(); // Update activity on stop command
-    audioManager.stopCurrentAudio();
+    audioManager.stopCurrentAudio(AUDIO_SOURCE_WEB);
 }
 
 void onSetVolume(float volume) {
     powerManager.updateActivity(); // Update activity on volume change
-    audioManager.setVolume(volume);
+    audioManager.setVolume(volume, AUDIO_SOURCE_WEB);
+}
+
+// Deferred to the loop task by webServer.handleClient(); the clip preparation
+// task rescans the clip, so the loop never waits for a replay gain measurement
+void onClipChanged(int clip) {
+    audioManager.reopenClip(clip);
+}
+
+// Runs on the upload writer task before a clip's files are replaced or removed
+bool onClipClose(int clip) {
+    return audioManager.closeClip(clip, AUDIO_SOURCE_STORAGE);
+}
+
+// Runs on the UDP trigger task
+void onUdpCommand(const UdpCommand &command) {
+    powerManager.updateActivity();
+    switch (command.op) {
+        case UDP_OP_PLAY:
+            audioManager.playButtonSound(command.button, command.value / 1000.0f, AUDIO_SOURCE_UDP);
+            break;
+        case UDP_OP_STOP:
+            audioManager.stopButtonSound(command.button, AUDIO_SOURCE_UDP);
+            break;
+        case UDP_OP_STOP_ALL:
+            audioManager.stopCurrentAudio(AUDIO_SOURCE_UDP);
+            break;
+        case UDP_OP_VOLUME:
+            audioManager.setVolume(command.value / 1000.0f, AUDIO_SOURCE_UDP);
+            break;
+    }
+}
+
+// Clock sync callbacks run on the clock sync task
+void onSyncedPlay(int buttonNum, unsigned long startAt, float gain) {
+    powerManager.updateActivity(); // Awake from now until the cue has played
+    audioManager.scheduleButtonSound(buttonNum, startAt, gain, AUDIO_SOURCE_SYNC);
+}
+
+void onClockTrim(int32_t ppm) {
+    audioManager.setClockTrim(ppm, AUDIO_SOURCE_SYNC);
+}
+
+// Runs on the audio task
+void onPlaybackStart() {
+    powerManager.keepAwake();
+}
+
+// Polled on the loop task for the web UI's event stream
+void onGetStatus(PlaybackStatus &status) {
+    status.playing = audioManager.getIsPlaying();
+    status.button = audioManager.getCurrentButton();
+    status.voices = audioManager.getActiveVoices();
+    status.volume = audioManager.getVolume();
+}
+
+// Runs on the battery task
+bool onBatteryLoad() {
+    return audioManager.getIsPlaying();
 }
 
 float onGetVolume() {
@@ -46,6 +131,52 @@ float onGetVolume() {
     return audioManager.getVolume();
 }
 
+void startNetworkServices() {
+    // Initialize OTA and web server
+    otaManager.init();
+    webServer.init();
+    
+    // Set up web server callbacks
+    webServer.setTestButtonCallback(onTestButtonPressed);
+    webServer.setStopAudioCallback(onStopAudio);
+    webServer.setVolumeCallbacks(onSetVolume, onGetVolume);
+    webServer.setClipChangedCallback(onClipChanged);
+    webServer.setClipCloseCallback(onClipClose);
+    webServer.setStatusCallback(onGetStatus);
+    webServer.setScheduleCallback(onSchedule);
+    
+    if (UDP_TRIGGER_ENABLED) {
+        udpTrigger.setCommandCallback(onUdpCommand);
+        udpTrigger.begin();
+    }
+    
+    if (CLOCK_SYNC_ENABLED) {
+        clockSync.setPlayCallback(onSyncedPlay);
+        clockSync.setTrimCallback(onClockTrim);
+        clockSync.begin();
+    }
+    networkStarted = true;
+}
+
+// Network callbacks run on the loop task. UDP and clock sync sockets listen
+// on any address and outlive a dropped connection, so only the web server and
+// OTA (which announces itself over mDNS) are stopped and restarted.
+void onNetworkUp() {
+    // Update activity after WiFi connection
+    powerManager.updateActivity();
+    if (networkStarted) {
+        otaManager.start();
+        webServer.start();
+    } else {
+        startNetworkServices();
+    }
+}
+
+void onNetworkDown() {
+    otaManager.stop();
+    webServer.stop();
+}
+
 void setup() {
     Serial.begin(115200);
     
@@ -53,7 +184,7 @@ void setup() {
     powerManager.init();
     
     // Initialize SPIFFS
-    if(!SPIFFS.begin(true)) {
+    if(!SPIFFS.begin(true, "/spiffs", SPIFFS_MAX_OPEN_FILES)) {
         Serial.println("SPIFFS Mount Failed");
         return;
     }
@@ -62,69 +193,77 @@ void setup() {
     if (!SPIFFS.exists("/audio")) {
         SPIFFS.mkdir("/audio");
     }
-
+    
     // Print SPIFFS info
     size_t totalBytes = SPIFFS.totalBytes();
     size_t usedBytes = SPIFFS.usedBytes();
     Serial.printf("SPIFFS Total: %d bytes, Used: %d bytes, Free: %d bytes\n", 
                   totalBytes, usedBytes, totalBytes - usedBytes);
     
-    // Initialize battery pin
-    pinMode(BATTERY_PIN, INPUT);
+    // Index the clip library and load the playlists before anything looks a clip up
+    clipIndex.begin();
+    playlists.begin();
     
     // Initialize all managers
     buttonManager.init();
     audioManager.init();
+    audioManager.setPlaybackStartCallback(onPlaybackStart);
+    audioManager.startTask();
     
-    // Set up button callback
-    buttonManager.onButtonPressed = onButtonPressed;
-    
-    // Connect to WiFi
-    WiFi.begin(ssid, password);
-    while (WiFi.status() != WL_CONNECTED) {
-        delay(1000);
-        Serial.println("Connecting to WiFi...");
+    // The press that woke the device plays now, not after WiFi has connected
+    int wakeButton = powerManager.getWakeButton();
+    if (wakeButton != 0) {
+        Serial.printf("Playing wake button %d at %lu ms after boot\n", wakeButton, millis());
+        audioManager.playButtonSound(wakeButton, 1.0f);
     }
-    Serial.println("WiFi connected!");
-    Serial.print("IP address: ");
-    Serial.println(WiFi.localIP());
     
-    // Update activity after WiFi connection
-    powerManager.updateActivity();
+    // Set up button callback
+    buttonManager.onButtonPressed = onButtonPressed;
+    buttonManager.startTask();
     
-    // Initialize OTA and web server
-    otaManager.init();
-    webServer.init();
+    // Sample the battery in the background; /battery reads the last result
+    batteryMonitor.setLoadCallback(onBatteryLoad);
+    batteryMonitor.begin();
     
-    // Set up web server callbacks
-    webServer.setTestButtonCallback(onTestButtonPressed);
-    webServer.setStopAudioCallback(onStopAudio);
-    webServer.setVolumeCallbacks(onSetVolume, onGetVolume);
+    // Connect to WiFi in the background; the network callbacks start and stop the services
+    wifiManager.setNetworkCallbacks(onNetworkUp, onNetworkDown);
+    wifiManager.begin();
+    Serial.println("Connecting to WiFi...");
     
     Serial.println("System initialized successfully!");
     Serial.printf("Deep sleep will activate after %lu seconds of inactivity\n", SLEEP_TIMEOUT_MS / 1000);
 }
 
 void loop() {
+    METRIC_TIMER_START(loopStarted);
+    
+    wifiManager.update();
+    powerManager.update();
+    
     // Handle all the different components
     otaManager.handle();
     
-    // Update activity on any web server interaction
-    static bool hadWebActivity = false;
-    webServer.handleClient();
-    // Note: We could implement a more sophisticated web activity detection
-    // by modifying the web server to report when it handles requests
+    // Web requests count as activity through the handler callbacks above
+    if (networkStarted) {
+        webServer.handleClient();
+    }
+    playlists.saveChanges(); // Set from the web handlers, written here off the AsyncTCP task
     
-    audioManager.update();
-    buttonManager.checkButtons();
+    // Playback normally runs on the audio task; pump it here only if that task could not start
+    if (!audioManager.hasTask()) {
+        audioManager.update();
+    }
+    if (!buttonManager.hasTask()) {
+        buttonManager.checkButtons();
+    }
     
     // Periodically check sleep conditions
     unsigned long currentTime = millis();
     if (currentTime - lastActivityCheck >= ACTIVITY_UPDATE_INTERVAL) {
         lastActivityCheck = currentTime;
         
-        // Check if we should enter deep sleep
-        powerManager.checkSleepConditions(audioManager.getIsPlaying());
+        // Check if we should enter deep sleep; a cue waiting to play counts as playing
+        powerManager.checkSleepConditions(audioManager.getIsPlaying() || audioManager.hasPendingCues());
         
         // Optional: Print activity status for debugging
         if (powerManager.getTimeSinceActivity() > 60000) { // Only after 1 minute
@@ -135,5 +274,7 @@ void loop() {
         }
     }
     
-    delay(10);
+    METRIC_OBSERVE_SINCE(loopIteration, loopStarted);
+    // Wake less often between events so light sleep lasts
+    delay(powerManager.getTier() == POWER_TIER_ACTIVE ? 10 : LIGHT_SLEEP_LOOP_MS);
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+#ifndef ADPCM_GENERATOR_H
+#define ADPCM_GENERATOR_H
+
+#include "AudioGenerator.h"
+#include "ima_adpcm.h"
+
+// Plays clips transcoded to IMA-ADPCM at upload time. Decoding is a table
+// lookup per sample and all buffers are members, so begin() is just a header read.
+class AudioGeneratorADPCM : public AudioGenerator {
+private:
+    AdpcmFileHeader header;
+    uint8_t block[ADPCM_BLOCK_BYTES];
+    int16_t pcm[ADPCM_BLOCK_SAMPLES];
+    size_t pcmCount;
+    size_t pcmPos;
+    uint32_t samplesLeft;
+    
+    bool readBlock();
+
+public:
+    AudioGeneratorADPCM();
+    virtual bool begin(AudioFileSource *source, AudioOutput *output) override;
+    virtual bool loop() override;
+    virtual bool stop() override;
+    virtual bool isRunning() override { return running; }
+};
+
+// Implementation
+AudioGeneratorADPCM::AudioGeneratorADPCM() {
+    running = false;
+    file = nullptr;
+    output = nullptr;
+    pcmCount = 0;
+    pcmPos = 0;
+    samplesLeft = 0;
+}
+
+bool AudioGeneratorADPCM::begin(AudioFileSource *source, AudioOutput *output) {
+    if (!source || !output || !source->isOpen()) {
+        return false;
+    }
+    file = source;
+    this->output = output;
+    
+    if (file->read(&header, sizeof(header)) != sizeof(header) || memcmp(header.magic, "IMAD", 4) != 0 ||
+        header.channels != 1 || header.blockBytes != ADPCM_BLOCK_BYTES) {
+        Serial.println("ADPCM: bad clip header");
+        return false;
+    }
+    
+    samplesLeft = header.totalSamples;
+    pcmCount = 0;
+    pcmPos = 0;
+    
+    output->SetRate(header.sampleRate);
+    output->SetBitsPerSample(16);
+    output->SetChannels(1);
+    output->begin();
+    running = true;
+    return true;
+}
+
+bool AudioGeneratorADPCM::readBlock() {
+    uint32_t length = file->read(block, ADPCM_BLOCK_BYTES);
+    pcmCount = adpcmDecodeBlock(block, length, pcm);
+    pcmPos = 0;
+    return pcmCount > 0;
+}
+
+bool AudioGeneratorADPCM::loop() {
+    if (!running) {
+        return false;
+    }
+    
+    while (samplesLeft > 0) {
+        if (pcmPos >= pcmCount && !readBlock()) {
+            break;
+        }
+        lastSample[AudioOutput::LEFTCHANNEL] = pcm[pcmPos];
+        lastSample[AudioOutput::RIGHTCHANNEL] = pcm[pcmPos];
+        if (!output->ConsumeSample(lastSample)) {
+            return true; // Output is full, carry on next time
+        }
+        pcmPos++;
+        samplesLeft--;
+    }
+    
+    running = false;
+    return false;
+}
+
+bool AudioGeneratorADPCM::stop() {
+    running = false;
+    if (output) {
+        output->stop();
+    }
+    if (file) {
+        file->close();
+    }
+    return true;
+}
+
+#endif
@@ -1,157 +1,957 @@
 #ifndef AUDIO_MANAGER_H
 #define AUDIO_MANAGER_H
 
-#include "AudioFileSourceSPIFFS.h"
+#include <atomic>
+#include <new>
+#include <type_traits>
 #include "AudioFileSourceID3.h"
 #include "AudioGeneratorMP3.h"
 #include "AudioOutputI2S.h"
+#include "adpcm_generator.h"
+#include "audio_mixer.h"
+#include "clip_index.h"
+#include "clip_source.h"
+#include "clip_storage.h"
+#include "fixed_heap.h"
+#include "metrics.h"
+#include "pad_topology.h"
+#include "pcm_cache.h"
+#include "playlist.h"
+#include "spsc_ring.h"
 #include "config.h"
 
-class AudioManager {
+enum AudioCommandType : uint8_t {
+    AUDIO_CMD_PLAY,
+    AUDIO_CMD_STOP_BUTTON,
+    AUDIO_CMD_STOP_ALL,
+    AUDIO_CMD_SET_VOLUME,
+    AUDIO_CMD_CLOSE_CLIP,
+    AUDIO_CMD_REOPEN_CLIP, // Prepared off the audio task, ready to swap in
+    AUDIO_CMD_SCHEDULE,
+    AUDIO_CMD_SET_TRIM,
+    AUDIO_CMD_SWAP_PREFIXES // Every clip's PCM prefix is decoded, take them live
+};
+
+// Each thread that issues requests gets its own lock-free ring
+enum AudioCommandSource : uint8_t {
+    AUDIO_SOURCE_MAIN,    // Arduino loop task (clip refreshes, OTA)
+    AUDIO_SOURCE_BUTTONS, // Button task
+    AUDIO_SOURCE_WEB,     // AsyncTCP task running the web handlers
+    AUDIO_SOURCE_UDP,     // UDP trigger task
+    AUDIO_SOURCE_SYNC,    // Clock sync task
+    AUDIO_SOURCE_STORAGE, // Upload writer task (clip swaps and deletes)
+    AUDIO_SOURCE_PREP,    // Clip preparation task (prepared clips)
+    AUDIO_SOURCE_COUNT
+};
+
+// Request sent to the audio task
+struct AudioCommand {
+    AudioCommandType type;
+    int buttonNum;
+    float value;
+    unsigned long issuedAt;
+    unsigned long startAt; // micros() time a scheduled cue should sound
+};
+
+// Clip waiting in the scheduler
+struct ScheduledCue {
+    unsigned long startAt;
+    int buttonNum;
+    float gain;
+};
+
+struct CueBefore {
+    bool operator()(const ScheduledCue &a, const ScheduledCue &b) const {
+        return (long)(a.startAt - b.startAt) < 0;
+    }
+};
+
+// Decoder chain feeding one mixer voice. Everything is set up once in init()
+// and reused, so starting a clip does not allocate.
+struct Voice {
+    AudioGeneratorMP3 *mp3;  // Runs on preallocated memory, null if the pool could not be filled
+    void *mp3Space;
+    ClipFileSource source;
+    AudioFileSourceID3 *id3; // Constructed in id3Storage while decoding
+    alignas(AudioFileSourceID3) uint8_t id3Storage[sizeof(AudioFileSourceID3)];
+    AudioGeneratorADPCM adpcm;
+    AudioGenerator *generator; // mp3 or adpcm while decoding
+    PrefixHandoffOutput handoff;
+    bool decoding;
+    int buttonNum;           // Button that started the voice
+    int clip;                // Clip slot being decoded
+    int position;            // Of that clip in the button's playlist
+    bool chain;              // The playlist continues after this clip
+    int next;                // Voice primed with the following clip, -1 if none
+    float gain;              // Of the press, before each clip's replay gain
+    unsigned long startedAt;
+    bool latencyReported;
+};
+
+template<typename Pad>
+class BasicAudioManager {
 private:
-    AudioGeneratorMP3 *mp3;
-    AudioFileSourceSPIFFS *file;
+    // Clip storage, the PCM cache, clipIndex and playlists are laid out and range-checked by Pads
+    static_assert(std::is_same<Pad, Pads>::value, "The clip tables are built for Pads");
+    
+    Voice voices[Pad::voices];
+    AudioMixer<Pad::voices> mixer;
     AudioOutputI2S *out;
-    AudioFileSourceID3 *id3;
-    bool isPlaying;
-    float currentVolume;
+    SpiffsClipStorage spiffsStorage;
+    PartitionClipStorage partitionStorage;
+    ClipStorage *storage; // Backend presses read from, picked in init()
+    PcmCache pcmCache;
+    SpscRing<AudioCommand, AUDIO_COMMAND_QUEUE_SIZE> commands[AUDIO_SOURCE_COUNT];
+    FixedHeap<ScheduledCue, SCHEDULE_CAPACITY, CueBefore> schedule; // Audio task only
+    TaskHandle_t taskHandle;
+    TaskHandle_t prepHandle;
+    static constexpr int PREP_WORDS = Pad::clips / 32 + 1;
+    std::atomic<uint32_t> pendingPrep[PREP_WORDS]; // Bit per clip for the preparation task, bit 0 for every PCM prefix
+    SemaphoreHandle_t clipClosed;         // Given once a CLOSE_CLIP command has been carried out
+    volatile unsigned long closedTicket;  // startAt of the last CLOSE_CLIP carried out
+    unsigned long closeTickets;           // Only touched by the caller of closeClip()
+    volatile float currentVolume;
+    volatile int activeVoices;
+    volatile int pendingCues;
+    std::atomic<int> freeCueSlots; // Schedule entries not yet claimed by a posted cue
+    volatile int lastButton; // Most recently started button
+    int pooledVoices;
+    uint32_t pressAllocations;
+    
+    // Runs on the audio task right before a clip starts
+    void (*onPlaybackStart)() = nullptr;
     
+    int freeVoice();
+    int allocateVoice();
+    void releaseDecoder(int index);
+    void unlinkChain(int index);
+    void stopVoice(int index);
+    void fadeOutVoice(int index);
+    static float clipGain(int clip);
+    static uint32_t msToFrames(unsigned long ms) { return ms * 44100 / 1000; }
+    bool startClip(int index, int clip);
+    void primeNext(int index);
+    bool handOver(int index);
+    bool post(AudioCommandType type, int buttonNum, float value, AudioCommandSource source = AUDIO_SOURCE_MAIN,
+              unsigned long startAt = 0);
+    bool hasPendingCommands() const;
+    void processCommands();
+    void runSchedule();
+    TickType_t ticksUntilNextCue() const;
+    void startPlayback(int buttonNum, float gain, unsigned long triggeredAt, bool atFrame = false, uint32_t startFrame = 0);
+    void stopButtonNow(int buttonNum);
+    void stopClipNow(int clip);
+    void stopAllNow();
+    void applyVolume(float volume);
+    static size_t allocatedBlocks();
+    static void taskEntry(void *arg);
+    static void prepEntry(void *arg);
+    void runPrep(AudioCommandSource source);
+    void prepareClip(int clip, AudioCommandSource source);
+
 public:
-    AudioManager();
-    ~AudioManager();
+    BasicAudioManager();
+    ~BasicAudioManager();
     void init();
-    void playButtonSound(int buttonNum);
-    void stopCurrentAudio();
+    bool startTask();
+    bool hasTask() const { return taskHandle != nullptr; }
     void update();
-    void setVolume(float volume);
+    
+    // Requests below are queued for the audio task and return immediately.
+    // Each source must only ever be used from its own thread, see AudioCommandSource.
+    void playButtonSound(int buttonNum, float gain = 1.0f, AudioCommandSource source = AUDIO_SOURCE_MAIN);
+    void stopButtonSound(int buttonNum, AudioCommandSource source = AUDIO_SOURCE_MAIN);
+    void stopCurrentAudio(AudioCommandSource source = AUDIO_SOURCE_MAIN);
+    void setVolume(float volume, AudioCommandSource source = AUDIO_SOURCE_MAIN);
+    
+    // Picks up a clip's new files. Rescanning it for the clip index and the
+    // slow storage work run on the clip preparation task, or right here
+    // without one; the audio task then swaps the clip in. Loop task only.
+    void reopenClip(int clip);
+    
+    // Stops the clip's voices and lets go of its files, so they can be
+    // replaced or removed until reopenClip(). Waits up to
+    // CLIP_CLOSE_TIMEOUT_MS for the audio task; false if it did not get there.
+    // One caller at a time, never the audio task or the task running update().
+    bool closeClip(int clip, AudioCommandSource source);
+    
+    // Plays a clip so its first sample leaves the output at startAt (a micros()
+    // time). Cues share one sample clock, so their spacing is exact to the frame.
+    bool scheduleButtonSound(int buttonNum, unsigned long startAt, float gain = 1.0f,
+                             AudioCommandSource source = AUDIO_SOURCE_MAIN);
+    
+    // Schedules every cue or, when the source's queue or the schedule has no
+    // room for all of them, none; false in that case
+    bool scheduleCues(const ScheduledCue *cues, int count, AudioCommandSource source = AUDIO_SOURCE_MAIN);
+    
+    // Speeds the output up (ppm > 0) or slows it down so clips follow the
+    // shared clock of a device group rather than the local crystal
+    void setClockTrim(int32_t ppm, AudioCommandSource source = AUDIO_SOURCE_MAIN);
+    
+    void setPlaybackStartCallback(void (*callback)()) { onPlaybackStart = callback; }
+    
     float getVolume() const { return currentVolume; }
-    bool getIsPlaying() const { return isPlaying; }
+    bool getIsPlaying() const { return activeVoices > 0; }
+    bool hasPendingCues() const { return pendingCues > 0; }
+    int getActiveVoices() const { return activeVoices; }
+    int getCurrentButton() const { return activeVoices > 0 ? lastButton : 0; }
+    uint32_t getPressAllocations() const { return pressAllocations; }
 };
 
+typedef BasicAudioManager<Pads> AudioManager;
+
 // Implementation
-AudioManager::AudioManager() {
-    mp3 = nullptr;
-    file = nullptr;
+template<typename Pad>
+BasicAudioManager<Pad>::BasicAudioManager() {
+    for (int i = 0; i < Pad::voices; i++) {
+        voices[i].mp3 = nullptr;
+        voices[i].mp3Space = nullptr;
+        voices[i].id3 = nullptr;
+        voices[i].generator = nullptr;
+        voices[i].decoding = false;
+        voices[i].buttonNum = 0;
+        voices[i].clip = 0;
+        voices[i].position = 0;
+        voices[i].chain = false;
+        voices[i].next = -1;
+        voices[i].gain = 1.0f;
+        voices[i].startedAt = 0;
+        voices[i].latencyReported = false;
+        voices[i].handoff.setSink(mixer.voice(i));
+    }
+    storage = &spiffsStorage;
     out = nullptr;
-    id3 = nullptr;
-    isPlaying = false;
+    taskHandle = nullptr;
+    prepHandle = nullptr;
+    for (int i = 0; i < PREP_WORDS; i++) {
+        pendingPrep[i] = 0;
+    }
+    clipClosed = nullptr;
+    closedTicket = 0;
+    closeTickets = 0;
     currentVolume = DEFAULT_AUDIO_GAIN;
+    activeVoices = 0;
+    pendingCues = 0;
+    freeCueSlots = SCHEDULE_CAPACITY;
+    lastButton = 0;
+    pooledVoices = 0;
+    pressAllocations = 0;
 }
 
-AudioManager::~AudioManager() {
-    stopCurrentAudio();
+template<typename Pad>
+BasicAudioManager<Pad>::~BasicAudioManager() {
+    if (prepHandle) {
+        vTaskDelete(prepHandle);
+        prepHandle = nullptr;
+    }
+    if (taskHandle) {
+        vTaskDelete(taskHandle);
+        taskHandle = nullptr;
+    }
+    stopAllNow();
+    for (int i = 0; i < Pad::voices; i++) {
+        delete voices[i].mp3;
+        free(voices[i].mp3Space);
+        voices[i].mp3 = nullptr;
+        voices[i].mp3Space = nullptr;
+    }
     if (out) {
         delete out;
         out = nullptr;
     }
 }
 
-void AudioManager::init() {
+template<typename Pad>
+void BasicAudioManager<Pad>::init() {
     // Initialize audio output
     out = new AudioOutputI2S();
     out->SetPinout(I2S_BCLK_PIN, I2S_LRC_PIN, I2S_DIN_PIN); // BCLK, LRC, DIN
-    out->SetGain(currentVolume); // Use current volume setting
+    out->SetGain(1.0f); // Volume is applied, ramped, by the mixer
+    mixer.setMasterGain(currentVolume);
+    mixer.setSink(out);
+    clipClosed = xSemaphoreCreateBinary();
+    
+    // Preallocate one MP3 decoder per voice; each needs ~30KB, so prefer PSRAM
+    for (int i = 0; i < Pad::voices; i++) {
+        size_t size = AudioGeneratorMP3::preAllocSize();
+        void *space = psramFound() ? ps_malloc(size) : nullptr;
+        if (!space) {
+            space = malloc(size);
+        }
+        if (!space) {
+            break;
+        }
+        voices[i].mp3Space = space;
+        voices[i].mp3 = new AudioGeneratorMP3(space, size);
+        pooledVoices++;
+    }
+    Serial.printf("Decoder pool: %d of %d voices\n", pooledVoices, Pad::voices);
+    
+    // Clips are read from the raw partition when it is enabled and present
+    if (CLIP_PARTITION_ENABLED && partitionStorage.begin()) {
+        storage = &partitionStorage;
+    } else {
+        spiffsStorage.begin();
+    }
+    Serial.printf("Clip storage: %s\n", storage->getName());
+    
+    // Decode the start of every clip so presses can start from RAM; the
+    // preparation task does it once startTask() has it running
+    if (PCM_PREFIX_CACHE_ENABLED) {
+        pendingPrep[0].fetch_or(1);
+    }
+}
+
+template<typename Pad>
+bool BasicAudioManager<Pad>::startTask() {
+    if (xTaskCreatePinnedToCore(prepEntry, "clipprep", CLIP_PREP_TASK_STACK_SIZE, this, CLIP_PREP_TASK_PRIORITY,
+                                &prepHandle, CLIP_PREP_TASK_CORE) == pdPASS) {
+        xTaskNotifyGive(prepHandle); // Picks up the PCM prefixes init() asked for
+    } else {
+        prepHandle = nullptr;
+        Serial.println("Failed to start clip preparation task, clips are prepared on loop()");
+        runPrep(AUDIO_SOURCE_MAIN);
+    }
+    
+    BaseType_t result = xTaskCreatePinnedToCore(taskEntry, "audio", AUDIO_TASK_STACK_SIZE, this,
+                                                AUDIO_TASK_PRIORITY, &taskHandle, AUDIO_TASK_CORE);
+    if (result != pdPASS) {
+        taskHandle = nullptr;
+        Serial.println("Failed to start audio task, falling back to loop() playback");
+        return false;
+    }
+    Serial.printf("Audio task started on core %d\n", AUDIO_TASK_CORE);
+    return true;
+}
+
+template<typename Pad>
+void BasicAudioManager<Pad>::prepEntry(void *arg) {
+    BasicAudioManager *self = static_cast<BasicAudioManager *>(arg);
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        self->runPrep(AUDIO_SOURCE_PREP);
+    }
 }
 
-void AudioManager::setVolume(float volume) {
+// On the preparation task, or on the loop task when there is none
+template<typename Pad>
+void BasicAudioManager<Pad>::runPrep(AudioCommandSource source) {
+    for (int word = 0; word < PREP_WORDS; word++) {
+        uint32_t pending = pendingPrep[word].exchange(0);
+        for (int bit = 0; pending != 0 && bit < 32; bit++) {
+            if (!(pending & (1UL << bit))) {
+                continue;
+            }
+            if (word == 0 && bit == 0) {
+                pcmCache.prepareAll();
+                post(AUDIO_CMD_SWAP_PREFIXES, 0, 0.0f, source);
+            } else {
+                prepareClip(word * 32 + bit, source);
+            }
+        }
+    }
+}
+
+template<typename Pad>
+void BasicAudioManager<Pad>::prepareClip(int clip, AudioCommandSource source) {
+    clipIndex.update(clip); // Storage and the PCM cache read the index; a replay gain scan decodes the whole clip
+    storage->prepare(clip);
+    if (PCM_PREFIX_CACHE_ENABLED) {
+        pcmCache.prepare(clip);
+    }
+    post(AUDIO_CMD_REOPEN_CLIP, clip, 0.0f, source);
+}
+
+template<typename Pad>
+void BasicAudioManager<Pad>::taskEntry(void *arg) {
+    BasicAudioManager *self = static_cast<BasicAudioManager *>(arg);
+    for (;;) {
+        self->update();
+        
+        // Sleep until the next command or cue when idle, otherwise keep the I2S buffers topped up
+        if (self->activeVoices == 0 && !self->hasPendingCommands() && !self->mixer.isClockRunning()) {
+            ulTaskNotifyTake(pdTRUE, self->ticksUntilNextCue());
+        } else {
+            vTaskDelay(1);
+        }
+    }
+}
+
+template<typename Pad>
+bool BasicAudioManager<Pad>::post(AudioCommandType type, int buttonNum, float value, AudioCommandSource source,
+                        unsigned long startAt) {
+    AudioCommand cmd = {type, buttonNum, value, micros(), startAt};
+    if (!commands[source].push(cmd)) {
+        Serial.println("Audio command queue full, request dropped");
+        return false;
+    }
+    if (taskHandle) {
+        xTaskNotifyGive(taskHandle);
+    }
+    return true;
+}
+
+template<typename Pad>
+bool BasicAudioManager<Pad>::hasPendingCommands() const {
+    for (int i = 0; i < AUDIO_SOURCE_COUNT; i++) {
+        if (!commands[i].empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template<typename Pad>
+void BasicAudioManager<Pad>::playButtonSound(int buttonNum, float gain, AudioCommandSource source) {
+    post(AUDIO_CMD_PLAY, buttonNum, gain, source);
+}
+
+template<typename Pad>
+void BasicAudioManager<Pad>::stopButtonSound(int buttonNum, AudioCommandSource source) {
+    post(AUDIO_CMD_STOP_BUTTON, buttonNum, 0.0f, source);
+}
+
+template<typename Pad>
+void BasicAudioManager<Pad>::stopCurrentAudio(AudioCommandSource source) {
+    post(AUDIO_CMD_STOP_ALL, 0, 0.0f, source);
+}
+
+template<typename Pad>
+void BasicAudioManager<Pad>::setVolume(float volume, AudioCommandSource source) {
     // Clamp volume to valid range
     currentVolume = constrain(volume, MIN_AUDIO_GAIN, MAX_AUDIO_GAIN);
+    post(AUDIO_CMD_SET_VOLUME, 0, currentVolume, source);
+}
+
+template<typename Pad>
+void BasicAudioManager<Pad>::reopenClip(int clip) {
+    if (!Pad::isClip(clip)) {
+        return;
+    }
+    // A clip that changes again before it is prepared is prepared once
+    pendingPrep[clip / 32].fetch_or(1UL << (clip % 32));
+    if (prepHandle) {
+        xTaskNotifyGive(prepHandle);
+    } else {
+        runPrep(AUDIO_SOURCE_MAIN);
+    }
+}
+
+template<typename Pad>
+bool BasicAudioManager<Pad>::closeClip(int clip, AudioCommandSource source) {
+    // The ticket tells this close's acknowledgement from that of an earlier one that timed out
+    unsigned long ticket = ++closeTickets;
+    if (!clipClosed || !post(AUDIO_CMD_CLOSE_CLIP, clip, 0.0f, source, ticket)) {
+        return false;
+    }
+    TickType_t started = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(CLIP_CLOSE_TIMEOUT_MS);
+    while (closedTicket != ticket) {
+        TickType_t waited = xTaskGetTickCount() - started;
+        if (waited >= timeout || xSemaphoreTake(clipClosed, timeout - waited) != pdTRUE) {
+            Serial.printf("Audio task did not close %s in time\n", Pad::clipPath(clip).name());
+            return closedTicket == ticket;
+        }
+    }
+    return true;
+}
+
+template<typename Pad>
+bool BasicAudioManager<Pad>::scheduleButtonSound(int buttonNum, unsigned long startAt, float gain, AudioCommandSource source) {
+    ScheduledCue cue = {startAt, buttonNum, gain};
+    return scheduleCues(&cue, 1, source);
+}
+
+template<typename Pad>
+bool BasicAudioManager<Pad>::scheduleCues(const ScheduledCue *cues, int count, AudioCommandSource source) {
+    // Only this source's thread adds to its queue, so the room checked here is still there below
+    if (commands[source].size() + count > commands[source].capacity()) {
+        Serial.println("Audio command queue full, cues dropped");
+        return false;
+    }
+    // Schedule entries are claimed here and handed back by the audio task as cues leave the heap
+    if (freeCueSlots.fetch_sub(count) < count) {
+        freeCueSlots += count;
+        Serial.println("Schedule full, cues dropped");
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        post(AUDIO_CMD_SCHEDULE, cues[i].buttonNum, cues[i].gain, source, cues[i].startAt);
+    }
+    return true;
+}
+
+template<typename Pad>
+void BasicAudioManager<Pad>::setClockTrim(int32_t ppm, AudioCommandSource source) {
+    post(AUDIO_CMD_SET_TRIM, ppm, 0.0f, source);
+}
+
+template<typename Pad>
+void BasicAudioManager<Pad>::processCommands() {
+    AudioCommand cmd;
+    for (int i = 0; i < AUDIO_SOURCE_COUNT; i++) {
+        while (commands[i].pop(cmd)) {
+            switch (cmd.type) {
+                case AUDIO_CMD_PLAY:
+                    startPlayback(cmd.buttonNum, cmd.value, cmd.issuedAt);
+                    break;
+                case AUDIO_CMD_STOP_BUTTON:
+                    freeCueSlots += (int)schedule.removeIf([&cmd](const ScheduledCue &cue) {
+                        return cue.buttonNum == cmd.buttonNum;
+                    });
+                    stopButtonNow(cmd.buttonNum);
+                    break;
+                case AUDIO_CMD_STOP_ALL:
+                    freeCueSlots += (int)schedule.size();
+                    schedule.clear();
+                    stopAllNow();
+                    break;
+                case AUDIO_CMD_SCHEDULE: {
+                    ScheduledCue cue = {cmd.startAt, cmd.buttonNum, cmd.value};
+                    if (!schedule.push(cue)) {
+                        freeCueSlots++; // Cannot happen while every cue claims its entry first
+                        Serial.println("Schedule full, cue dropped");
+                    }
+                    break;
+                }
+                case AUDIO_CMD_SET_VOLUME:
+                    applyVolume(cmd.value);
+                    break;
+                case AUDIO_CMD_SET_TRIM:
+                    mixer.setTrimPpm(cmd.buttonNum); // Carries the ppm
+                    break;
+                case AUDIO_CMD_CLOSE_CLIP:
+                    // A playing voice may still be reading this clip's file or prefix
+                    stopClipNow(cmd.buttonNum);
+                    storage->close(cmd.buttonNum);
+                    pcmCache.invalidate(cmd.buttonNum);
+                    closedTicket = cmd.startAt; // Carries the ticket
+                    xSemaphoreGive(clipClosed);
+                    break;
+                case AUDIO_CMD_REOPEN_CLIP:
+                    // Only switches over; the partition import and the prefix decode already ran in prepareClip()
+                    stopClipNow(cmd.buttonNum);
+                    storage->reopen(cmd.buttonNum);
+                    pcmCache.swapIn(cmd.buttonNum);
+                    break;
+                case AUDIO_CMD_SWAP_PREFIXES:
+                    pcmCache.swapInAll(); // Voices only read a prefix through get() when they start
+                    break;
+            }
+        }
+    }
+}
+
+template<typename Pad>
+size_t BasicAudioManager<Pad>::allocatedBlocks() {
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+    return info.allocated_blocks;
+}
+
+template<typename Pad>
+void BasicAudioManager<Pad>::applyVolume(float volume) {
+    mixer.setMasterGain(volume, msToFrames(VOLUME_RAMP_MS));
+    Serial.printf("Volume set to: %.2f\n", volume);
+}
+
+template<typename Pad>
+void BasicAudioManager<Pad>::update() {
+    processCommands();
+    runSchedule();
     
-    // Apply to audio output if it exists
-    if (out) {
-        out->SetGain(currentVolume);
-        Serial.printf("Volume set to: %.2f\n", currentVolume);
-    }
-}
-
-void AudioManager::update() {
-    // Handle MP3 playback
-    if (mp3 && mp3->isRunning()) {
-        if (!mp3->loop()) {
-            mp3->stop();
-            delete file;
-            delete id3;
-            delete mp3;
-            mp3 = nullptr;
-            file = nullptr;
-            id3 = nullptr;
-            isPlaying = false;
-            Serial.println("MP3 playback finished");
-        }
-    }
-}
-
-void AudioManager::stopCurrentAudio() {
-    if (mp3 && mp3->isRunning()) {
-        mp3->stop();
-        delete file;
-        delete id3;
-        delete mp3;
-        mp3 = nullptr;
-        file = nullptr;
-        id3 = nullptr;
-        isPlaying = false;
+    // Let every running decoder top up its voice buffer
+    for (int i = 0; i < Pad::voices; i++) {
+        Voice &v = voices[i];
+        if (!v.decoding || !v.generator->isRunning()) {
+            continue;
+        }
+        
+        v.handoff.pumpPrefix();
+        
+        // Measured where the mixer hands the voice's first frames to I2S
+        MixerVoice *mixerVoice = mixer.voice(i);
+        if (!v.latencyReported && mixerVoice->hasSounded()) {
+            unsigned long latency = mixerVoice->getSoundedAt() - v.startedAt;
+            Serial.printf("Button %d press-to-first-sample: %lu us\n", v.buttonNum, latency);
+            METRIC_OBSERVE(callbackToFirstSample, latency);
+            // micros() counts from boot, so this is the boot time of the first clip played
+            METRIC_SET_ONCE(bootToFirstSampleUs, mixerVoice->getSoundedAt());
+            v.latencyReported = true;
+        }
+        
+        // Close to the end of a clip that has a successor: get the next decoder going
+        if (v.chain && v.next < 0 && v.source.getSize() - v.source.getPos() < PLAYLIST_PREFETCH_BYTES) {
+            primeNext(i);
+        }
+        
+        METRIC_TIMER_START(decodeStarted);
+        bool running = v.generator->loop();
+        METRIC_OBSERVE_SINCE(decodeCall, decodeStarted);
+        if (!running) {
+            releaseDecoder(i);
+            if (!handOver(i)) {
+                // The voice keeps playing whatever is still buffered
+                mixer.voice(i)->finish();
+                Serial.printf("MP3 playback finished (button %d)\n", v.buttonNum);
+            }
+        }
+    }
+    
+    mixer.pump();
+    activeVoices = mixer.getActiveVoices();
+    pendingCues = schedule.size();
+}
+
+// Starts cues whose frame is within the preroll window. The mixer keeps the
+// sample clock running while a cue is close, so every cue converts to a frame
+// through the same micros-to-frame mapping.
+template<typename Pad>
+void BasicAudioManager<Pad>::runSchedule() {
+    if (schedule.empty()) {
+        mixer.setHoldOpen(false);
+        return;
+    }
+    long untilUs = (long)(schedule.top().startAt - micros());
+    mixer.setHoldOpen(untilUs <= (long)SCHEDULE_HOLD_MS * 1000);
+    if (!mixer.isClockRunning()) {
+        return; // The next pump() starts the clock
+    }
+    
+    uint32_t preroll = SCHEDULE_PREROLL_MS * 44100 / 1000;
+    ScheduledCue cue;
+    while (!schedule.empty()) {
+        uint32_t frame = mixer.frameAt(schedule.top().startAt);
+        int32_t ahead = (int32_t)(frame - mixer.getStreamFrame());
+        if (ahead > (int32_t)preroll) {
+            break;
+        }
+        schedule.pop(cue);
+        freeCueSlots++;
+        if (ahead < 0) {
+            Serial.printf("Cue for button %d is %d frames late\n", cue.buttonNum, -ahead);
+        }
+        startPlayback(cue.buttonNum, cue.gain, micros(), true, frame);
+    }
+}
+
+template<typename Pad>
+TickType_t BasicAudioManager<Pad>::ticksUntilNextCue() const {
+    if (schedule.empty()) {
+        return portMAX_DELAY;
+    }
+    // Wake up in time to start the clock before the cue
+    long untilUs = (long)(schedule.top().startAt - micros()) - (long)SCHEDULE_HOLD_MS * 1000;
+    return untilUs > 0 ? pdMS_TO_TICKS(untilUs / 1000) : 0;
+}
+
+template<typename Pad>
+void BasicAudioManager<Pad>::releaseDecoder(int index) {
+    Voice &v = voices[index];
+    if (!v.decoding) {
+        return;
+    }
+    v.generator->stop();
+    if (v.id3) {
+        v.id3->~AudioFileSourceID3();
+        v.id3 = nullptr;
+    }
+    v.generator = nullptr;
+    v.source.close();
+    v.decoding = false;
+}
+
+template<typename Pad>
+void BasicAudioManager<Pad>::stopVoice(int index) {
+    releaseDecoder(index);
+    mixer.voice(index)->release();
+    voices[index].buttonNum = 0;
+    unlinkChain(index);
+}
+
+// Stops a voice without a click: the decoder goes now, the buffered audio
+// plays out under a short fade
+template<typename Pad>
+void BasicAudioManager<Pad>::fadeOutVoice(int index) {
+    releaseDecoder(index);
+    unlinkChain(index);
+    mixer.voice(index)->fadeOut(msToFrames(FADE_OUT_MS));
+}
+
+template<typename Pad>
+void BasicAudioManager<Pad>::unlinkChain(int index) {
+    Voice &v = voices[index];
+    // A clip primed to follow this one would otherwise wait forever
+    if (v.next >= 0) {
+        int next = v.next;
+        v.next = -1;
+        stopVoice(next);
+    }
+    for (int i = 0; i < Pad::voices; i++) {
+        if (voices[i].next == index) {
+            voices[i].next = -1;
+        }
+    }
+}
+
+template<typename Pad>
+void BasicAudioManager<Pad>::stopButtonNow(int buttonNum) {
+    for (int i = 0; i < Pad::voices; i++) {
+        if (mixer.voice(i)->isActive() && voices[i].buttonNum == buttonNum) {
+            fadeOutVoice(i);
+        }
+    }
+}
+
+// Each clip has one file handle, so only one voice at a time may decode it
+template<typename Pad>
+void BasicAudioManager<Pad>::stopClipNow(int clip) {
+    for (int i = 0; i < Pad::voices; i++) {
+        if (voices[i].decoding && voices[i].clip == clip) {
+            fadeOutVoice(i);
+        }
+    }
+}
+
+template<typename Pad>
+void BasicAudioManager<Pad>::stopAllNow() {
+    bool wasPlaying = mixer.getActiveVoices() > 0;
+    for (int i = 0; i < Pad::voices; i++) {
+        fadeOutVoice(i);
+    }
+    if (wasPlaying) {
         Serial.println("Audio stopped by request");
     }
 }
 
-void AudioManager::playButtonSound(int buttonNum) {
+template<typename Pad>
+int BasicAudioManager<Pad>::freeVoice() {
+    for (int i = 0; i < pooledVoices; i++) {
+        if (!mixer.voice(i)->isActive() && !voices[i].decoding) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+template<typename Pad>
+int BasicAudioManager<Pad>::allocateVoice() {
+    int index = freeVoice();
+    if (index >= 0) {
+        return index;
+    }
+    
+    // All voices busy: take one that is fading out anyway, else steal the one
+    // that has been playing the longest
+    for (int i = 0; i < pooledVoices; i++) {
+        if (mixer.voice(i)->isFading()) {
+            return i;
+        }
+    }
+    int oldest = 0;
+    for (int i = 1; i < pooledVoices; i++) {
+        if (voices[i].startedAt - voices[oldest].startedAt > 0x7FFFFFFFUL) {
+            oldest = i;
+        }
+    }
+    Serial.printf("All voices busy, stealing voice of button %d\n", voices[oldest].buttonNum);
+    return oldest;
+}
+
+template<typename Pad>
+void BasicAudioManager<Pad>::startPlayback(int buttonNum, float gain, unsigned long triggeredAt, bool atFrame,
+                                 uint32_t startFrame) {
+    // Keep log lines short here: Serial.printf allocates for messages over 64 bytes
     Serial.printf("playButtonSound called for button %d\n", buttonNum);
     
-    if (isPlaying) {
-        Serial.println("Stopping current audio...");
-        stopCurrentAudio();
+    if (!Pad::isButton(buttonNum)) {
+        Serial.printf("No clip for button %d\n", buttonNum);
+        return;
+    }
+    int position = playlists.pick(buttonNum, esp_random());
+    Playlist list = playlists.get(buttonNum);
+    if (position >= list.count) {
+        position = 0; // The playlist was replaced in between
+    }
+    int clip = list.clips[position];
+    if (storage->getFormat(clip) == CLIP_NONE) {
+        Serial.printf("No clip for button %d\n", buttonNum);
+        return;
+    }
+    if (pooledVoices == 0) {
+        Serial.println("No decoder available");
+        return;
     }
     
-    String filename = "/audio/button" + String(buttonNum) + ".mp3";
-    Serial.printf("Looking for file: %s\n", filename.c_str());
+    size_t blocksBefore = AUDIO_ALLOC_CHECK_ENABLED ? allocatedBlocks() : 0;
     
-    if (!SPIFFS.exists(filename)) {
-        Serial.printf("File %s not found\n", filename.c_str());
-        return;
+    // Re-triggering a button restarts it, including any clip primed to follow
+    stopButtonNow(buttonNum);
+    stopClipNow(clip);
+    int index = allocateVoice();
+    stopVoice(index);
+    Voice &v = voices[index];
+    MixerVoice *mixerVoice = mixer.voice(index);
+    mixerVoice->reset(gain * clipGain(clip), msToFrames(FADE_IN_MS));
+    if (atFrame) {
+        mixerVoice->scheduleStart(startFrame);
     }
+    v.buttonNum = buttonNum;
+    v.position = position;
+    v.chain = list.chains();
+    v.gain = gain;
+    v.startedAt = triggeredAt;
+    v.latencyReported = atFrame; // A cue sounds on its frame, not as soon as it can
     
-    Serial.printf("File %s exists, starting playback...\n", filename.c_str());
+    if (!startClip(index, clip)) {
+        stopVoice(index);
+    } else {
+        Serial.printf("Playing button %d on voice %d\n", buttonNum, index);
+        lastButton = buttonNum;
+        if (onPlaybackStart != nullptr) {
+            onPlaybackStart();
+        }
+        mixer.pump();
+    }
     
-    file = new AudioFileSourceSPIFFS(filename.c_str());
-    if (!file) {
-        Serial.println("Failed to create AudioFileSourceSPIFFS");
-        return;
+    // Debug check that the press path stayed off the heap. Other tasks can
+    // allocate at the same time, so an occasional hit is not conclusive.
+    if (AUDIO_ALLOC_CHECK_ENABLED) {
+        size_t blocksAfter = allocatedBlocks();
+        if (blocksAfter > blocksBefore) {
+            pressAllocations += blocksAfter - blocksBefore;
+            Serial.printf("Press path allocated %u blocks\n", blocksAfter - blocksBefore);
+        }
+    }
+}
+
+// Replay gain of a clip as a factor, see ClipIndex
+template<typename Pad>
+float BasicAudioManager<Pad>::clipGain(int clip) {
+    if (!REPLAY_GAIN_ENABLED) {
+        return 1.0f;
     }
+    return powf(10.0f, clipIndex.get(clip).gainCentiDb / 2000.0f);
+}
+
+// Points the voice's decoder at a clip. The mixer voice is left as it is, so
+// a clip started on a voice that is still playing continues its stream.
+template<typename Pad>
+bool BasicAudioManager<Pad>::startClip(int index, int clip) {
+    Voice &v = voices[index];
+    v.clip = clip;
     
-    id3 = new AudioFileSourceID3(file);
-    if (!id3) {
-        Serial.println("Failed to create AudioFileSourceID3");
-        delete file;
-        file = nullptr;
-        return;
+    // Start the cached prefix right away, the MP3 decoder below catches up behind it.
+    // ADPCM clips start fast enough on their own.
+    bool isMp3 = storage->getFormat(clip) == CLIP_MP3;
+    const PcmPrefix *prefix = (PCM_PREFIX_CACHE_ENABLED && isMp3) ? pcmCache.get(clip) : nullptr;
+    v.handoff.start(prefix);
+    if (prefix) {
+        mixer.pump(); // Onto I2S before the decoder below takes its time to start
+    }
+    
+    unsigned long openedAt = micros();
+    if (!storage->attach(clip, v.source)) {
+        Serial.printf("Cannot rewind clip %d\n", clip);
+        return false;
+    }
+    if (isMp3) {
+        v.id3 = new (v.id3Storage) AudioFileSourceID3(&v.source);
+        v.generator = v.mp3;
+    } else {
+        v.generator = &v.adpcm;
     }
+    v.decoding = true;
     
-    mp3 = new AudioGeneratorMP3();
-    if (!mp3) {
-        Serial.println("Failed to create AudioGeneratorMP3");
-        delete file;
-        delete id3;
-        file = nullptr;
-        id3 = nullptr;
+    if (!v.generator->begin(isMp3 ? (AudioFileSource *)v.id3 : &v.source, &v.handoff)) {
+        Serial.println("Error starting decoder");
+        return false;
+    }
+    // begin() has read the clip header, so this covers open to first byte
+    Serial.printf("Clip open (%s): %lu us\n", storage->getName(), micros() - openedAt);
+    return true;
+}
+
+// Starts the next clip of a chain on a spare voice. The voice fills its
+// buffer and then waits; handOver() gives it the frame to join on.
+template<typename Pad>
+void BasicAudioManager<Pad>::primeNext(int index) {
+    Voice &v = voices[index];
+    Playlist list = playlists.get(v.buttonNum);
+    int position = list.chains() && v.position < list.count ? list.after(v.position) : -1;
+    if (position < 0) {
+        v.chain = false;
+        return;
+    }
+    int clip = list.clips[position];
+    for (int i = 0; i < Pad::voices; i++) {
+        if (voices[i].decoding && voices[i].clip == clip) {
+            return; // Its file is in use, handOver() starts it on this voice instead
+        }
+    }
+    int spare = freeVoice();
+    if (spare < 0 || storage->getFormat(clip) == CLIP_NONE) {
         return;
     }
     
-    Serial.println("Starting MP3 playback...");
-    isPlaying = true;
+    Voice &n = voices[spare];
+    MixerVoice *mixerVoice = mixer.voice(spare);
+    mixerVoice->reset(v.gain * clipGain(clip)); // No fade, it joins gaplessly
+    mixerVoice->scheduleStart(mixer.getStreamFrame() + 0x40000000UL); // Placeholder until the join frame is known
+    n.buttonNum = v.buttonNum;
+    n.position = position;
+    n.chain = true;
+    n.gain = v.gain;
+    n.startedAt = micros();
+    n.latencyReported = true; // Not started by a press
+    if (!startClip(spare, clip)) {
+        stopVoice(spare);
+        return;
+    }
+    v.next = spare;
+}
+
+// Called when a voice's decoder has run out. Returns true if the voice goes
+// on decoding the next clip of its chain itself.
+template<typename Pad>
+bool BasicAudioManager<Pad>::handOver(int index) {
+    Voice &v = voices[index];
+    if (v.next >= 0) {
+        // The primed voice joins on the frame after the last one still buffered here
+        MixerVoice *current = mixer.voice(index);
+        uint32_t from = current->isWaiting() ? current->getStartFrame() : mixer.getStreamFrame();
+        uint32_t joinFrame = from + current->available();
+        mixer.voice(v.next)->scheduleStart(joinFrame);
+        Serial.printf("Button %d: clip %d joins at frame %u\n", v.buttonNum, voices[v.next].clip, joinFrame);
+        v.next = -1;
+        return false;
+    }
+    if (!v.chain) {
+        return false;
+    }
     
-    if (!mp3->begin(id3, out)) {
-        Serial.println("Error starting MP3 decoder");
-        isPlaying = false;
-        delete file;
-        delete id3;
-        delete mp3;
-        file = nullptr;
-        id3 = nullptr;
-        mp3 = nullptr;
-    } else {
-        Serial.println("MP3 playback started successfully");
+    // Nothing primed (no spare voice, or the clip follows itself): continue on
+    // this voice. Its buffered frames have to cover the decoder start.
+    Playlist list = playlists.get(v.buttonNum);
+    int position = list.chains() && v.position < list.count ? list.after(v.position) : -1;
+    if (position < 0 || storage->getFormat(list.clips[position]) == CLIP_NONE) {
+        return false;
+    }
+    int clip = list.clips[position];
+    for (int i = 0; i < Pad::voices; i++) {
+        if (voices[i].decoding && voices[i].clip == clip) {
+            return false;
+        }
+    }
+    v.position = position;
+    // Ramped, as the change reaches the previous clip's last buffered frames too
+    mixer.voice(index)->setGain(v.gain * clipGain(clip), msToFrames(VOLUME_RAMP_MS));
+    if (!startClip(index, clip)) {
+        releaseDecoder(index);
+        return false;
     }
+    Serial.printf("Button %d: clip %d continues on voice %d\n", v.buttonNum, clip, index);
+    return true;
 }
 
-#endif
\ No newline at end of file
+#endif
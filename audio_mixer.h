@@ -0,0 +1,427 @@
+#ifndef AUDIO_MIXER_H
+#define AUDIO_MIXER_H
+
+#include "AudioOutput.h"
+#include "dsp_kernels.h"
+#include "metrics.h"
+#include "config.h"
+
+static_assert((VOICE_BUFFER_FRAMES & (VOICE_BUFFER_FRAMES - 1)) == 0, "VOICE_BUFFER_FRAMES must be a power of two");
+
+const float MAX_VOICE_GAIN = 8.0f; // Limit of the Q12 sample gains in dsp_kernels.h
+
+// Gain that moves to a new value in a straight line over a number of frames,
+// so volume changes, starts and stops do not click
+struct GainRamp {
+    int32_t gainQ20;
+    int32_t targetQ20;
+    int32_t stepQ20; // Per frame while frames > 0
+    uint32_t frames;
+    
+    void set(float gain, float maxGain, uint32_t rampFrames);
+    void advance(uint32_t count);
+};
+
+// One mixer input. A decoder writes into it like any other AudioOutput and
+// the mixer drains it block by block.
+class MixerVoice : public AudioOutput {
+private:
+    int16_t buffer[VOICE_BUFFER_FRAMES * 2];
+    uint32_t writeCount;
+    uint32_t readCount;
+    GainRamp gain;
+    uint32_t startFrame;
+    bool active;
+    bool ended;
+    bool waiting; // Holds its audio back until the stream reaches startFrame
+    bool fading;  // Released once its fade-out reaches silence
+    bool sounded; // Has had frames mixed into a block for I2S
+    unsigned long soundedAt; // micros() of that block
+    
+    void mixRun(int32_t *acc, const int16_t *src, uint32_t frames);
+
+public:
+    MixerVoice();
+    void reset(float gain, uint32_t fadeInFrames = 0);
+    void finish() { ended = true; }
+    void release() { active = false; }
+    void setGain(float gain, uint32_t rampFrames = 0) { this->gain.set(gain, MAX_VOICE_GAIN, rampFrames); }
+    // Plays on from the buffer while the gain falls to zero, then releases
+    void fadeOut(uint32_t frames);
+    void scheduleStart(uint32_t frame) { startFrame = frame; waiting = true; }
+    void startNow() { waiting = false; }
+    bool isWaiting() const { return waiting; }
+    uint32_t getStartFrame() const { return startFrame; }
+    bool isActive() const { return active; }
+    bool isEnded() const { return ended; }
+    bool isFading() const { return fading; }
+    bool isDrained() const { return ended && (available() == 0 || (fading && gain.frames == 0)); }
+    uint32_t available() const { return writeCount - readCount; }
+    bool hasSounded() const { return sounded; }
+    unsigned long getSoundedAt() const { return soundedAt; }
+    int getRate() const { return hertz; }
+    void mixInto(int32_t *acc, uint32_t frames);
+    
+    virtual bool begin() override { return true; }
+    virtual bool ConsumeSample(int16_t sample[2]) override;
+    virtual bool stop() override { return true; }
+};
+
+// Sums up to VOICES active voices into the I2S output with integer math, then
+// applies the ramped master volume and the soft limiter (or plain saturation).
+// Frames handed to the output are counted, which gives a sample clock that
+// scheduled voices start on. While the clock is needed (holdOpen, or a voice
+// waiting for its start frame) silence is rendered instead of stopping.
+// A rate trim in ppm drops or repeats single output frames so the clips keep
+// pace with a clock other than the local crystal (see clock_sync.h).
+template<int VOICES>
+class AudioMixer {
+private:
+    MixerVoice voices[VOICES];
+    AudioOutput *sink;
+    int32_t accum[MIXER_BLOCK_FRAMES * 2];
+    int16_t block[(MIXER_BLOCK_FRAMES + 1) * 2]; // One spare frame for a repeat
+    uint32_t blockFrames;
+    uint32_t blockPos;
+    int sinkRate;
+    bool sinkRunning;
+    bool holdOpen;
+    uint32_t streamFrame;   // Clip frames rendered since boot, wraps
+    uint64_t clockMicros;   // micros() extended to 64 bits at the last tick(), so
+    uint32_t clockLast;     // the anchor stays usable however long the stream runs
+    uint64_t anchorMicros;  // Extended micros() at anchorFrame, reset when the stream (re)starts or changes rate
+    uint32_t anchorFrame;
+    int32_t trimPpm;        // > 0 drops output frames, < 0 repeats them
+    uint32_t trimPhase;
+    GainRamp master;
+    
+    bool renderBlock();
+    uint32_t tick();
+    uint64_t extendMicros(uint32_t atMicros) const { return clockMicros + (int32_t)(atMicros - clockLast); }
+
+public:
+    AudioMixer();
+    void setSink(AudioOutput *output) { sink = output; }
+    MixerVoice *voice(int index) { return &voices[index]; }
+    int getActiveVoices() const;
+    void pump();
+    void setHoldOpen(bool hold) { holdOpen = hold; }
+    bool isClockRunning() const { return sinkRunning; }
+    uint32_t getStreamFrame() const { return streamFrame; }
+    uint32_t frameAt(uint32_t atMicros) const;
+    void setTrimPpm(int32_t ppm);
+    int32_t getTrimPpm() const { return trimPpm; }
+    void setMasterGain(float gain, uint32_t rampFrames = 0) { master.set(gain, 1.0f, rampFrames); }
+};
+
+// Implementation
+void GainRamp::set(float gain, float maxGain, uint32_t rampFrames) {
+    targetQ20 = (int32_t)(constrain(gain, 0.0f, maxGain) * GAIN_Q20_UNITY);
+    frames = rampFrames;
+    if (frames == 0) {
+        gainQ20 = targetQ20;
+        stepQ20 = 0;
+    } else {
+        stepQ20 = (targetQ20 - gainQ20) / (int32_t)frames;
+    }
+}
+
+void GainRamp::advance(uint32_t count) {
+    frames -= count;
+    // Land exactly on the target, the per-frame step is rounded
+    gainQ20 = frames == 0 ? targetQ20 : gainQ20 + stepQ20 * (int32_t)count;
+}
+
+MixerVoice::MixerVoice() {
+    writeCount = 0;
+    readCount = 0;
+    gain.set(1.0f, MAX_VOICE_GAIN, 0);
+    startFrame = 0;
+    active = false;
+    ended = false;
+    waiting = false;
+    fading = false;
+    sounded = false;
+    soundedAt = 0;
+    hertz = 44100;
+    bps = 16;
+    channels = 2;
+}
+
+void MixerVoice::reset(float gain, uint32_t fadeInFrames) {
+    writeCount = 0;
+    readCount = 0;
+    ended = false;
+    waiting = false;
+    fading = false;
+    sounded = false;
+    soundedAt = 0;
+    hertz = 44100;
+    bps = 16;
+    channels = 2;
+    setGain(0.0f);
+    setGain(gain, fadeInFrames);
+    active = true;
+}
+
+void MixerVoice::fadeOut(uint32_t frames) {
+    // A voice that has not started yet has nothing to fade
+    if (!active || waiting || available() == 0) {
+        active = false;
+        return;
+    }
+    // The fade ends with the buffered audio at the latest
+    setGain(0.0f, frames < available() ? frames : available());
+    ended = true;
+    fading = true;
+}
+
+bool MixerVoice::ConsumeSample(int16_t sample[2]) {
+    if (!active || available() >= VOICE_BUFFER_FRAMES) {
+        return false;
+    }
+    
+    int16_t frame[2] = {sample[0], sample[1]};
+    MakeSampleStereo16(frame);
+    uint32_t pos = (writeCount & (VOICE_BUFFER_FRAMES - 1)) * 2;
+    buffer[pos] = frame[0];
+    buffer[pos + 1] = frame[1];
+    writeCount++;
+    return true;
+}
+
+void MixerVoice::mixInto(int32_t *acc, uint32_t frames) {
+    uint32_t start = readCount & (VOICE_BUFFER_FRAMES - 1);
+    uint32_t first = frames;
+    if (first > VOICE_BUFFER_FRAMES - start) {
+        first = VOICE_BUFFER_FRAMES - start;
+    }
+    
+    // The ring may wrap, which splits the read into two linear runs
+    mixRun(acc, &buffer[start * 2], first);
+    mixRun(acc + first * 2, buffer, frames - first);
+    readCount += frames;
+    
+    // The mixer hands this block to I2S straight away, so this is when the voice is heard
+    if (!sounded) {
+        sounded = true;
+        soundedAt = micros();
+    }
+}
+
+void MixerVoice::mixRun(int32_t *acc, const int16_t *src, uint32_t frames) {
+    uint32_t ramped = frames < gain.frames ? frames : gain.frames;
+    if (ramped > 0) {
+        mixAccumulateRamp(acc, src, ramped, gain.gainQ20, gain.stepQ20);
+        gain.advance(ramped);
+    }
+    mixAccumulate(acc + ramped * 2, src + ramped * 2, (frames - ramped) * 2, gain.gainQ20 >> 8);
+}
+
+template<int VOICES>
+AudioMixer<VOICES>::AudioMixer() {
+    sink = nullptr;
+    blockFrames = 0;
+    blockPos = 0;
+    sinkRate = 0;
+    sinkRunning = false;
+    holdOpen = false;
+    streamFrame = 0;
+    clockMicros = 0;
+    clockLast = 0;
+    anchorMicros = 0;
+    anchorFrame = 0;
+    trimPpm = 0;
+    trimPhase = 0;
+    master.set(1.0f, 1.0f, 0);
+}
+
+// Advances the extended clock; called at least once per micros() wrap (pump() runs every few ms)
+template<int VOICES>
+uint32_t AudioMixer<VOICES>::tick() {
+    uint32_t now = micros();
+    clockMicros += now - clockLast;
+    clockLast = now;
+    return now;
+}
+
+// Clip frame that plays at the given micros() time, valid while the clock
+// runs and for times within 35 minutes of now
+template<int VOICES>
+uint32_t AudioMixer<VOICES>::frameAt(uint32_t atMicros) const {
+    int64_t elapsedUs = (int64_t)(extendMicros(atMicros) - anchorMicros);
+    int64_t frames = elapsedUs * sinkRate / 1000000;
+    return anchorFrame + (uint32_t)(frames + frames * trimPpm / 1000000);
+}
+
+template<int VOICES>
+void AudioMixer<VOICES>::setTrimPpm(int32_t ppm) {
+    if (ppm == trimPpm) {
+        return;
+    }
+    // Re-anchor so frames already promised keep their times
+    if (sinkRunning) {
+        uint32_t now = tick();
+        anchorFrame = frameAt(now);
+        anchorMicros = clockMicros;
+    }
+    trimPpm = ppm;
+}
+
+template<int VOICES>
+int AudioMixer<VOICES>::getActiveVoices() const {
+    int count = 0;
+    for (int i = 0; i < VOICES; i++) {
+        if (voices[i].isActive()) {
+            count++;
+        }
+    }
+    return count;
+}
+
+template<int VOICES>
+void AudioMixer<VOICES>::pump() {
+    // Frames already handed to I2S should be ahead of the one playing now. If
+    // they are not, the output ran dry and the sample clock slipped: count it
+    // and re-anchor so scheduled voices map onto what is actually playing.
+    uint32_t now = tick();
+    if (sinkRunning) {
+        uint32_t queued = streamFrame - (blockFrames - blockPos);
+        if ((int32_t)(queued - frameAt(now)) < 0) {
+            METRIC_COUNT(i2sUnderruns);
+            anchorMicros = clockMicros;
+            anchorFrame = queued;
+        }
+    }
+    
+    while (true) {
+        // Finish handing the current block to I2S before rendering another one
+        while (blockPos < blockFrames) {
+            if (!sink->ConsumeSample(&block[blockPos * 2])) {
+                return;
+            }
+            blockPos++;
+        }
+        if (!renderBlock()) {
+            return;
+        }
+    }
+}
+
+template<int VOICES>
+bool AudioMixer<VOICES>::renderBlock() {
+    uint32_t frames = MIXER_BLOCK_FRAMES;
+    int rate = 0;
+    bool anyActive = false;
+    bool clocked = holdOpen;
+    
+    for (int i = 0; i < VOICES; i++) {
+        MixerVoice &v = voices[i];
+        if (!v.isActive()) {
+            continue;
+        }
+        if (v.isDrained()) {
+            v.release();
+            continue;
+        }
+        anyActive = true;
+        
+        // End the block exactly where a waiting voice starts, so it joins on its frame
+        if (v.isWaiting()) {
+            int32_t until = (int32_t)(v.getStartFrame() - streamFrame);
+            if (until > 0) {
+                clocked = true;
+                if ((uint32_t)until < frames) {
+                    frames = until;
+                }
+                continue;
+            }
+            v.startNow();
+        }
+        
+        // A voice with nothing buffered yet is skipped so it cannot stall the others
+        uint32_t avail = v.available();
+        if (avail > 0 && avail < frames) {
+            frames = avail;
+        }
+        if (avail > 0 && rate == 0) {
+            rate = v.getRate();
+        }
+    }
+    
+    if (!anyActive && !holdOpen) {
+        if (sinkRunning) {
+            sink->stop();
+            sinkRunning = false;
+            sinkRate = 0;
+        }
+        return false;
+    }
+    if (rate == 0) {
+        if (!clocked) {
+            return false; // Voices are active but none has produced audio yet
+        }
+        rate = sinkRate ? sinkRate : 44100; // Keep the clock going on silence
+    }
+    
+    if (!sinkRunning) {
+        sink->SetBitsPerSample(16);
+        sink->SetChannels(2);
+        sink->begin();
+        sinkRunning = true;
+    }
+    if (rate != sinkRate) {
+        sink->SetRate(rate);
+        sinkRate = rate;
+        tick();
+        anchorMicros = clockMicros;
+        anchorFrame = streamFrame;
+    }
+    
+    METRIC_TIMER_START(mixStarted);
+    memset(accum, 0, frames * 2 * sizeof(int32_t));
+    for (int i = 0; i < VOICES; i++) {
+        MixerVoice &v = voices[i];
+        if (v.isActive() && !v.isWaiting() && v.available() > 0) {
+            v.mixInto(accum, frames);
+        }
+    }
+    
+    // Master volume, ramped so changes do not click
+    uint32_t ramped = frames < master.frames ? frames : master.frames;
+    if (ramped > 0) {
+        applyGainRamp(accum, ramped, master.gainQ20, master.stepQ20);
+        master.advance(ramped);
+    }
+    if (master.gainQ20 != GAIN_Q20_UNITY) {
+        applyGain(accum + ramped * 2, (frames - ramped) * 2, master.gainQ20 >> 8);
+    }
+    
+    if (LIMITER_ENABLED) {
+        softLimit(block, accum, frames * 2, LIMITER_THRESHOLD);
+    } else {
+        mixSaturate(block, accum, frames * 2);
+    }
+    METRIC_OBSERVE_SINCE(mixBlock, mixStarted);
+    streamFrame += frames;
+    blockFrames = frames;
+    blockPos = 0;
+    
+    // Spread the trim out as single dropped or repeated frames
+    if (trimPpm != 0) {
+        trimPhase += frames * (uint32_t)abs(trimPpm);
+        if (trimPhase >= 1000000) {
+            trimPhase -= 1000000;
+            if (trimPpm > 0) {
+                blockFrames--;
+            } else {
+                block[frames * 2] = block[frames * 2 - 2];
+                block[frames * 2 + 1] = block[frames * 2 - 1];
+                blockFrames++;
+            }
+        }
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef BATTERY_MODEL_H
+#define BATTERY_MODEL_H
+
+#include <stddef.h>
+
+// Turns raw battery readings into a steady voltage. A reading taken under load
+// first gets the drop across the cell's internal resistance added back, then
+// goes through a median of the last WINDOW readings, which throws out spikes
+// from the amplifier's current steps, and a first-order low-pass.
+// No Arduino dependencies, so recorded traces can be replayed on a PC.
+template<size_t WINDOW>
+class BatteryFilter {
+private:
+    float readings[WINDOW];
+    size_t count;
+    size_t next;
+    float filtered;
+    float alpha; // Weight of each new reading in the low-pass
+
+public:
+    explicit BatteryFilter(float alpha) : alpha(alpha) { reset(); }
+    void reset();
+    // Returns the filtered open-circuit voltage
+    float add(float volts, float loadAmps, float internalOhms);
+    bool isValid() const { return count > 0; }
+    float getVolts() const { return filtered; }
+};
+
+// State of charge of one Li-ion cell from its open-circuit voltage, 0-100
+float liionStateOfCharge(float volts);
+
+// Implementation
+template<size_t WINDOW>
+void BatteryFilter<WINDOW>::reset() {
+    count = 0;
+    next = 0;
+    filtered = 0.0f;
+}
+
+template<size_t WINDOW>
+float BatteryFilter<WINDOW>::add(float volts, float loadAmps, float internalOhms) {
+    readings[next] = volts + loadAmps * internalOhms;
+    next = (next + 1) % WINDOW;
+    if (count < WINDOW) {
+        count++;
+    }
+    
+    // Insertion sort of a copy; WINDOW is a handful of readings
+    float sorted[WINDOW];
+    for (size_t i = 0; i < count; i++) {
+        float value = readings[i];
+        size_t j = i;
+        while (j > 0 && sorted[j - 1] > value) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+    float median = sorted[count / 2];
+    
+    // The first reading starts the filter where the cell is instead of at zero
+    filtered = count == 1 ? median : filtered + alpha * (median - filtered);
+    return filtered;
+}
+
+inline float liionStateOfCharge(float volts) {
+    // Resting voltage of a typical cell against charge, at low discharge rates
+    static const float CURVE[][2] = {
+        {3.00f, 0.0f},  {3.45f, 5.0f},  {3.68f, 10.0f}, {3.74f, 20.0f}, {3.77f, 30.0f}, {3.79f, 40.0f},
+        {3.82f, 50.0f}, {3.87f, 60.0f}, {3.92f, 70.0f}, {3.98f, 80.0f}, {4.06f, 90.0f}, {4.20f, 100.0f},
+    };
+    const size_t points = sizeof(CURVE) / sizeof(CURVE[0]);
+    if (volts <= CURVE[0][0]) {
+        return 0.0f;
+    }
+    for (size_t i = 1; i < points; i++) {
+        if (volts < CURVE[i][0]) {
+            float t = (volts - CURVE[i - 1][0]) / (CURVE[i][0] - CURVE[i - 1][0]);
+            return CURVE[i - 1][1] + t * (CURVE[i][1] - CURVE[i - 1][1]);
+        }
+    }
+    return 100.0f;
+}
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef BATTERY_MONITOR_H
+#define BATTERY_MONITOR_H
+
+#include "battery_model.h"
+#include "config.h"
+
+// Latest filtered battery state, small enough to copy out under a lock
+struct BatteryReading {
+    float volts;
+    float percent;
+};
+
+// Samples the battery on its own low-priority task every
+// BATTERY_SAMPLE_INTERVAL_MS: BATTERY_OVERSAMPLE ADC conversions are averaged
+// and fed through a BatteryFilter. Readers such as the /battery handler only
+// copy the last result.
+class BatteryMonitor {
+private:
+    BatteryFilter<BATTERY_MEDIAN_WINDOW> filter;
+    BatteryReading reading;
+    mutable portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    TaskHandle_t taskHandle;
+    
+    // Runs on the battery task; true while the amplifier is driving a clip
+    bool (*isLoaded)() = nullptr;
+    
+    void sample();
+    static void taskEntry(void *arg);
+
+public:
+    BatteryMonitor();
+    ~BatteryMonitor();
+    bool begin();
+    void setLoadCallback(bool (*callback)());
+    BatteryReading get() const;
+};
+
+BatteryMonitor batteryMonitor;
+
+// Implementation
+BatteryMonitor::BatteryMonitor() : filter(BATTERY_FILTER_ALPHA) {
+    reading.volts = 0.0f;
+    reading.percent = 0.0f;
+    taskHandle = nullptr;
+}
+
+BatteryMonitor::~BatteryMonitor() {
+    if (taskHandle) {
+        vTaskDelete(taskHandle);
+        taskHandle = nullptr;
+    }
+}
+
+bool BatteryMonitor::begin() {
+    pinMode(BATTERY_PIN, INPUT);
+    sample(); // So the first request already has a value
+    
+    if (xTaskCreatePinnedToCore(taskEntry, "battery", BATTERY_TASK_STACK_SIZE, this,
+                                BATTERY_TASK_PRIORITY, &taskHandle, BATTERY_TASK_CORE) != pdPASS) {
+        Serial.println("Battery monitor: failed to start task");
+        taskHandle = nullptr;
+        return false;
+    }
+    BatteryReading first = get();
+    Serial.printf("Battery: %.2f V, %.0f%%\n", first.volts, first.percent);
+    return true;
+}
+
+void BatteryMonitor::setLoadCallback(bool (*callback)()) {
+    isLoaded = callback;
+}
+
+BatteryReading BatteryMonitor::get() const {
+    portENTER_CRITICAL(&lock);
+    BatteryReading copy = reading;
+    portEXIT_CRITICAL(&lock);
+    return copy;
+}
+
+void BatteryMonitor::sample() {
+    uint32_t sum = 0;
+    for (int i = 0; i < BATTERY_OVERSAMPLE; i++) {
+        sum += analogRead(BATTERY_PIN);
+    }
+    float volts = (float)sum / BATTERY_OVERSAMPLE * ADC_TO_VOLT;
+    float loadAmps = isLoaded && isLoaded() ? BATTERY_PLAYBACK_AMPS : 0.0f;
+    
+    BatteryReading latest;
+    latest.volts = filter.add(volts, loadAmps, BATTERY_INTERNAL_OHMS);
+    latest.percent = liionStateOfCharge(latest.volts);
+    portENTER_CRITICAL(&lock);
+    reading = latest;
+    portEXIT_CRITICAL(&lock);
+}
+
+void BatteryMonitor::taskEntry(void *arg) {
+    BatteryMonitor *self = static_cast<BatteryMonitor *>(arg);
+    TickType_t lastWake = xTaskGetTickCount();
+    for (;;) {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(BATTERY_SAMPLE_INTERVAL_MS));
+        self->sample();
+    }
+}
+
+#endif
@@ -1,84 +1,175 @@
 #ifndef BUTTON_MANAGER_H
 #define BUTTON_MANAGER_H
 
+#include <driver/gpio.h>
+#include <hal/gpio_ll.h>
 #include "config.h"
+#include "debouncer.h"
+#include "pad_topology.h"
+#include "spsc_ring.h"
+#include "metrics.h"
 
-class ButtonManager {
+// Raw edge captured by the GPIO interrupt
+struct ButtonEdge {
+    uint8_t button;
+    uint8_t level;
+    uint32_t timestampUs;
+};
+
+// Interrupt side of the button manager. Kept out of the template below so the
+// ISR is a single ordinary function placed in IRAM.
+// With LIGHT_SLEEP_ENABLED the pins use level interrupts, because only those
+// can wake the chip from light sleep. The ISR arms each pin for the opposite
+// level after every change, so it still sees one interrupt per edge.
+class ButtonEdgeQueue {
+protected:
+    struct PinContext {
+        ButtonEdgeQueue *owner;
+        uint8_t index;
+        uint8_t pin;
+    };
+    
+    // Filled only from the GPIO ISR, which the ESP32 core dispatches for all pins from one handler
+    SpscRing<ButtonEdge, BUTTON_EDGE_QUEUE_SIZE> edges;
+    TaskHandle_t taskHandle;
+    volatile uint32_t droppedEdges;
+    
+    ButtonEdgeQueue() : taskHandle(nullptr), droppedEdges(0) {}
+    static void IRAM_ATTR onEdge(void *arg);
+};
+
+template<typename Pad>
+class BasicButtonManager : public ButtonEdgeQueue {
 private:
-    bool lastButtonState[NUM_BUTTONS];
-    bool currentButtonState[NUM_BUTTONS];
-    unsigned long lastDebounceTime[NUM_BUTTONS];
+    PinContext contexts[Pad::buttons];
+    EdgeDebouncer debouncers[Pad::buttons];
     
+    static void taskEntry(void *arg);
+    void dispatch(int index, EdgeDebouncer::Event event, uint32_t timestampUs);
+
 public:
-    ButtonManager();
+    BasicButtonManager();
     void init();
-    void checkButtons();
+    bool startTask();
+    bool hasTask() const { return taskHandle != nullptr; }
+    bool checkButtons();
     
-    // Callback function pointer for button press events
+    // Callback function pointer for button press events.
+    // Runs on the button task when it is running, otherwise from loop().
     void (*onButtonPressed)(int buttonNum) = nullptr;
 };
 
+typedef BasicButtonManager<Pads> ButtonManager;
+
 // Implementation
-ButtonManager::ButtonManager() {
-    // Initialize arrays
-    for(int i = 0; i < NUM_BUTTONS; i++) {
-        lastButtonState[i] = HIGH;
-        currentButtonState[i] = HIGH;
-        lastDebounceTime[i] = 0;
+void IRAM_ATTR ButtonEdgeQueue::onEdge(void *arg) {
+    PinContext *ctx = static_cast<PinContext *>(arg);
+    ButtonEdgeQueue *self = ctx->owner;
+    // Register read inlined from the HAL; digitalRead() and gpio_get_level() live in flash
+    ButtonEdge edge = {ctx->index, (uint8_t)gpio_ll_get_level(&GPIO, (gpio_num_t)ctx->pin), (uint32_t)micros()};
+    if (LIGHT_SLEEP_ENABLED) {
+        gpio_ll_set_intr_type(&GPIO, (gpio_num_t)ctx->pin, edge.level ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+    }
+    
+    if (!self->edges.push(edge)) {
+        self->droppedEdges++;
+    }
+    
+    if (self->taskHandle) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(self->taskHandle, &woken);
+        if (woken) {
+            portYIELD_FROM_ISR();
+        }
     }
 }
 
-void ButtonManager::init() {
-    // Initialize buttons (using external pull-up resistors)
-    for(int i = 0; i < NUM_BUTTONS; i++) {
-        pinMode(BUTTON_PINS[i], INPUT);
+template<typename Pad>
+BasicButtonManager<Pad>::BasicButtonManager() {
+    for (int i = 0; i < Pad::buttons; i++) {
+        contexts[i].owner = this;
+        contexts[i].index = i;
+        contexts[i].pin = Pad::pin(i);
     }
 }
 
-void ButtonManager::checkButtons() {
-    // Check each button
-    for (int i = 0; i < NUM_BUTTONS; i++) {
-        // Read current button state
-        bool reading = digitalRead(BUTTON_PINS[i]);
-        
-        // Check if button state has changed (for debouncing)
-        if (reading != lastButtonState[i]) {
-            lastDebounceTime[i] = millis(); // Reset debounce timer
+template<typename Pad>
+void BasicButtonManager<Pad>::init() {
+    uint32_t now = micros();
+    
+    // Initialize buttons (using external pull-up resistors)
+    for (int i = 0; i < Pad::buttons; i++) {
+        pinMode(Pad::pin(i), INPUT);
+        // Buttons connect to ground, so LOW means pressed
+        debouncers[i].reset(digitalRead(Pad::pin(i)), now, DEBOUNCE_DELAY * 1000UL, LOW);
+        if (LIGHT_SLEEP_ENABLED) {
+            bool released = digitalRead(Pad::pin(i)) == HIGH;
+            attachInterruptArg(Pad::pin(i), onEdge, &contexts[i], released ? ONLOW : ONHIGH);
+            gpio_wakeup_enable((gpio_num_t)Pad::pin(i), released ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+        } else {
+            attachInterruptArg(Pad::pin(i), onEdge, &contexts[i], CHANGE);
         }
-        
-        // Check if enough time has passed since last state change
-        if ((millis() - lastDebounceTime[i]) > DEBOUNCE_DELAY) {
-            // If the reading is different from current state
-            if (reading != currentButtonState[i]) {
-                currentButtonState[i] = reading;
-                
-                // Button pressed (LOW because button connects to ground)
-                if (currentButtonState[i] == LOW) {
-                    Serial.print("✓ BUTTON ");
-                    Serial.print(i + 1);
-                    Serial.print(" PRESSED  -> GPIO ");
-                    Serial.print(BUTTON_PINS[i]);
-                    Serial.println(" = LOW");
-                    
-                    // Call callback if set
-                    if (onButtonPressed != nullptr) {
-                        onButtonPressed(i + 1);
-                    }
-                }
-                // Button released (HIGH because of pull-up resistor)
-                else {
-                    Serial.print("✗ BUTTON ");
-                    Serial.print(i + 1);
-                    Serial.print(" RELEASED -> GPIO ");
-                    Serial.print(BUTTON_PINS[i]);
-                    Serial.println(" = HIGH");
-                }
-            }
+    }
+}
+
+template<typename Pad>
+bool BasicButtonManager<Pad>::startTask() {
+    BaseType_t result = xTaskCreatePinnedToCore(taskEntry, "buttons", BUTTON_TASK_STACK_SIZE, this,
+                                                BUTTON_TASK_PRIORITY, &taskHandle, BUTTON_TASK_CORE);
+    if (result != pdPASS) {
+        taskHandle = nullptr;
+        Serial.println("Failed to start button task, falling back to loop() scanning");
+        return false;
+    }
+    return true;
+}
+
+template<typename Pad>
+void BasicButtonManager<Pad>::taskEntry(void *arg) {
+    BasicButtonManager *self = static_cast<BasicButtonManager *>(arg);
+    for (;;) {
+        // Sleep until the next edge; only wake periodically while a bounce is still settling
+        bool pending = self->checkButtons();
+        ulTaskNotifyTake(pdTRUE, pending ? pdMS_TO_TICKS(BUTTON_SETTLE_POLL_MS) : portMAX_DELAY);
+    }
+}
+
+template<typename Pad>
+bool BasicButtonManager<Pad>::checkButtons() {
+    ButtonEdge edge;
+    while (edges.pop(edge)) {
+        EdgeDebouncer::Event event = debouncers[edge.button].onEdge(edge.level, edge.timestampUs);
+        dispatch(edge.button, event, edge.timestampUs);
+    }
+    
+    if (droppedEdges > 0) {
+        Serial.printf("Button edge queue overflowed, %u edges dropped\n", droppedEdges);
+        droppedEdges = 0;
+    }
+    
+    // Resolve buttons whose final level was hidden by bounce during the lockout
+    bool pending = false;
+    uint32_t now = micros();
+    for (int i = 0; i < Pad::buttons; i++) {
+        dispatch(i, debouncers[i].poll(now), now);
+        pending |= debouncers[i].isPending();
+    }
+    return pending;
+}
+
+template<typename Pad>
+void BasicButtonManager<Pad>::dispatch(int index, EdgeDebouncer::Event event, uint32_t timestampUs) {
+    if (event == EdgeDebouncer::PRESSED) {
+        // Call callback if set
+        if (onButtonPressed != nullptr) {
+            METRIC_OBSERVE_SINCE(pressToCallback, timestampUs);
+            onButtonPressed(index + 1);
         }
-        
-        // Save the current reading for next loop iteration
-        lastButtonState[i] = reading;
+        Serial.printf("✓ BUTTON %d PRESSED  -> GPIO %d = LOW (handled %lu us after edge)\n",
+                      index + 1, Pad::pin(index), (unsigned long)(micros() - timestampUs));
+    } else if (event == EdgeDebouncer::RELEASED) {
+        Serial.printf("✗ BUTTON %d RELEASED -> GPIO %d = HIGH\n", index + 1, Pad::pin(index));
     }
 }
 
-#endif
\ No newline at end of file
+#endif
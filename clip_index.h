@@ -0,0 +1,363 @@
+#ifndef CLIP_INDEX_H
+#define CLIP_INDEX_H
+
+#include <SPIFFS.h>
+#include <FS.h>
+#include "AudioFileSourceSPIFFS.h"
+#include "AudioFileSourceID3.h"
+#include "AudioGeneratorMP3.h"
+#include "AudioOutput.h"
+#include "config.h"
+#include "pad_topology.h"
+
+// What is known about one clip file
+struct ClipInfo {
+    uint32_t size;        // Bytes of the MP3, 0 when the clip is empty
+    uint32_t durationMs;
+    uint32_t sampleRate;
+    uint16_t bitrateKbps; // Average for VBR clips with a Xing header, otherwise of the first frame
+    uint8_t channels;
+    bool hasAdpcm;        // A transcoded .adp of it exists
+    uint32_t hash;        // FNV-1a of the MP3 bytes
+    int16_t gainCentiDb;  // Replay gain, 0 until measured
+};
+
+// AudioOutput that only listens: loudness of the mono downmix as the RMS of
+// the 2048-sample blocks above -60 dBFS, so silence does not pull it down,
+// and the peak
+class LoudnessMeter : public AudioOutput {
+private:
+    static const uint32_t BLOCK_SAMPLES = 2048;
+    static const uint64_t GATE_SQUARE = 33 * 33; // -60 dBFS
+    
+    uint64_t blockSquares;
+    uint32_t blockCount;
+    double gatedSquares; // Mean squares of the blocks that passed the gate
+    uint32_t gatedBlocks;
+    int32_t peak;
+
+public:
+    LoudnessMeter();
+    virtual bool begin() override { return true; }
+    virtual bool ConsumeSample(int16_t sample[2]) override;
+    virtual bool stop() override { return true; }
+    // Gain towards REPLAY_GAIN_TARGET_DBFS, limited by REPLAY_GAIN_MAX_DB and the peak
+    int16_t replayGainCentiDb() const;
+};
+
+// Index of the clip library kept in RAM, so listing clips or checking a slot
+// never searches the SPIFFS metadata. Built at boot from one walk of /audio
+// and updated by update() after every upload, transcode or delete. A copy is
+// saved to CLIP_INDEX_PATH so boot only rescans clips whose size changed.
+// With REPLAY_GAIN_ENABLED a scan also decodes the clip once to measure its
+// loudness, which takes a few seconds for a long clip, so update() runs on the
+// clip preparation task (audio_manager.h). getRevision() changes with every
+// update, for readers that show the index.
+class ClipIndex {
+private:
+    struct IndexFile {
+        char magic[4]; // "CIDX"
+        uint16_t version;
+        uint16_t count;
+        ClipInfo entries[Pads::clips];
+    };
+    
+    ClipInfo entries[Pads::clips];
+    // update() runs on the clip preparation task while readers sit on the loop, AsyncTCP and audio tasks
+    mutable portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    volatile uint32_t revision; // Bumped under lock with each stored entry
+    
+    static bool scan(int clip, ClipInfo &info);
+    static void parseMp3(File &clip, ClipInfo &info);
+    static int16_t measureGain(int clip);
+    static int clipFromFileName(const char *name, bool &adpcm);
+    void store(int clip, const ClipInfo &info);
+    void save();
+
+public:
+    ClipIndex();
+    void begin();
+    void update(int clip);
+    ClipInfo get(int clip) const;
+    bool has(int clip) const { return get(clip).size > 0; }
+    uint32_t getRevision() const { return revision; }
+};
+
+ClipIndex clipIndex;
+
+// Implementation
+ClipIndex::ClipIndex() {
+    memset(entries, 0, sizeof(entries));
+    revision = 0;
+}
+
+void ClipIndex::begin() {
+    unsigned long started = millis();
+    IndexFile saved;
+    memset(&saved, 0, sizeof(saved));
+    File file = SPIFFS.open(CLIP_INDEX_PATH, "r");
+    if (file) {
+        bool valid = file.read((uint8_t *)&saved, sizeof(saved)) == sizeof(saved) &&
+                     memcmp(saved.magic, "CIDX", 4) == 0 && saved.version == 3 && saved.count == Pads::clips;
+        if (!valid) {
+            memset(&saved, 0, sizeof(saved));
+        }
+        file.close();
+    }
+    
+    // One pass over the directory replaces an exists() lookup per file
+    uint32_t sizes[Pads::clips] = {0};
+    bool adpcm[Pads::clips] = {false};
+    File dir = SPIFFS.open("/audio");
+    if (dir && dir.isDirectory()) {
+        File entry;
+        while ((entry = dir.openNextFile())) {
+            bool isAdpcm;
+            int clip = clipFromFileName(entry.name(), isAdpcm);
+            if (clip != 0) {
+                if (isAdpcm) {
+                    adpcm[clip - 1] = true;
+                } else {
+                    sizes[clip - 1] = entry.size();
+                }
+            }
+            entry.close();
+        }
+    }
+    dir.close();
+    
+    int scanned = 0;
+    for (int i = 1; i <= Pads::clips; i++) {
+        ClipInfo info;
+        memset(&info, 0, sizeof(info));
+        if (sizes[i - 1] > 0 && saved.entries[i - 1].size == sizes[i - 1]) {
+            info = saved.entries[i - 1];
+        } else if (sizes[i - 1] > 0) {
+            scan(i, info);
+            scanned++;
+        }
+        info.hasAdpcm = adpcm[i - 1];
+        entries[i - 1] = info;
+    }
+    if (scanned > 0 || memcmp(saved.entries, entries, sizeof(entries)) != 0) {
+        save();
+    }
+    Serial.printf("Clip index: %d of %d clips rescanned in %lu ms\n", scanned, Pads::clips, millis() - started);
+}
+
+void ClipIndex::update(int clip) {
+    if (!Pads::isClip(clip)) {
+        return;
+    }
+    ClipInfo info;
+    unsigned long started = millis();
+    scan(clip, info);
+    store(clip, info);
+    save();
+    if (info.size > 0) {
+        Serial.printf("Clip index: %s, %u bytes, %u ms, %u kbps, %u Hz, %+.2f dB, hash %08x (%lu ms)\n",
+                      Pads::clipPath(clip).name(), info.size, info.durationMs, info.bitrateKbps, info.sampleRate,
+                      info.gainCentiDb / 100.0f, info.hash, millis() - started);
+    } else {
+        Serial.printf("Clip index: %s is empty\n", Pads::clipPath(clip).name());
+    }
+}
+
+ClipInfo ClipIndex::get(int clip) const {
+    ClipInfo info;
+    if (!Pads::isClip(clip)) {
+        memset(&info, 0, sizeof(info));
+        return info;
+    }
+    portENTER_CRITICAL(&lock);
+    info = entries[clip - 1];
+    portEXIT_CRITICAL(&lock);
+    return info;
+}
+
+void ClipIndex::store(int clip, const ClipInfo &info) {
+    portENTER_CRITICAL(&lock);
+    entries[clip - 1] = info;
+    revision = revision + 1;
+    portEXIT_CRITICAL(&lock);
+}
+
+void ClipIndex::save() {
+    IndexFile saved;
+    memcpy(saved.magic, "CIDX", 4);
+    saved.version = 3;
+    saved.count = Pads::clips;
+    portENTER_CRITICAL(&lock);
+    memcpy(saved.entries, entries, sizeof(entries));
+    portEXIT_CRITICAL(&lock);
+    
+    File file = SPIFFS.open(CLIP_INDEX_PATH, "w");
+    if (!file || file.write((const uint8_t *)&saved, sizeof(saved)) != sizeof(saved)) {
+        Serial.println("Failed to save clip index");
+    }
+    file.close();
+}
+
+// "button3.mp3", "button3_2.mp3" or either as .adp, with or without the directory in front
+int ClipIndex::clipFromFileName(const char *name, bool &adpcm) {
+    const char *slash = strrchr(name, '/');
+    if (slash) {
+        name = slash + 1;
+    }
+    size_t length = strlen(name);
+    adpcm = length > 4 && strcmp(name + length - 4, ".adp") == 0;
+    if (!adpcm) {
+        return Pads::clipFromName(name);
+    }
+    char mp3Name[sizeof(ClipPath::text)];
+    if (length >= sizeof(mp3Name)) {
+        return 0;
+    }
+    memcpy(mp3Name, name, length - 4);
+    strcpy(mp3Name + length - 4, ".mp3");
+    return Pads::clipFromName(mp3Name);
+}
+
+bool ClipIndex::scan(int clip, ClipInfo &info) {
+    memset(&info, 0, sizeof(info));
+    File adpcm = SPIFFS.open(Pads::clipPath(clip, ".adp").c_str(), "r");
+    info.hasAdpcm = (bool)adpcm;
+    adpcm.close();
+    
+    File file = SPIFFS.open(Pads::clipPath(clip).c_str(), "r");
+    if (!file) {
+        return false;
+    }
+    info.size = file.size();
+    
+    uint8_t buffer[512];
+    uint32_t hash = 2166136261UL;
+    size_t n;
+    while ((n = file.read(buffer, sizeof(buffer))) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            hash = (hash ^ buffer[i]) * 16777619UL;
+        }
+    }
+    info.hash = hash;
+    
+    parseMp3(file, info);
+    file.close();
+    if (REPLAY_GAIN_ENABLED) {
+        info.gainCentiDb = measureGain(clip);
+    }
+    return true;
+}
+
+int16_t ClipIndex::measureGain(int clip) {
+    AudioFileSourceSPIFFS file(Pads::clipPath(clip).c_str());
+    AudioFileSourceID3 id3(&file);
+    AudioGeneratorMP3 decoder;
+    LoudnessMeter meter;
+    if (!decoder.begin(&id3, &meter)) {
+        return 0;
+    }
+    while (decoder.loop()) {
+    }
+    decoder.stop();
+    return meter.replayGainCentiDb();
+}
+
+// Reads sample rate, channels and bitrate from the first MPEG audio frame and
+// the frame count from a Xing/Info header when the encoder wrote one
+void ClipIndex::parseMp3(File &clip, ClipInfo &info) {
+    static const uint16_t MPEG1_KBPS[16] = {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0};
+    static const uint16_t MPEG2_KBPS[16] = {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0};
+    static const uint32_t MPEG1_RATES[3] = {44100, 48000, 32000};
+    
+    // Skip an ID3v2 tag; its size is stored as four 7-bit bytes
+    uint8_t header[10];
+    uint32_t start = 0;
+    clip.seek(0);
+    if (clip.read(header, sizeof(header)) == sizeof(header) && memcmp(header, "ID3", 3) == 0) {
+        start = 10 + ((uint32_t)header[6] << 21 | (uint32_t)header[7] << 14 | (uint32_t)header[8] << 7 | header[9]);
+    }
+    
+    uint8_t buffer[512];
+    clip.seek(start);
+    size_t n = clip.read(buffer, sizeof(buffer));
+    for (size_t i = 0; i + 4 <= n; i++) {
+        uint8_t version = (buffer[i + 1] >> 3) & 3; // 3 = MPEG-1, 2 = MPEG-2, 0 = MPEG-2.5
+        uint8_t layer = (buffer[i + 1] >> 1) & 3;   // 1 = Layer III
+        uint8_t bitrateIndex = buffer[i + 2] >> 4;
+        uint8_t rateIndex = (buffer[i + 2] >> 2) & 3;
+        bool sync = buffer[i] == 0xFF && (buffer[i + 1] & 0xE0) == 0xE0;
+        if (!sync || version == 1 || layer != 1 || bitrateIndex == 0 || bitrateIndex == 15 || rateIndex == 3) {
+            continue;
+        }
+        bool mpeg1 = version == 3;
+        bool mono = (buffer[i + 3] >> 6) == 3;
+        info.sampleRate = MPEG1_RATES[rateIndex] >> (mpeg1 ? 0 : version == 2 ? 1 : 2);
+        info.channels = mono ? 1 : 2;
+        info.bitrateKbps = mpeg1 ? MPEG1_KBPS[bitrateIndex] : MPEG2_KBPS[bitrateIndex];
+        uint32_t samplesPerFrame = mpeg1 ? 1152 : 576;
+        uint32_t audioBytes = info.size - start - i;
+        
+        // The Xing/Info tag sits after the side information of the first frame
+        size_t xing = i + 4 + (mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17));
+        if (xing + 12 <= n && (memcmp(buffer + xing, "Xing", 4) == 0 || memcmp(buffer + xing, "Info", 4) == 0) &&
+            (buffer[xing + 7] & 1)) {
+            const uint8_t *p = buffer + xing + 8;
+            uint32_t frames = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+            info.durationMs = (uint64_t)frames * samplesPerFrame * 1000 / info.sampleRate;
+            if (info.durationMs > 0) {
+                info.bitrateKbps = (uint64_t)audioBytes * 8 / info.durationMs;
+            }
+        } else {
+            info.durationMs = (uint64_t)audioBytes * 8 / info.bitrateKbps;
+        }
+        return;
+    }
+}
+
+LoudnessMeter::LoudnessMeter() {
+    blockSquares = 0;
+    blockCount = 0;
+    gatedSquares = 0;
+    gatedBlocks = 0;
+    peak = 0;
+}
+
+bool LoudnessMeter::ConsumeSample(int16_t sample[2]) {
+    int16_t frame[2] = {sample[0], sample[1]};
+    MakeSampleStereo16(frame);
+    int32_t left = frame[0] < 0 ? -frame[0] : frame[0];
+    int32_t right = frame[1] < 0 ? -frame[1] : frame[1];
+    if (left > peak) {
+        peak = left;
+    }
+    if (right > peak) {
+        peak = right;
+    }
+    
+    int32_t mono = (frame[0] + frame[1]) / 2;
+    blockSquares += (uint64_t)(mono * mono);
+    if (++blockCount == BLOCK_SAMPLES) {
+        if (blockSquares / BLOCK_SAMPLES >= GATE_SQUARE) {
+            gatedSquares += (double)blockSquares / BLOCK_SAMPLES;
+            gatedBlocks++;
+        }
+        blockSquares = 0;
+        blockCount = 0;
+    }
+    return true;
+}
+
+int16_t LoudnessMeter::replayGainCentiDb() const {
+    if (gatedBlocks == 0 || peak == 0) {
+        return 0; // Silent, leave it alone
+    }
+    float rmsDb = 10.0f * log10f((float)(gatedSquares / gatedBlocks) / (32768.0f * 32768.0f));
+    float headroomDb = -20.0f * log10f(peak / 32768.0f);
+    float gain = constrain(REPLAY_GAIN_TARGET_DBFS - rmsDb, -REPLAY_GAIN_MAX_DB, REPLAY_GAIN_MAX_DB);
+    if (gain > headroomDb) {
+        gain = headroomDb; // Never boost the peak past full scale
+    }
+    return (int16_t)lroundf(gain * 100.0f);
+}
+
+#endif
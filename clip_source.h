@@ -0,0 +1,107 @@
+#ifndef CLIP_SOURCE_H
+#define CLIP_SOURCE_H
+
+#include <FS.h>
+#include "AudioFileSource.h"
+
+// AudioFileSource over a clip that is already open. It reads either from a
+// File handle that stays open between plays or from a memory-mapped flash
+// region. Attaching rewinds instead of opening the file again, so starting
+// a clip does not touch the filesystem index or the heap.
+class ClipFileSource : public AudioFileSource {
+private:
+    File *handle;
+    const uint8_t *mapped;
+    uint32_t mappedSize;
+    uint32_t mappedPos;
+
+public:
+    ClipFileSource() : handle(nullptr), mapped(nullptr), mappedSize(0), mappedPos(0) {}
+    bool attach(File *file);
+    bool attach(const uint8_t *data, uint32_t size);
+    virtual uint32_t read(void *data, uint32_t len) override;
+    virtual bool seek(int32_t pos, int dir) override;
+    virtual bool close() override;
+    virtual bool isOpen() override { return mapped != nullptr || (handle != nullptr && *handle); }
+    virtual uint32_t getSize() override;
+    virtual uint32_t getPos() override;
+};
+
+// Implementation
+bool ClipFileSource::attach(File *file) {
+    close();
+    if (!file || !*file || !file->seek(0)) {
+        return false;
+    }
+    handle = file;
+    return true;
+}
+
+bool ClipFileSource::attach(const uint8_t *data, uint32_t size) {
+    close();
+    if (!data || size == 0) {
+        return false;
+    }
+    mapped = data;
+    mappedSize = size;
+    return true;
+}
+
+bool ClipFileSource::close() {
+    handle = nullptr;
+    mapped = nullptr;
+    mappedSize = 0;
+    mappedPos = 0;
+    return true;
+}
+
+uint32_t ClipFileSource::read(void *data, uint32_t len) {
+    if (mapped) {
+        uint32_t left = mappedSize - mappedPos;
+        if (len > left) {
+            len = left;
+        }
+        memcpy(data, mapped + mappedPos, len);
+        mappedPos += len;
+        return len;
+    }
+    if (!isOpen()) {
+        return 0;
+    }
+    return handle->read(reinterpret_cast<uint8_t *>(data), len);
+}
+
+bool ClipFileSource::seek(int32_t pos, int dir) {
+    if (!isOpen()) {
+        return false;
+    }
+    if (dir == SEEK_CUR) {
+        pos += getPos();
+    } else if (dir == SEEK_END) {
+        pos += getSize();
+    }
+    if (mapped) {
+        if (pos < 0 || (uint32_t)pos > mappedSize) {
+            return false;
+        }
+        mappedPos = pos;
+        return true;
+    }
+    return handle->seek(pos);
+}
+
+uint32_t ClipFileSource::getSize() {
+    if (mapped) {
+        return mappedSize;
+    }
+    return isOpen() ? handle->size() : 0;
+}
+
+uint32_t ClipFileSource::getPos() {
+    if (mapped) {
+        return mappedPos;
+    }
+    return isOpen() ? handle->position() : 0;
+}
+
+#endif
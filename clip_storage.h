@@ -0,0 +1,344 @@
+#ifndef CLIP_STORAGE_H
+#define CLIP_STORAGE_H
+
+#include <SPIFFS.h>
+#include <FS.h>
+#include <esp_partition.h>
+#include "clip_index.h"
+#include "clip_source.h"
+#include "config.h"
+#include "pad_topology.h"
+
+// How a clip is stored on flash
+enum ClipFormat : uint8_t {
+    CLIP_NONE,
+    CLIP_MP3,
+    CLIP_ADPCM // Transcoded at upload time, see clip_transcoder.h
+};
+
+// Where the audio task finds clips. Uploads always land on SPIFFS;
+// a backend only decides how playback reaches them. A clip's files may only
+// be replaced or removed while the clip is closed: close() lets go of every
+// handle on it, reopen() picks up whatever is on SPIFFS now. Both run on the
+// audio task, which stops the clip's voices first. Slow work on the new files
+// goes in prepare(), which runs on a background task between the change and
+// reopen(), so reopen() only has to switch over.
+class ClipStorage {
+public:
+    virtual ~ClipStorage() {}
+    virtual const char *getName() const = 0;
+    virtual void close(int clip) = 0;
+    virtual void prepare(int) {}
+    virtual ClipFormat reopen(int clip) = 0;
+    virtual ClipFormat getFormat(int clip) const = 0;
+    virtual bool attach(int clip, ClipFileSource &source) = 0;
+};
+
+// Plays straight from SPIFFS through one handle per clip that stays open
+class SpiffsClipStorage : public ClipStorage {
+private:
+    File clipFiles[Pads::clips];
+    ClipFormat clipFormats[Pads::clips];
+
+public:
+    SpiffsClipStorage();
+    void begin();
+    virtual const char *getName() const override { return "SPIFFS"; }
+    virtual void close(int clip) override;
+    virtual ClipFormat reopen(int clip) override;
+    virtual ClipFormat getFormat(int clip) const override;
+    virtual bool attach(int clip, ClipFileSource &source) override;
+    static ClipFormat resolve(int clip, ClipPath &path);
+};
+
+// Directory table in the first sector of the clip partition
+struct ClipDirEntry {
+    uint32_t offset;
+    uint32_t length;  // 0 when the slot is empty
+    uint8_t format;   // ClipFormat
+    uint8_t reserved[3];
+};
+
+struct ClipDirectory {
+    char magic[4];    // "CLPD"
+    uint16_t version;
+    uint16_t count;
+    ClipDirEntry entries[Pads::clips];
+};
+
+// Mirrors every clip into a fixed slot of a raw data partition and plays it
+// from a memory-mapped view, so a press is a pointer lookup with no
+// filesystem involved. Slots are laid out back to back after the directory
+// sector and each is (partition size - 4KB) / Pads::clips, rounded down to
+// whole sectors. prepare() copies a changed clip into its slot and updates
+// the directory on flash; reopen() then takes the new entry into the one
+// presses read.
+class PartitionClipStorage : public ClipStorage {
+private:
+    const esp_partition_t *partition;
+    const uint8_t *mapped;
+    spi_flash_mmap_handle_t mapHandle;
+    ClipDirectory directory; // What presses read, audio task only
+    ClipDirectory stored;    // As on flash, written by prepare()
+    portMUX_TYPE entryLock = portMUX_INITIALIZER_UNLOCKED; // Guards stored.entries
+    uint32_t slotSize;
+    
+    bool import(int clip);
+    bool writeDirectory();
+
+public:
+    PartitionClipStorage();
+    ~PartitionClipStorage();
+    bool begin();
+    virtual const char *getName() const override { return "partition"; }
+    virtual void close(int clip) override;
+    virtual void prepare(int clip) override;
+    virtual ClipFormat reopen(int clip) override;
+    virtual ClipFormat getFormat(int clip) const override;
+    virtual bool attach(int clip, ClipFileSource &source) override;
+};
+
+// Implementation
+SpiffsClipStorage::SpiffsClipStorage() {
+    for (int i = 0; i < Pads::clips; i++) {
+        clipFormats[i] = CLIP_NONE;
+    }
+}
+
+void SpiffsClipStorage::begin() {
+    for (int i = 1; i <= Pads::clips; i++) {
+        reopen(i);
+    }
+}
+
+ClipFormat SpiffsClipStorage::resolve(int clip, ClipPath &path) {
+    // Prefer the transcoded copy when there is one
+    ClipInfo info = clipIndex.get(clip);
+    if (info.hasAdpcm) {
+        path = Pads::clipPath(clip, ".adp");
+        return CLIP_ADPCM;
+    }
+    if (info.size > 0) {
+        path = Pads::clipPath(clip);
+        return CLIP_MP3;
+    }
+    path.text[0] = '\0';
+    return CLIP_NONE;
+}
+
+void SpiffsClipStorage::close(int clip) {
+    if (!Pads::isClip(clip)) {
+        return;
+    }
+    clipFiles[clip - 1].close();
+    clipFormats[clip - 1] = CLIP_NONE;
+}
+
+ClipFormat SpiffsClipStorage::reopen(int clip) {
+    if (!Pads::isClip(clip)) {
+        return CLIP_NONE;
+    }
+    close(clip);
+    File &file = clipFiles[clip - 1];
+    ClipFormat &format = clipFormats[clip - 1];
+    
+    ClipPath path;
+    format = resolve(clip, path);
+    if (format != CLIP_NONE) {
+        file = SPIFFS.open(path.c_str(), "r");
+    }
+    if (!file) {
+        format = CLIP_NONE;
+    }
+    return format;
+}
+
+ClipFormat SpiffsClipStorage::getFormat(int clip) const {
+    if (!Pads::isClip(clip)) {
+        return CLIP_NONE;
+    }
+    return clipFormats[clip - 1];
+}
+
+bool SpiffsClipStorage::attach(int clip, ClipFileSource &source) {
+    if (getFormat(clip) == CLIP_NONE) {
+        return false;
+    }
+    return source.attach(&clipFiles[clip - 1]);
+}
+
+PartitionClipStorage::PartitionClipStorage() {
+    partition = nullptr;
+    mapped = nullptr;
+    mapHandle = 0;
+    slotSize = 0;
+    memset(&directory, 0, sizeof(directory));
+    memset(&stored, 0, sizeof(stored));
+}
+
+PartitionClipStorage::~PartitionClipStorage() {
+    if (mapped) {
+        spi_flash_munmap(mapHandle);
+        mapped = nullptr;
+    }
+}
+
+bool PartitionClipStorage::begin() {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)CLIP_PARTITION_SUBTYPE,
+                                         CLIP_PARTITION_LABEL);
+    if (!partition) {
+        Serial.printf("Clip partition '%s' not found\n", CLIP_PARTITION_LABEL);
+        return false;
+    }
+    slotSize = ((partition->size - SPI_FLASH_SEC_SIZE) / Pads::clips) & ~(SPI_FLASH_SEC_SIZE - 1);
+    
+    // Map once; the flash driver keeps the cache coherent with later writes
+    const void *ptr = nullptr;
+    if (esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &ptr, &mapHandle) != ESP_OK) {
+        Serial.println("Failed to map clip partition");
+        partition = nullptr;
+        return false;
+    }
+    mapped = static_cast<const uint8_t *>(ptr);
+    memcpy(&stored, mapped, sizeof(stored));
+    
+    bool valid = memcmp(stored.magic, "CLPD", 4) == 0 && stored.version == 2 && stored.count == Pads::clips;
+    if (!valid) {
+        Serial.println("Clip partition has no directory, formatting");
+        memset(&stored, 0, sizeof(stored));
+        memcpy(stored.magic, "CLPD", 4);
+        stored.version = 2;
+        stored.count = Pads::clips;
+        writeDirectory();
+    }
+    
+    // Bring the mirror in line with SPIFFS, e.g. after an upload that lost power before its import
+    for (int i = 1; i <= Pads::clips; i++) {
+        ClipPath path;
+        ClipFormat format = SpiffsClipStorage::resolve(i, path);
+        const ClipDirEntry &entry = stored.entries[i - 1];
+        uint32_t length = 0;
+        if (format != CLIP_NONE) {
+            File clip = SPIFFS.open(path.c_str(), "r");
+            length = clip ? clip.size() : 0;
+            clip.close();
+        }
+        if (entry.format != format || entry.length != length) {
+            import(i);
+        }
+    }
+    memcpy(&directory, &stored, sizeof(directory)); // Nothing plays yet
+    
+    Serial.printf("Clip partition: %u bytes, %u byte slots\n", partition->size, slotSize);
+    return true;
+}
+
+bool PartitionClipStorage::writeDirectory() {
+    if (esp_partition_erase_range(partition, 0, SPI_FLASH_SEC_SIZE) != ESP_OK) {
+        return false;
+    }
+    return esp_partition_write(partition, 0, &stored, sizeof(stored)) == ESP_OK;
+}
+
+// Runs at boot and on the clip preparation task, never on the audio task
+bool PartitionClipStorage::import(int clip) {
+    ClipDirEntry &entry = stored.entries[clip - 1];
+    portENTER_CRITICAL(&entryLock);
+    entry.offset = SPI_FLASH_SEC_SIZE + (clip - 1) * slotSize;
+    entry.length = 0;
+    entry.format = CLIP_NONE;
+    portEXIT_CRITICAL(&entryLock);
+    
+    ClipPath path;
+    ClipFormat format = SpiffsClipStorage::resolve(clip, path);
+    if (format == CLIP_NONE) {
+        return writeDirectory();
+    }
+    
+    File file = SPIFFS.open(path.c_str(), "r");
+    if (!file) {
+        return writeDirectory();
+    }
+    uint32_t length = file.size();
+    if (length > slotSize) {
+        Serial.printf("Clip %s (%u bytes) does not fit its %u byte slot\n", path.c_str(), length, slotSize);
+        file.close();
+        writeDirectory();
+        return false;
+    }
+    
+    // Empty the slot in the directory first so a power cut mid-copy cannot leave a half-written clip
+    unsigned long started = millis();
+    bool ok = writeDirectory();
+    uint32_t eraseLength = (length + SPI_FLASH_SEC_SIZE - 1) & ~(SPI_FLASH_SEC_SIZE - 1);
+    ok = ok && esp_partition_erase_range(partition, entry.offset, eraseLength) == ESP_OK;
+    
+    uint8_t *buffer = (uint8_t *)malloc(SPI_FLASH_SEC_SIZE);
+    uint32_t copied = 0;
+    while (ok && buffer && copied < length) {
+        size_t n = file.read(buffer, SPI_FLASH_SEC_SIZE);
+        if (n == 0) {
+            break;
+        }
+        ok = esp_partition_write(partition, entry.offset + copied, buffer, n) == ESP_OK;
+        copied += n;
+    }
+    free(buffer);
+    file.close();
+    
+    if (!ok || copied != length) {
+        Serial.printf("Failed to import %s into partition\n", path.c_str());
+        return false;
+    }
+    portENTER_CRITICAL(&entryLock);
+    entry.length = length;
+    entry.format = format;
+    portEXIT_CRITICAL(&entryLock);
+    ok = writeDirectory();
+    Serial.printf("Imported %s into partition in %lu ms\n", path.c_str(), millis() - started);
+    return ok;
+}
+
+// The slot keeps its copy until prepare() imports the new one, but nothing
+// may play from it meanwhile as the import erases it
+void PartitionClipStorage::close(int clip) {
+    if (!Pads::isClip(clip) || !partition) {
+        return;
+    }
+    directory.entries[clip - 1].length = 0;
+}
+
+void PartitionClipStorage::prepare(int clip) {
+    if (!Pads::isClip(clip) || !partition) {
+        return;
+    }
+    import(clip);
+}
+
+ClipFormat PartitionClipStorage::reopen(int clip) {
+    if (!Pads::isClip(clip) || !partition) {
+        return CLIP_NONE;
+    }
+    portENTER_CRITICAL(&entryLock);
+    directory.entries[clip - 1] = stored.entries[clip - 1];
+    portEXIT_CRITICAL(&entryLock);
+    return getFormat(clip);
+}
+
+ClipFormat PartitionClipStorage::getFormat(int clip) const {
+    if (!Pads::isClip(clip) || !partition) {
+        return CLIP_NONE;
+    }
+    const ClipDirEntry &entry = directory.entries[clip - 1];
+    return entry.length > 0 ? (ClipFormat)entry.format : CLIP_NONE;
+}
+
+bool PartitionClipStorage::attach(int clip, ClipFileSource &source) {
+    if (getFormat(clip) == CLIP_NONE) {
+        return false;
+    }
+    const ClipDirEntry &entry = directory.entries[clip - 1];
+    return source.attach(mapped + entry.offset, entry.length);
+}
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef CLIP_TRANSCODER_H
+#define CLIP_TRANSCODER_H
+
+#include <SPIFFS.h>
+#include <FS.h>
+#include "AudioFileSourceSPIFFS.h"
+#include "AudioFileSourceID3.h"
+#include "AudioGeneratorMP3.h"
+#include "AudioOutput.h"
+#include "ima_adpcm.h"
+#include "config.h"
+
+// AudioOutput that downmixes decoded audio to mono and writes it as IMA-ADPCM blocks
+class AdpcmEncodeOutput : public AudioOutput {
+private:
+    File *out;
+    AdpcmState state;
+    int16_t pcm[ADPCM_BLOCK_SAMPLES];
+    uint8_t block[ADPCM_BLOCK_BYTES];
+    size_t pcmCount;
+    uint32_t totalSamples;
+    bool failed;
+    
+    void flushBlock();
+
+public:
+    AdpcmEncodeOutput(File *file);
+    virtual bool begin() override { return true; }
+    virtual bool ConsumeSample(int16_t sample[2]) override;
+    virtual bool stop() override { return true; }
+    bool finish();
+    uint32_t getTotalSamples() const { return totalSamples; }
+    int getRate() const { return hertz; }
+    bool hasFailed() const { return failed; }
+};
+
+// Converts an uploaded MP3 into a fast-start ADPCM companion file (.adp)
+class ClipTranscoder {
+public:
+    static String adpcmPathFor(const String &mp3Path);
+    static bool transcode(const String &mp3Path);
+};
+
+// Implementation
+AdpcmEncodeOutput::AdpcmEncodeOutput(File *file) {
+    out = file;
+    state.predictor = 0;
+    state.index = 0;
+    pcmCount = 0;
+    totalSamples = 0;
+    failed = false;
+    hertz = 44100;
+    bps = 16;
+    channels = 2;
+}
+
+bool AdpcmEncodeOutput::ConsumeSample(int16_t sample[2]) {
+    if (failed) {
+        return false;
+    }
+    int16_t frame[2] = {sample[0], sample[1]};
+    MakeSampleStereo16(frame);
+    pcm[pcmCount++] = (int16_t)(((int32_t)frame[0] + frame[1]) / 2);
+    totalSamples++;
+    if (pcmCount == ADPCM_BLOCK_SAMPLES) {
+        flushBlock();
+    }
+    return true;
+}
+
+void AdpcmEncodeOutput::flushBlock() {
+    size_t bytes = adpcmEncodeBlock(pcm, pcmCount, block, state);
+    if (out->write(block, bytes) != bytes) {
+        failed = true;
+    }
+    pcmCount = 0;
+}
+
+bool AdpcmEncodeOutput::finish() {
+    if (pcmCount > 0) {
+        flushBlock();
+    }
+    return !failed;
+}
+
+String ClipTranscoder::adpcmPathFor(const String &mp3Path) {
+    // "/audio/buttonN.mp3" -> "/audio/buttonN.adp"
+    return mp3Path.substring(0, mp3Path.length() - 4) + ".adp";
+}
+
+bool ClipTranscoder::transcode(const String &mp3Path) {
+    String finalPath = adpcmPathFor(mp3Path);
+    String tempPath = finalPath + ".tmp";
+    unsigned long started = millis();
+    
+    File adp = SPIFFS.open(tempPath, "w");
+    if (!adp) {
+        Serial.printf("Transcode: cannot create %s\n", tempPath.c_str());
+        return false;
+    }
+    
+    // Header is rewritten with the real values once the length is known
+    AdpcmFileHeader header = {{'I', 'M', 'A', 'D'}, 1, 1, (uint16_t)ADPCM_BLOCK_BYTES, 0, 0};
+    adp.write((const uint8_t *)&header, sizeof(header));
+    
+    AudioFileSourceSPIFFS source(mp3Path.c_str());
+    AudioFileSourceID3 id3(&source);
+    AudioGeneratorMP3 *decoder = new AudioGeneratorMP3();
+    AdpcmEncodeOutput encoder(&adp);
+    
+    bool ok = decoder->begin(&id3, &encoder);
+    if (ok) {
+        while (decoder->loop()) {
+            if (encoder.hasFailed()) {
+                break;
+            }
+        }
+        decoder->stop();
+        ok = encoder.finish() && encoder.getTotalSamples() > 0;
+    }
+    delete decoder;
+    
+    if (ok) {
+        header.sampleRate = encoder.getRate();
+        header.totalSamples = encoder.getTotalSamples();
+        ok = adp.seek(0) && adp.write((const uint8_t *)&header, sizeof(header)) == sizeof(header);
+    }
+    adp.close();
+    
+    if (!ok) {
+        Serial.printf("Transcode failed: %s\n", mp3Path.c_str());
+        SPIFFS.remove(tempPath);
+        return false;
+    }
+    
+    if (SPIFFS.exists(finalPath)) {
+        SPIFFS.remove(finalPath);
+    }
+    if (!SPIFFS.rename(tempPath, finalPath)) {
+        SPIFFS.remove(tempPath);
+        return false;
+    }
+    
+    Serial.printf("Transcoded %s: %u samples @ %u Hz in %lu ms\n", finalPath.c_str(), header.totalSamples,
+                  header.sampleRate, millis() - started);
+    return true;
+}
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef CLOCK_MODEL_H
+#define CLOCK_MODEL_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Estimates how a local microsecond clock relates to a shared one from
+// NTP-style exchanges. Keeps the last WINDOW offset measurements and fits
+// offset = a + b * (local - centre) through them, trusting most the ones whose
+// round trip came closest to the fastest seen.
+// b is the drift between the clocks. No Arduino dependencies.
+
+// The fitted line on its own, small enough to copy between tasks
+struct ClockFit {
+    double centre;    // Local time the fit is centred on
+    double intercept; // Offset at centre
+    double slope;     // Drift, shared minus local per local microsecond
+    
+    int64_t toShared(int64_t local) const;
+    int64_t toLocal(int64_t shared) const;
+    // Mixer rate trim (AudioMixer::setTrimPpm) that keeps local playback in
+    // pace with the shared clock, limited to +-limit
+    int32_t trimPpm(int32_t limit) const;
+};
+
+template<size_t WINDOW>
+class ClockModel {
+private:
+    struct Sample {
+        int64_t local;
+        int64_t offset;
+        int64_t rtt;
+    };
+    Sample samples[WINDOW];
+    size_t count;
+    size_t next;
+    ClockFit line;
+    int64_t lastRtt;
+    
+    void fit();
+
+public:
+    ClockModel() { reset(); }
+    void reset();
+    
+    // t1 local send, t2 remote receive, t3 remote send, t4 local receive
+    void addExchange(int64_t t1, int64_t t2, int64_t t3, int64_t t4);
+    
+    bool isValid() const { return count > 0; }
+    const ClockFit &getFit() const { return line; }
+    int64_t toShared(int64_t local) const { return line.toShared(local); }
+    int64_t toLocal(int64_t shared) const { return line.toLocal(shared); }
+    double getDriftPpm() const { return line.slope * 1e6; }
+    int64_t getLastRtt() const { return lastRtt; }
+};
+
+// Implementation
+inline int64_t ClockFit::toShared(int64_t local) const {
+    return local + (int64_t)(intercept + slope * ((double)local - centre));
+}
+
+inline int64_t ClockFit::toLocal(int64_t shared) const {
+    // Solve shared = local + intercept + slope * (local - centre) for local
+    return (int64_t)(((double)shared - intercept + slope * centre) / (1.0 + slope));
+}
+
+inline int32_t ClockFit::trimPpm(int32_t limit) const {
+    // A fast local crystal plays clips fast too: repeat frames to slow down
+    int32_t ppm = (int32_t)lround(slope * 1e6);
+    return ppm < -limit ? -limit : ppm > limit ? limit : ppm;
+}
+
+template<size_t WINDOW>
+void ClockModel<WINDOW>::reset() {
+    count = 0;
+    next = 0;
+    line.centre = 0.0;
+    line.intercept = 0.0;
+    line.slope = 0.0;
+    lastRtt = 0;
+}
+
+template<size_t WINDOW>
+void ClockModel<WINDOW>::addExchange(int64_t t1, int64_t t2, int64_t t3, int64_t t4) {
+    int64_t rtt = (t4 - t1) - (t3 - t2);
+    if (rtt < 0) {
+        return;
+    }
+    Sample &s = samples[next];
+    s.local = t1 + (t4 - t1) / 2;
+    s.offset = ((t2 - t1) + (t3 - t4)) / 2;
+    s.rtt = rtt;
+    lastRtt = rtt;
+    next = (next + 1) % WINDOW;
+    if (count < WINDOW) {
+        count++;
+    }
+    fit();
+}
+
+template<size_t WINDOW>
+void ClockModel<WINDOW>::fit() {
+    int64_t bestRtt = samples[0].rtt;
+    for (size_t i = 1; i < count; i++) {
+        if (samples[i].rtt < bestRtt) {
+            bestRtt = samples[i].rtt;
+        }
+    }
+    
+    // Weight each sample by how close its round trip came to the best one:
+    // queueing delay in either direction skews the offset by up to half of it
+    size_t newest = (next + WINDOW - 1) % WINDOW;
+    double base = (double)samples[newest].local; // Keeps the sums well conditioned
+    double n = 0.0, sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        double excess = (double)(samples[i].rtt - bestRtt) / 100.0;
+        double w = 1.0 / (1.0 + excess * excess);
+        double x = (double)samples[i].local - base;
+        double y = (double)samples[i].offset;
+        n += w;
+        sx += w * x;
+        sy += w * y;
+        sxx += w * x * x;
+        sxy += w * x * y;
+    }
+    
+    double meanX = sx / n;
+    double meanY = sy / n;
+    double varX = sxx - sx * meanX;
+    line.centre = base + meanX;
+    line.intercept = meanY;
+    // A short window spanning too little time cannot tell drift from jitter
+    line.slope = (count >= 3 && varX > 1e12) ? (sxy - sx * meanY) / varX : 0.0;
+}
+
+#endif
@@ -0,0 +1,358 @@
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <lwip/sockets.h>
+#include <esp_timer.h>
+#include "config.h"
+#include "clock_model.h"
+#include "udp_trigger.h"
+
+// Keeps several Audiopads on one clock so a press plays everywhere at once.
+// The leader's esp_timer is the shared clock. Followers send it a request every
+// CLOCK_SYNC_INTERVAL_MS and fit offset and drift from the four timestamps of
+// each exchange (clock_model.h); the drift also trims the mixer so long clips
+// stay aligned. A press is broadcast as "play button at shared time T", every
+// device converts T to its own micros() and schedules the clip.
+//
+// All packets share one layout, little-endian, followed by the same HMAC tag as
+// the trigger protocol when UDP_TRIGGER_KEY is defined:
+//   "AS", version 1, type, uint32 sender, uint32 sequence, uint8 button,
+//   uint8 reserved, uint16 gain in thousandths, int64 t1, t2, t3 in microseconds
+// A request carries t1 (follower send), the response adds t2 (leader receive)
+// and t3 (leader send). A play message carries the shared start time in t1.
+
+enum SyncType : uint8_t {
+    SYNC_REQUEST = 1,
+    SYNC_RESPONSE = 2,
+    SYNC_PLAY = 3
+};
+
+struct __attribute__((packed)) SyncPacket {
+    char magic[2];     // "AS"
+    uint8_t version;
+    uint8_t type;
+    uint32_t sender;   // Random per boot, lets a device skip its own broadcasts
+    uint32_t sequence;
+    uint8_t button;
+    uint8_t reserved;
+    uint16_t gain;
+    int64_t t1;
+    int64_t t2;
+    int64_t t3;
+};
+
+class ClockSync {
+private:
+    int sock;
+    TaskHandle_t taskHandle;
+    bool leader;
+    sockaddr_in leaderAddr;
+    uint32_t senderId;
+    
+    // Sync task only
+    ClockModel<CLOCK_SYNC_WINDOW> model;
+    uint32_t requestSequence;
+    int64_t requestSentAt;
+    int64_t lastRequestAt;
+    int32_t trimPpm;
+    uint32_t lastPlaySender;
+    uint32_t lastPlaySequence;
+    
+    // Shared with callers of sharedNow() and playEverywhere()
+    portMUX_TYPE fitLock = portMUX_INITIALIZER_UNLOCKED;
+    ClockFit fit;
+    volatile bool haveFit;
+    volatile int64_t lastExchangeAt;
+    uint32_t playSequence;
+    
+    // Run on the sync task
+    void (*onPlay)(int buttonNum, unsigned long atMicros, float gain) = nullptr;
+    void (*onTrim)(int32_t ppm) = nullptr;
+    
+    static void taskEntry(void *arg);
+    void sendRequest();
+    void handlePacket(const uint8_t *data, size_t length, int64_t receivedAt, const sockaddr_in &from);
+    void handleResponse(const SyncPacket &packet, int64_t receivedAt);
+    void handlePlay(const SyncPacket &packet);
+    void fillHeader(SyncPacket &packet, SyncType type, uint32_t sequence) const;
+    void sendPacket(SyncPacket &packet, const sockaddr_in &to);
+    ClockFit currentFit();
+
+public:
+    ClockSync();
+    ~ClockSync();
+    bool begin();
+    void setPlayCallback(void (*callback)(int, unsigned long, float));
+    void setTrimCallback(void (*callback)(int32_t));
+    
+    bool isLeader() const { return leader; }
+    bool isSynced() const;
+    int64_t sharedNow();
+    
+    // Broadcasts a press to the group and returns the micros() time it should
+    // sound here, SYNC_PLAY_DELAY_MS from now. Call from one task only.
+    unsigned long playEverywhere(int buttonNum, float gain);
+    
+    double getDriftPpm() const { return model.getDriftPpm(); }
+    int64_t getLastRtt() const { return model.getLastRtt(); }
+};
+
+// Implementation
+ClockSync::ClockSync() {
+    sock = -1;
+    taskHandle = nullptr;
+    leader = true;
+    memset(&leaderAddr, 0, sizeof(leaderAddr));
+    senderId = 0;
+    requestSequence = 0;
+    requestSentAt = 0;
+    lastRequestAt = 0;
+    trimPpm = 0;
+    lastPlaySender = 0;
+    lastPlaySequence = 0;
+    fit = model.getFit();
+    haveFit = false;
+    lastExchangeAt = 0;
+    playSequence = 0;
+}
+
+ClockSync::~ClockSync() {
+    if (taskHandle) {
+        vTaskDelete(taskHandle);
+        taskHandle = nullptr;
+    }
+    if (sock >= 0) {
+        closesocket(sock);
+        sock = -1;
+    }
+}
+
+bool ClockSync::begin() {
+    leader = CLOCK_SYNC_LEADER[0] == '\0';
+    if (!leader) {
+        leaderAddr.sin_family = AF_INET;
+        leaderAddr.sin_port = htons(CLOCK_SYNC_PORT);
+        leaderAddr.sin_addr.s_addr = inet_addr(CLOCK_SYNC_LEADER);
+        if (leaderAddr.sin_addr.s_addr == INADDR_NONE) {
+            Serial.printf("Clock sync: bad leader address %s\n", CLOCK_SYNC_LEADER);
+            return false;
+        }
+    }
+    senderId = esp_random();
+    playSequence = (uint32_t)(esp_timer_get_time() / 1000);
+    
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        Serial.println("Clock sync: failed to create socket");
+        return false;
+    }
+    int enable = 1;
+    setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &enable, sizeof(enable));
+    // Wake up regularly so followers can send their requests
+    timeval timeout = {0, 100000};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(CLOCK_SYNC_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (sockaddr *)&addr, sizeof(addr)) < 0) {
+        Serial.printf("Clock sync: failed to bind port %u\n", CLOCK_SYNC_PORT);
+        closesocket(sock);
+        sock = -1;
+        return false;
+    }
+    
+    if (xTaskCreatePinnedToCore(taskEntry, "clocksync", CLOCK_SYNC_TASK_STACK_SIZE, this,
+                                CLOCK_SYNC_TASK_PRIORITY, &taskHandle, CLOCK_SYNC_TASK_CORE) != pdPASS) {
+        Serial.println("Clock sync: failed to start task");
+        taskHandle = nullptr;
+        closesocket(sock);
+        sock = -1;
+        return false;
+    }
+    
+    if (leader) {
+        Serial.printf("Clock sync: leading on port %u\n", CLOCK_SYNC_PORT);
+    } else {
+        Serial.printf("Clock sync: following %s on port %u\n", CLOCK_SYNC_LEADER, CLOCK_SYNC_PORT);
+    }
+    return true;
+}
+
+void ClockSync::setPlayCallback(void (*callback)(int, unsigned long, float)) {
+    onPlay = callback;
+}
+
+void ClockSync::setTrimCallback(void (*callback)(int32_t)) {
+    onTrim = callback;
+}
+
+bool ClockSync::isSynced() const {
+    if (leader) {
+        return sock >= 0;
+    }
+    return haveFit && esp_timer_get_time() - lastExchangeAt < (int64_t)CLOCK_SYNC_TIMEOUT_MS * 1000;
+}
+
+ClockFit ClockSync::currentFit() {
+    portENTER_CRITICAL(&fitLock);
+    ClockFit copy = fit;
+    portEXIT_CRITICAL(&fitLock);
+    return copy;
+}
+
+int64_t ClockSync::sharedNow() {
+    int64_t now = esp_timer_get_time();
+    return leader ? now : currentFit().toShared(now);
+}
+
+unsigned long ClockSync::playEverywhere(int buttonNum, float gain) {
+    int64_t localStart = esp_timer_get_time() + (int64_t)SYNC_PLAY_DELAY_MS * 1000;
+    
+    SyncPacket packet;
+    fillHeader(packet, SYNC_PLAY, ++playSequence);
+    packet.button = buttonNum;
+    packet.gain = (uint16_t)(constrain(gain, 0.0f, 1.0f) * 1000.0f + 0.5f);
+    packet.t1 = leader ? localStart : currentFit().toShared(localStart);
+    
+    sockaddr_in group;
+    memset(&group, 0, sizeof(group));
+    group.sin_family = AF_INET;
+    group.sin_port = htons(CLOCK_SYNC_PORT);
+    group.sin_addr.s_addr = htonl(INADDR_BROADCAST);
+    sendPacket(packet, group);
+    
+    // micros() is the low 32 bits of esp_timer
+    return (unsigned long)localStart;
+}
+
+void ClockSync::fillHeader(SyncPacket &packet, SyncType type, uint32_t sequence) const {
+    memset(&packet, 0, sizeof(packet));
+    packet.magic[0] = 'A';
+    packet.magic[1] = 'S';
+    packet.version = 1;
+    packet.type = type;
+    packet.sender = senderId;
+    packet.sequence = sequence;
+}
+
+void ClockSync::sendPacket(SyncPacket &packet, const sockaddr_in &to) {
+    uint8_t data[sizeof(SyncPacket) + UDP_HMAC_BYTES];
+    memcpy(data, &packet, sizeof(packet));
+    UdpTrigger::appendTag(data, sizeof(packet));
+    sendto(sock, data, sizeof(packet) + UdpTrigger::tagBytes(), 0, (const sockaddr *)&to, sizeof(to));
+}
+
+void ClockSync::taskEntry(void *arg) {
+    ClockSync *self = static_cast<ClockSync *>(arg);
+    uint8_t data[sizeof(SyncPacket) + UDP_HMAC_BYTES];
+    for (;;) {
+        if (!self->leader &&
+            esp_timer_get_time() - self->lastRequestAt >= (int64_t)CLOCK_SYNC_INTERVAL_MS * 1000) {
+            self->sendRequest();
+        }
+        
+        sockaddr_in from;
+        socklen_t fromLength = sizeof(from);
+        int length = recvfrom(self->sock, data, sizeof(data), 0, (sockaddr *)&from, &fromLength);
+        // Stamp the arrival before anything else so parsing time is not counted as path delay
+        int64_t receivedAt = esp_timer_get_time();
+        if (length > 0) {
+            self->handlePacket(data, length, receivedAt, from);
+        }
+    }
+}
+
+void ClockSync::sendRequest() {
+    SyncPacket packet;
+    fillHeader(packet, SYNC_REQUEST, ++requestSequence);
+    lastRequestAt = esp_timer_get_time();
+    requestSentAt = lastRequestAt;
+    packet.t1 = requestSentAt;
+    sendPacket(packet, leaderAddr);
+}
+
+void ClockSync::handlePacket(const uint8_t *data, size_t length, int64_t receivedAt, const sockaddr_in &from) {
+    SyncPacket packet;
+    if (length != sizeof(packet) + UdpTrigger::tagBytes()) {
+        return;
+    }
+    memcpy(&packet, data, sizeof(packet));
+    if (packet.magic[0] != 'A' || packet.magic[1] != 'S' || packet.version != 1 ||
+        packet.sender == senderId || !UdpTrigger::verifyTag(data, sizeof(packet))) {
+        return;
+    }
+    
+    switch (packet.type) {
+        case SYNC_REQUEST:
+            if (leader) {
+                packet.type = SYNC_RESPONSE;
+                packet.sender = senderId;
+                packet.t2 = receivedAt;
+                packet.t3 = esp_timer_get_time();
+                sendPacket(packet, from);
+            }
+            break;
+        case SYNC_RESPONSE:
+            if (!leader) {
+                handleResponse(packet, receivedAt);
+            }
+            break;
+        case SYNC_PLAY:
+            handlePlay(packet);
+            break;
+    }
+}
+
+void ClockSync::handleResponse(const SyncPacket &packet, int64_t receivedAt) {
+    // Only the answer to the latest request, anything else is late or forged
+    if (packet.sequence != requestSequence || packet.t1 != requestSentAt) {
+        return;
+    }
+    model.addExchange(packet.t1, packet.t2, packet.t3, receivedAt);
+    
+    ClockFit latest = model.getFit();
+    portENTER_CRITICAL(&fitLock);
+    fit = latest;
+    portEXIT_CRITICAL(&fitLock);
+    if (!haveFit) {
+        Serial.printf("Clock sync: locked to leader, round trip %lld us\n", (long long)model.getLastRtt());
+    }
+    haveFit = true;
+    lastExchangeAt = receivedAt;
+    
+    int32_t ppm = latest.trimPpm(CLOCK_SYNC_MAX_TRIM_PPM);
+    if (ppm != trimPpm) {
+        trimPpm = ppm;
+        if (onTrim != nullptr) {
+            onTrim(trimPpm);
+        }
+    }
+}
+
+void ClockSync::handlePlay(const SyncPacket &packet) {
+    if (packet.sender == lastPlaySender && (int32_t)(packet.sequence - lastPlaySequence) <= 0) {
+        return;
+    }
+    lastPlaySender = packet.sender;
+    lastPlaySequence = packet.sequence;
+    
+    int64_t now = esp_timer_get_time();
+    int64_t localStart = now;
+    if (isSynced()) {
+        localStart = leader ? packet.t1 : currentFit().toLocal(packet.t1);
+        // Stale (or replayed) presses are dropped rather than played out of step
+        int64_t ahead = localStart - now;
+        if (ahead < -(int64_t)SYNC_PLAY_DELAY_MS * 1000 || ahead > (int64_t)SCHEDULE_MAX_OFFSET_MS * 1000) {
+            Serial.printf("Clock sync: dropped play for button %u, %lld us off\n", packet.button, (long long)ahead);
+            return;
+        }
+    }
+    if (onPlay != nullptr) {
+        onPlay(packet.button, (unsigned long)localStart, packet.gain / 1000.0f);
+    }
+}
+
+#endif
@@ -1,8 +1,12 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
-// Hardware pin definitions
-const int BUTTON_PINS[] = {13, 14, 27, 26, 25, 32};
+// Hardware pin definitions. BUTTON_PINS lists one GPIO per button in button
+// order; the button count, clip names and every per-button table follow from
+// it (see pad_topology.h), so a 12- or 16-pad build only edits this list.
+constexpr int BUTTON_PINS[] = {13, 14, 27, 26, 25, 32};
+constexpr int NUM_BUTTONS = sizeof(BUTTON_PINS) / sizeof(BUTTON_PINS[0]);
+constexpr int MAX_CLIPS_PER_BUTTON = 4; // Clip files per button: buttonN.mp3, buttonN_2.mp3, ...
 const int BATTERY_PIN = 35;
 
 // Battery voltage conversion
@@ -11,14 +15,78 @@ const float ADC_TO_VOLT = 7.285f / 4096.0f;
 // File size limit (in bytes)
 const size_t MAX_FILE_SIZE = 500000; // 500KB per file
 
-// Button debouncing
+// Upload write-behind: the web handler fills buffers of this size from a pool
+// that a background flash-writer task empties. The handler never waits for a
+// buffer; an upload that outruns the writer is refused with 503 and a
+// Retry-After of UPLOAD_RETRY_AFTER_S seconds.
+const size_t UPLOAD_BUFFER_SIZE = 4096;
+const int UPLOAD_BUFFER_COUNT = 4;
+const unsigned long UPLOAD_RETRY_AFTER_S = 2;
+const int UPLOAD_TASK_CORE = 1;
+const int UPLOAD_TASK_PRIORITY = 2;
+const uint32_t UPLOAD_TASK_STACK_SIZE = 4096;
+// Transcodes new uploads to ADPCM, below the flash writer so it never holds up an upload
+const int INGEST_TASK_PRIORITY = 1;
+const uint32_t INGEST_TASK_STACK_SIZE = 8192; // Runs the MP3 decoder
+
+// Web server: requests in flight at once. Each holds a TCP connection and its
+// buffers; further requests get 503 until one finishes.
+const int WEB_MAX_CONNECTIONS = 4;
+const int WEB_MAX_EVENT_CLIENTS = 2;               // Open /events streams (browser tabs)
+const unsigned long EVENT_STATUS_INTERVAL_MS = 50; // How often playback state is checked for changes
+// Largest API reply body: the file list, up to 112 bytes per clip
+constexpr size_t WEB_RESPONSE_BYTES = 48 + NUM_BUTTONS * MAX_CLIPS_PER_BUTTON * 112;
+
+// WiFi connection (see wifi_manager.h). Attempts that have not connected
+// after the timeout are retried with a backoff that doubles from
+// WIFI_BACKOFF_MIN_MS to WIFI_BACKOFF_MAX_MS. After WIFI_AP_FALLBACK_FAILURES
+// failed attempts the device also opens the access point WIFI_AP_SSID, if
+// WIFI_AP_PASSWORD is defined in secrets.h.
+const unsigned long WIFI_CONNECT_TIMEOUT_MS = 15000;
+const unsigned long WIFI_FAST_CONNECT_TIMEOUT_MS = 3000; // With the channel, BSSID and IP cached before deep sleep
+const unsigned long WIFI_BACKOFF_MIN_MS = 1000;
+const unsigned long WIFI_BACKOFF_MAX_MS = 60000;
+const uint32_t WIFI_AP_FALLBACK_FAILURES = 3;
+const char *const WIFI_AP_SSID = "ESP32-Audiopad";
+
+// UDP trigger protocol (see udp_trigger.h). Define UDP_TRIGGER_KEY in
+// secrets.h to require HMAC-signed packets.
+const bool UDP_TRIGGER_ENABLED = true;
+const uint16_t UDP_TRIGGER_PORT = 5005;
+const uint8_t UDP_MAX_BATCH = 8;  // Commands per packet
+const size_t UDP_MAX_SOURCES = 8; // Senders whose sequence numbers are tracked
+const int UDP_TASK_CORE = 1;
+const int UDP_TASK_PRIORITY = 4;
+const uint32_t UDP_TASK_STACK_SIZE = 4096;
+
+// Convert each uploaded MP3 once into IMA-ADPCM (buttonN.adp, mono, ~4:1 vs
+// 16-bit PCM). Clips with an .adp companion play through a trivial decoder
+// instead of the MP3 decoder, which starts faster and costs far less CPU.
+const bool TRANSCODE_UPLOADS_ENABLED = false;
+
+// Button debouncing. Presses are reported on the first edge; further edges
+// within DEBOUNCE_DELAY are treated as contact bounce.
 const unsigned long DEBOUNCE_DELAY = 50;
+const size_t BUTTON_EDGE_QUEUE_SIZE = 64;       // Must be a power of two
+const unsigned long BUTTON_SETTLE_POLL_MS = 5;  // Re-check interval while a bounce settles
+const int BUTTON_TASK_CORE = 1;
+const int BUTTON_TASK_PRIORITY = 6;
+const uint32_t BUTTON_TASK_STACK_SIZE = 4096;
 
 // Audio gain settings (0.0 to 1.0)
 const float DEFAULT_AUDIO_GAIN = 0.5;
 const float MIN_AUDIO_GAIN = 0.0;
 const float MAX_AUDIO_GAIN = 1.0;
 
+// PCM prefix cache: decode the first PCM_PREFIX_MS of each clip into RAM/PSRAM
+// so a press can start sounding before the MP3 decoder is ready. Build with
+// -DPCM_PREFIX_CACHE_ENABLED=1 or change the default here to turn it on.
+#ifndef PCM_PREFIX_CACHE_ENABLED
+#define PCM_PREFIX_CACHE_ENABLED 0
+#endif
+const unsigned long PCM_PREFIX_MS = 100;
+const size_t PCM_CACHE_BUDGET_BYTES = 128000; // Shared by all clips
+
 // I2S audio pins
 const int I2S_BCLK_PIN = 4;
 const int I2S_LRC_PIN = 2;
@@ -27,12 +95,138 @@ const int I2S_DIN_PIN = 15;
 // Battery update interval (milliseconds)
 const unsigned long BATTERY_UPDATE_INTERVAL = 10000;
 
-// Number of buttons
-const int NUM_BUTTONS = 6;
+// Battery sampler (see battery_monitor.h). Every BATTERY_SAMPLE_INTERVAL_MS
+// the ADC is read BATTERY_OVERSAMPLE times and averaged. Readings pass a
+// median of BATTERY_MEDIAN_WINDOW and a low-pass in which each new one weighs
+// BATTERY_FILTER_ALPHA. While a clip plays, the amplifier draws about
+// BATTERY_PLAYBACK_AMPS through the cell's BATTERY_INTERNAL_OHMS; that drop is
+// added back so the level does not dip with every press.
+const unsigned long BATTERY_SAMPLE_INTERVAL_MS = 250;
+const int BATTERY_OVERSAMPLE = 16;
+const size_t BATTERY_MEDIAN_WINDOW = 5;
+const float BATTERY_FILTER_ALPHA = 0.05f; // About 5 s to settle at 4 samples a second
+const float BATTERY_PLAYBACK_AMPS = 0.5f;
+const float BATTERY_INTERNAL_OHMS = 0.15f;
+const int BATTERY_TASK_CORE = 1;
+const int BATTERY_TASK_PRIORITY = 1;
+const uint32_t BATTERY_TASK_STACK_SIZE = 3072;
+
+// Polyphonic mixer. Every playing MP3 voice holds its own decoder (~30KB of
+// heap), so lower MAX_VOICES on boards without PSRAM if starts begin to fail.
+constexpr int MAX_VOICES = NUM_BUTTONS;
+const uint32_t VOICE_BUFFER_FRAMES = 512;  // Per-voice ring, must be a power of two
+const uint32_t MIXER_BLOCK_FRAMES = 64;    // Frames summed per mixing pass
+
+// Gain stage. Volume changes ramp over VOLUME_RAMP_MS, voices fade in and
+// out over a few milliseconds instead of starting and stopping on a click,
+// and the sum passes a soft limiter above LIMITER_THRESHOLD (of 32767) so
+// overlapping voices bend instead of clipping.
+const unsigned long VOLUME_RAMP_MS = 20;
+const unsigned long FADE_IN_MS = 3;
+const unsigned long FADE_OUT_MS = 10;
+const bool LIMITER_ENABLED = true;
+const int32_t LIMITER_THRESHOLD = 24576;
+
+// Replay gain: each clip is decoded once when it is indexed and played with
+// the gain that brings its loudness to REPLAY_GAIN_TARGET_DBFS, within
+// +-REPLAY_GAIN_MAX_DB and without pushing its peak past full scale
+const bool REPLAY_GAIN_ENABLED = true;
+const float REPLAY_GAIN_TARGET_DBFS = -18.0f;
+const float REPLAY_GAIN_MAX_DB = 12.0f;
+
+// Playlists (see playlist.h). Each button can step through, pick randomly
+// from or chain up to PLAYLIST_MAX_CLIPS clip slots. In a chain the next
+// clip's decoder starts on a spare voice once the current clip has less than
+// PLAYLIST_PREFETCH_BYTES left to read, and joins on the exact frame the
+// current clip ends.
+const int PLAYLIST_MAX_CLIPS = 8;
+const uint32_t PLAYLIST_PREFETCH_BYTES = 8192;
+const char *const PLAYLIST_PATH = "/audio/playlists.bin";
+
+// Instrumentation: latency histograms, underrun count and heap use, served at
+// /metrics in the Prometheus text format (see metrics.h). Build with
+// -DMETRICS_ENABLED=0 or change the default here to compile every probe out.
+#ifndef METRICS_ENABLED
+#define METRICS_ENABLED 1
+#endif
+
+// Debug: count heap blocks allocated while starting a clip (should stay at zero)
+const bool AUDIO_ALLOC_CHECK_ENABLED = false;
+
+// Raw clip partition. When enabled and a data partition with this label and
+// subtype exists, every clip is mirrored into it on upload and played from a
+// memory-mapped view instead of SPIFFS (see clip_storage.h). Falls back to
+// SPIFFS when the partition is missing.
+const bool CLIP_PARTITION_ENABLED = false;
+const char *const CLIP_PARTITION_LABEL = "clips";
+const uint8_t CLIP_PARTITION_SUBTYPE = 0x40;
+
+// SPIFFS open file limit. The audio path keeps one handle per stored clip
+// open; the rest is for uploads, the index and the web server.
+constexpr uint8_t SPIFFS_MAX_OPEN_FILES = NUM_BUTTONS * MAX_CLIPS_PER_BUTTON + 4;
+const char *const CLIP_INDEX_PATH = "/audio/index.bin"; // Saved copy of the clip index (clip_index.h)
+
+// Audio task. Playback runs on its own FreeRTOS task so web and OTA work in
+// loop() cannot starve the decoder.
+const int AUDIO_TASK_CORE = 0;
+const int AUDIO_TASK_PRIORITY = 5;
+const uint32_t AUDIO_TASK_STACK_SIZE = 8192;
+const size_t AUDIO_COMMAND_QUEUE_SIZE = 16; // Must be a power of two
+const unsigned long CLIP_CLOSE_TIMEOUT_MS = 500; // Wait for the audio task to let go of a clip before its files change
+// Clip preparation task: imports a changed clip into the clip partition and
+// decodes its PCM prefix, so the audio task only has to swap them in
+const int CLIP_PREP_TASK_CORE = 1;
+const int CLIP_PREP_TASK_PRIORITY = 1;
+const uint32_t CLIP_PREP_TASK_STACK_SIZE = 8192; // Runs the MP3 decoder for PCM prefixes
+
+// Scheduled playback. Cues wait in a fixed-size heap on the audio task; the
+// output keeps running (on silence if needed) from SCHEDULE_HOLD_MS before a
+// cue so all cues share one sample clock. Clips should share a sample rate.
+const size_t SCHEDULE_CAPACITY = 32;
+const unsigned long SCHEDULE_PREROLL_MS = 40;    // Decoder starts this far ahead of its cue
+const unsigned long SCHEDULE_HOLD_MS = 1000;
+const unsigned long SCHEDULE_LEAD_MS = 100;      // Added to web cues so an offset of 0 is not already late
+const unsigned long SCHEDULE_MAX_OFFSET_MS = 600000;
+const int SCHEDULE_MAX_BATCH = 8;                // Cues per /schedule request
+static_assert(SCHEDULE_MAX_BATCH <= (int)AUDIO_COMMAND_QUEUE_SIZE && SCHEDULE_MAX_BATCH <= (int)SCHEDULE_CAPACITY,
+              "A /schedule batch must fit the web command queue and the schedule");
+
+// Clock sync between several Audiopads (see clock_sync.h). One device leads,
+// the others set CLOCK_SYNC_LEADER to its IP address and follow its clock.
+// Button presses then play on every device at the same moment.
+const bool CLOCK_SYNC_ENABLED = false;
+const char *const CLOCK_SYNC_LEADER = "";          // Empty on the leader itself
+const uint16_t CLOCK_SYNC_PORT = 5006;
+const unsigned long CLOCK_SYNC_INTERVAL_MS = 2000; // Time between exchanges with the leader
+const size_t CLOCK_SYNC_WINDOW = 32;               // Exchanges the clock model is fitted over
+const unsigned long CLOCK_SYNC_TIMEOUT_MS = 30000; // Followers fall back to local playback after this long without an exchange
+const unsigned long SYNC_PLAY_DELAY_MS = 150;      // Press to sound on every device, covers broadcast delivery
+const int32_t CLOCK_SYNC_MAX_TRIM_PPM = 500;
+const int CLOCK_SYNC_TASK_CORE = 1;
+const int CLOCK_SYNC_TASK_PRIORITY = 4;
+const uint32_t CLOCK_SYNC_TASK_STACK_SIZE = 4096;
 
 // Power management settings
 const unsigned long SLEEP_TIMEOUT_MS = 300000;        // 5 minutes (300,000ms) - configurable sleep timeout
 const unsigned long SLEEP_WARNING_TIME_MS = 30000;    // 30 seconds warning before sleep
 const unsigned long ACTIVITY_UPDATE_INTERVAL = 5000;  // Check activity every 5 seconds
 
+// Light sleep tier (see power_model.h). LIGHT_SLEEP_HOLD_MS after the last
+// activity the device drops into automatic light sleep with WiFi modem sleep.
+// A button press (GPIO) or a packet for it wakes it in a few milliseconds.
+// Needs an Arduino core built with CONFIG_PM_ENABLE; otherwise it stays fully
+// on until deep sleep. The draws and wake times below feed the tier model,
+// which goes to deep sleep after SLEEP_TIMEOUT_MS only if the current saved
+// outweighs the slow wake at POWER_LATENCY_WEIGHT (mA*s per ms of delay).
+const bool LIGHT_SLEEP_ENABLED = true;
+const int CPU_FREQ_MHZ = 240;
+const unsigned long LIGHT_SLEEP_HOLD_MS = 3000;
+const unsigned long LIGHT_SLEEP_LOOP_MS = 100; // loop() period while in light sleep
+const float POWER_ACTIVE_MA = 110.0f;
+const float POWER_LIGHT_SLEEP_MA = 20.0f;
+const float POWER_DEEP_SLEEP_MA = 0.15f;
+const float LIGHT_SLEEP_WAKE_MS = 3.0f;
+const float DEEP_SLEEP_WAKE_MS = 2500.0f; // Boot, SPIFFS mount and decoder setup
+const float POWER_LATENCY_WEIGHT = 0.5f;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,79 @@
+#ifndef DEBOUNCER_H
+#define DEBOUNCER_H
+
+#include <stdint.h>
+
+// Timestamp-based debouncer for one button, fed with (level, microsecond) edges.
+// The first edge that leaves a settled state is accepted immediately, so a press
+// is reported with no added delay. Edges within lockoutUs of an accepted change
+// are treated as bounce; if the line ends up in a different state, poll() picks
+// it up once it has been quiet for lockoutUs. Plain C++, no Arduino dependencies.
+class EdgeDebouncer {
+public:
+    enum Event : uint8_t { NONE, PRESSED, RELEASED };
+
+private:
+    bool activeLevel;
+    bool stableLevel;
+    bool rawLevel;
+    uint32_t lastAcceptedUs;
+    uint32_t lastEdgeUs;
+    uint32_t lockoutUs;
+
+    Event accept(bool level, uint32_t timestampUs);
+
+public:
+    EdgeDebouncer();
+    void reset(bool level, uint32_t nowUs, uint32_t lockout, bool pressedLevel);
+    Event onEdge(bool level, uint32_t timestampUs);
+    Event poll(uint32_t nowUs);
+    bool isPending() const { return rawLevel != stableLevel; }
+    bool isPressed() const { return stableLevel == activeLevel; }
+};
+
+// Implementation
+EdgeDebouncer::EdgeDebouncer() {
+    activeLevel = false;
+    stableLevel = true;
+    rawLevel = true;
+    lastAcceptedUs = 0;
+    lastEdgeUs = 0;
+    lockoutUs = 0;
+}
+
+void EdgeDebouncer::reset(bool level, uint32_t nowUs, uint32_t lockout, bool pressedLevel) {
+    activeLevel = pressedLevel;
+    stableLevel = level;
+    rawLevel = level;
+    lockoutUs = lockout;
+    // Start out settled so the very first press is not swallowed
+    lastAcceptedUs = nowUs - lockout;
+    lastEdgeUs = lastAcceptedUs;
+}
+
+EdgeDebouncer::Event EdgeDebouncer::accept(bool level, uint32_t timestampUs) {
+    stableLevel = level;
+    lastAcceptedUs = timestampUs;
+    return level == activeLevel ? PRESSED : RELEASED;
+}
+
+EdgeDebouncer::Event EdgeDebouncer::onEdge(bool level, uint32_t timestampUs) {
+    rawLevel = level;
+    lastEdgeUs = timestampUs;
+
+    if (level != stableLevel && (uint32_t)(timestampUs - lastAcceptedUs) >= lockoutUs) {
+        return accept(level, timestampUs);
+    }
+    return NONE;
+}
+
+EdgeDebouncer::Event EdgeDebouncer::poll(uint32_t nowUs) {
+    // Bouncing during the lockout may have left the line in the other state
+    if (rawLevel != stableLevel && (uint32_t)(nowUs - lastEdgeUs) >= lockoutUs &&
+        (uint32_t)(nowUs - lastAcceptedUs) >= lockoutUs) {
+        return accept(rawLevel, nowUs);
+    }
+    return NONE;
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef DSP_KERNELS_H
+#define DSP_KERNELS_H
+
+#include <stdint.h>
+
+// Sample-processing kernels shared by the audio pipeline. They are plain loops
+// over contiguous int16/int32 arrays so the compiler can vectorize them, and
+// they have no Arduino dependencies so they can be compiled and timed on a PC.
+
+// Gains are Q12 (4096 = unity, up to 8x) where they multiply samples. Ramps
+// keep their position in Q20 so that slow ramps still move every frame.
+const int32_t GAIN_Q12_UNITY = 4096;
+const int32_t GAIN_Q20_UNITY = 1 << 20;
+
+// acc[i] += src[i] * gain
+static inline void mixAccumulate(int32_t *acc, const int16_t *src, uint32_t count, int32_t gainQ12) {
+    for (uint32_t i = 0; i < count; i++) {
+        acc[i] += (src[i] * gainQ12) >> 12;
+    }
+}
+
+// Stereo frames: acc += src * gain, the gain moving linearly from gainQ20 by
+// stepQ20 per frame. Each frame's gain comes from its index rather than a
+// running sum, so iterations stay independent.
+static inline void mixAccumulateRamp(int32_t *acc, const int16_t *src, uint32_t frames, int32_t gainQ20,
+                                     int32_t stepQ20) {
+    for (uint32_t f = 0; f < frames; f++) {
+        int32_t g = (gainQ20 + stepQ20 * (int32_t)f) >> 8;
+        acc[f * 2] += (src[f * 2] * g) >> 12;
+        acc[f * 2 + 1] += (src[f * 2 + 1] * g) >> 12;
+    }
+}
+
+// acc[i] *= gain. A full mix can exceed 21 bits, hence the 64-bit product.
+static inline void applyGain(int32_t *acc, uint32_t count, int32_t gainQ12) {
+    for (uint32_t i = 0; i < count; i++) {
+        acc[i] = (int32_t)(((int64_t)acc[i] * gainQ12) >> 12);
+    }
+}
+
+// Stereo frames: acc *= gain, ramped like mixAccumulateRamp
+static inline void applyGainRamp(int32_t *acc, uint32_t frames, int32_t gainQ20, int32_t stepQ20) {
+    for (uint32_t f = 0; f < frames; f++) {
+        int32_t g = (gainQ20 + stepQ20 * (int32_t)f) >> 8;
+        acc[f * 2] = (int32_t)(((int64_t)acc[f * 2] * g) >> 12);
+        acc[f * 2 + 1] = (int32_t)(((int64_t)acc[f * 2 + 1] * g) >> 12);
+    }
+}
+
+// Clamp 32-bit accumulators back to 16-bit samples
+static inline void mixSaturate(int16_t *dst, const int32_t *acc, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t v = acc[i];
+        v = v > 32767 ? 32767 : v;
+        v = v < -32768 ? -32768 : v;
+        dst[i] = (int16_t)v;
+    }
+}
+
+// Soft limiter down to 16-bit samples: linear up to threshold, above it the
+// level bends towards full scale as 32767 - h^2 / (excess + h), h being the
+// headroom above the threshold. Same slope at the knee, never reaches clipping.
+static inline void softLimit(int16_t *dst, const int32_t *acc, uint32_t count, int32_t threshold) {
+    int32_t headroom = 32767 - threshold;
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t v = acc[i];
+        int32_t magnitude = v < 0 ? -v : v;
+        if (magnitude > threshold) {
+            magnitude = 32767 - headroom * headroom / (magnitude - threshold + headroom);
+            v = v < 0 ? -magnitude : magnitude;
+        }
+        dst[i] = (int16_t)v;
+    }
+}
+
+#endif
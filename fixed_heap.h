@@ -0,0 +1,116 @@
+#ifndef FIXED_HEAP_H
+#define FIXED_HEAP_H
+
+#include <stddef.h>
+
+// Binary min-heap in a fixed array, ordered by the Before functor
+// (before(a, b) is true when a must come out first). Never allocates.
+// No Arduino dependencies.
+template<typename T, size_t N, typename Before>
+class FixedHeap {
+private:
+    T items[N];
+    size_t count;
+    Before before;
+    
+    void siftUp(size_t i);
+    void siftDown(size_t i);
+
+public:
+    FixedHeap() : count(0) {}
+    bool push(const T &item);
+    bool pop(T &item);
+    const T &top() const { return items[0]; }
+    void clear() { count = 0; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == N; }
+    static constexpr size_t capacity() { return N; }
+    
+    // Drops every item matching pred, returns how many were removed
+    template<typename Pred>
+    size_t removeIf(Pred pred);
+};
+
+// Implementation
+template<typename T, size_t N, typename Before>
+void FixedHeap<T, N, Before>::siftUp(size_t i) {
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!before(items[i], items[parent])) {
+            break;
+        }
+        T tmp = items[i];
+        items[i] = items[parent];
+        items[parent] = tmp;
+        i = parent;
+    }
+}
+
+template<typename T, size_t N, typename Before>
+void FixedHeap<T, N, Before>::siftDown(size_t i) {
+    for (;;) {
+        size_t first = i;
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+        if (left < count && before(items[left], items[first])) {
+            first = left;
+        }
+        if (right < count && before(items[right], items[first])) {
+            first = right;
+        }
+        if (first == i) {
+            return;
+        }
+        T tmp = items[i];
+        items[i] = items[first];
+        items[first] = tmp;
+        i = first;
+    }
+}
+
+template<typename T, size_t N, typename Before>
+bool FixedHeap<T, N, Before>::push(const T &item) {
+    if (count == N) {
+        return false;
+    }
+    items[count] = item;
+    siftUp(count);
+    count++;
+    return true;
+}
+
+template<typename T, size_t N, typename Before>
+bool FixedHeap<T, N, Before>::pop(T &item) {
+    if (count == 0) {
+        return false;
+    }
+    item = items[0];
+    count--;
+    if (count > 0) {
+        items[0] = items[count];
+        siftDown(0);
+    }
+    return true;
+}
+
+template<typename T, size_t N, typename Before>
+template<typename Pred>
+size_t FixedHeap<T, N, Before>::removeIf(Pred pred) {
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!pred(items[i])) {
+            items[kept++] = items[i];
+        }
+    }
+    size_t removed = count - kept;
+    count = kept;
+    
+    // Rebuild the heap order over what is left
+    for (size_t i = count / 2; i-- > 0;) {
+        siftDown(i);
+    }
+    return removed;
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef HOST_ALLOC_COUNTER_H
+#define HOST_ALLOC_COUNTER_H
+
+// Counts heap allocations made by the calling thread between
+// hostCountAllocations(true) and (false): operator new directly, malloc,
+// calloc and realloc through the linker's --wrap (audiopad_host_target()
+// with ALLOCATIONS in CMakeLists.txt). Include it in one file per program.
+
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+}
+
+inline bool &hostCountingAllocations() {
+    static thread_local bool counting = false;
+    return counting;
+}
+
+inline uint64_t &hostAllocationCount() {
+    static thread_local uint64_t count = 0;
+    return count;
+}
+
+inline void hostCountAllocations(bool enable) { hostCountingAllocations() = enable; }
+
+inline void hostNoteAllocation() {
+    if (hostCountingAllocations()) {
+        hostAllocationCount()++;
+    }
+}
+
+extern "C" {
+void *__wrap_malloc(size_t size) {
+    hostNoteAllocation();
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    hostNoteAllocation();
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size) {
+    hostNoteAllocation();
+    return __real_realloc(pointer, size);
+}
+}
+
+static void *hostNew(size_t size) {
+    hostNoteAllocation();
+    void *pointer = __real_malloc(size ? size : 1);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+static void *hostNewAligned(size_t size, std::align_val_t alignment) {
+    hostNoteAllocation();
+    size_t align = (size_t)alignment;
+    void *pointer = aligned_alloc(align, (size + align - 1) / align * align);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void *operator new(size_t size) { return hostNew(size); }
+void *operator new[](size_t size) { return hostNew(size); }
+void *operator new(size_t size, std::align_val_t alignment) { return hostNewAligned(size, alignment); }
+void *operator new[](size_t size, std::align_val_t alignment) { return hostNewAligned(size, alignment); }
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    hostNoteAllocation();
+    return __real_malloc(size ? size : 1);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    hostNoteAllocation();
+    return __real_malloc(size ? size : 1);
+}
+
+void operator delete(void *pointer) noexcept { free(pointer); }
+void operator delete[](void *pointer) noexcept { free(pointer); }
+void operator delete(void *pointer, size_t) noexcept { free(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { free(pointer); }
+void operator delete(void *pointer, std::align_val_t) noexcept { free(pointer); }
+void operator delete[](void *pointer, std::align_val_t) noexcept { free(pointer); }
+void operator delete(void *pointer, size_t, std::align_val_t) noexcept { free(pointer); }
+void operator delete[](void *pointer, size_t, std::align_val_t) noexcept { free(pointer); }
+
+#endif
@@ -0,0 +1,139 @@
+// Decode cost of the ADPCM clip decoder, from RAM (the clip partition path)
+// and from a file (the SPIFFS path), in samples per second, next to the MP3
+// decoder it replaces; and for both, the time from begin() to the first
+// sample, which is what a press waits for. The host has no Helix, so the MP3
+// lines come from the stand-in in stubs/AudioGeneratorMP3.h timed as Helix
+// on the ESP32 (HostMp3Model::modelHelix()). ADPCM is measured on this
+// machine, which decodes it faster than the ESP32 does.
+
+#include <chrono>
+#include "host_test.h"
+#include "adpcm_generator.h"
+#include "clip_source.h"
+#include "AudioGeneratorMP3.h"
+
+using Clock = std::chrono::steady_clock;
+
+// Accepts everything, as a voice buffer that never fills
+class NullOutput : public AudioOutput {
+public:
+    uint64_t samples = 0;
+    virtual bool begin() override { return true; }
+    virtual bool ConsumeSample(int16_t sample[2]) override {
+        (void)sample;
+        samples++;
+        return true;
+    }
+    virtual bool stop() override { return true; }
+};
+
+// Takes one sample and then reports itself full
+class FirstSampleOutput : public AudioOutput {
+public:
+    Clock::time_point firstAt;
+    bool taken = false;
+    virtual bool begin() override { return true; }
+    virtual bool ConsumeSample(int16_t sample[2]) override {
+        (void)sample;
+        if (taken) {
+            return false;
+        }
+        firstAt = Clock::now();
+        taken = true;
+        return true;
+    }
+    virtual bool stop() override { return true; }
+};
+
+static std::vector<uint8_t> readClip(const char *path) {
+    File file = SPIFFS.open(path, "r");
+    std::vector<uint8_t> data(file.size());
+    file.read(data.data(), data.size());
+    file.close();
+    return data;
+}
+
+template<typename Decoder>
+static double decodeAll(ClipFileSource &source, const uint8_t *data, uint32_t size, File *file, NullOutput &out) {
+    Decoder decoder;
+    Clock::time_point started = Clock::now();
+    if (data) {
+        source.attach(data, size);
+    } else {
+        source.attach(file);
+    }
+    if (!decoder.begin(&source, &out)) {
+        return 0.0;
+    }
+    while (decoder.loop()) {
+    }
+    decoder.stop();
+    return std::chrono::duration<double>(Clock::now() - started).count();
+}
+
+// Attach and begin() up to the first decoded sample, from RAM
+template<typename Decoder>
+static double firstSample(const std::vector<uint8_t> &data) {
+    Decoder decoder;
+    ClipFileSource source;
+    FirstSampleOutput out;
+    Clock::time_point started = Clock::now();
+    source.attach(data.data(), data.size());
+    if (!decoder.begin(&source, &out)) {
+        return 0.0;
+    }
+    while (!out.taken && decoder.loop()) {
+    }
+    decoder.stop();
+    return out.taken ? std::chrono::duration<double>(out.firstAt - started).count() : 0.0;
+}
+
+template<typename Decoder>
+static void reportDecode(const char *name, const std::vector<uint8_t> &data, File *file, uint32_t clipMs,
+                         int rounds) {
+    NullOutput out;
+    double seconds = 0.0;
+    for (int i = 0; i < rounds; i++) {
+        ClipFileSource source;
+        seconds += decodeAll<Decoder>(source, file ? nullptr : data.data(), data.size(), file, out);
+    }
+    CHECK(out.samples == (uint64_t)rounds * 44100 * clipMs / 1000);
+    double rate = out.samples / seconds;
+    printf("%-18s %8.1f Msamples/s (%.0fx real time, %.2f ms CPU per s of audio)\n", name, rate / 1e6,
+           rate / 44100, 44100 * 1000.0 / rate);
+}
+
+template<typename Decoder>
+static void reportStart(const char *name, const std::vector<uint8_t> &data, int rounds) {
+    HostStats start;
+    for (int i = 0; i < rounds; i++) {
+        double seconds = firstSample<Decoder>(data);
+        CHECK(seconds > 0.0);
+        start.add(seconds * 1e6);
+    }
+    printf("%-18s begin to first sample: p50 %.0f us, max %.0f us\n", name, start.percentile(50), start.max());
+}
+
+int main(int argc, char **argv) {
+    bool quick = hostQuick(argc, argv);
+    int rounds = quick ? 2 : 20;
+    hostMountSpiffs("bench_decode_spiffs");
+    const uint32_t clipMs = 10000;
+    const uint32_t mp3Ms = quick ? 1000 : 10000; // The model really spends its time, so keep --quick short
+    CHECK(hostWriteAdpcmClip("/audio/button1.adp", 44100, clipMs));
+    CHECK(hostWriteMp3Clip("/audio/button2.mp3", mp3Ms));
+    hostMp3().modelHelix();
+
+    std::vector<uint8_t> adpcm = readClip("/audio/button1.adp");
+    std::vector<uint8_t> mp3 = readClip("/audio/button2.mp3");
+    File file = SPIFFS.open("/audio/button1.adp", "r");
+
+    reportDecode<AudioGeneratorADPCM>("ADPCM from RAM", adpcm, nullptr, clipMs, rounds);
+    reportDecode<AudioGeneratorADPCM>("ADPCM from file", adpcm, &file, clipMs, rounds);
+    reportDecode<AudioGeneratorMP3>("MP3 (Helix model)", mp3, nullptr, mp3Ms, 1);
+    file.close();
+
+    reportStart<AudioGeneratorADPCM>("ADPCM", adpcm, rounds * 10);
+    reportStart<AudioGeneratorMP3>("MP3 (Helix model)", mp3, quick ? 2 : 10);
+    return hostReport("bench_decode");
+}
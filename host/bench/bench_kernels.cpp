@@ -0,0 +1,101 @@
+// Throughput of each mixer stage in dsp_kernels.h, in samples per second and
+// as a multiple of what one 44.1 kHz stereo stream needs. Buffers are one
+// mixer block, as the firmware calls them. Then a whole block as renderBlock()
+// mixes it, with MAX_VOICES voices and swept over the voice count.
+
+#include <chrono>
+#include "host_test.h"
+#include "dsp_kernels.h"
+#include "config.h"
+
+static const uint32_t SAMPLES = MIXER_BLOCK_FRAMES * 2;
+
+static int16_t source[SAMPLES];
+static int16_t output[SAMPLES];
+static int32_t accum[SAMPLES];
+
+// Ramps cover the whole block, from unity down by a quarter
+static const int32_t RAMP_STEP_Q20 = -(GAIN_Q20_UNITY / 4) / (int32_t)MIXER_BLOCK_FRAMES;
+
+// A loud mix of two voices, partly above the limiter threshold
+static void resetAccum() {
+    for (uint32_t i = 0; i < SAMPLES; i++) {
+        accum[i] = source[i] * 2;
+    }
+}
+
+// Runs the kernel over one block repeatedly for about the given time and
+// returns the seconds per block
+template<typename Kernel>
+static double timeBlock(double seconds, Kernel kernel) {
+    using Clock = std::chrono::steady_clock;
+    uint64_t blocks = 0;
+    Clock::time_point started = Clock::now();
+    double elapsed = 0.0;
+    while (elapsed < seconds) {
+        for (int i = 0; i < 1024; i++) {
+            kernel();
+            // Buffers count as changed, so each call really runs
+            asm volatile("" : : : "memory");
+        }
+        blocks += 1024;
+        elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+    }
+    return elapsed / blocks;
+}
+
+template<typename Kernel>
+static void measure(const char *name, double seconds, Kernel kernel) {
+    double rate = SAMPLES / timeBlock(seconds, kernel);
+    printf("%-18s %8.1f Msamples/s %8.0fx real time\n", name, rate / 1e6, rate / (44100.0 * 2));
+}
+
+// A whole block as renderBlock() mixes it: the voices, master gain, then the limiter
+static void mixBlock(int voices) {
+    for (uint32_t i = 0; i < SAMPLES; i++) {
+        accum[i] = 0;
+    }
+    for (int voice = 0; voice < voices; voice++) {
+        mixAccumulate(accum, source, SAMPLES, GAIN_Q12_UNITY / 2);
+    }
+    applyGain(accum, SAMPLES, GAIN_Q12_UNITY);
+    softLimit(output, accum, SAMPLES, LIMITER_THRESHOLD);
+}
+
+int main(int argc, char **argv) {
+    double seconds = hostQuick(argc, argv) ? 0.05 : 1.0;
+    for (uint32_t i = 0; i < SAMPLES; i++) {
+        source[i] = (int16_t)(sinf(i * 0.05f) * 20000.0f);
+    }
+
+    // Each stage starts from the same mix; the timing does not depend on the values except in softLimit
+    resetAccum();
+    measure("mixAccumulate", seconds, [] { mixAccumulate(accum, source, SAMPLES, GAIN_Q12_UNITY / 2); });
+    resetAccum();
+    measure("mixAccumulateRamp", seconds, [] {
+        mixAccumulateRamp(accum, source, MIXER_BLOCK_FRAMES, GAIN_Q20_UNITY, RAMP_STEP_Q20);
+    });
+    resetAccum();
+    measure("applyGain", seconds, [] { applyGain(accum, SAMPLES, GAIN_Q12_UNITY); });
+    resetAccum();
+    measure("applyGainRamp", seconds, [] {
+        applyGainRamp(accum, MIXER_BLOCK_FRAMES, GAIN_Q20_UNITY, RAMP_STEP_Q20);
+    });
+    resetAccum();
+    measure("mixSaturate", seconds, [] { mixSaturate(output, accum, SAMPLES); });
+    measure("softLimit", seconds, [] { softLimit(output, accum, SAMPLES, LIMITER_THRESHOLD); });
+
+    // MAX_VOICES voices, master gain and limiter per block; samples counted at the output
+    measure("block", seconds, [] { mixBlock(MAX_VOICES); });
+
+    // The same block over a range of voice counts. A ms of CPU mixes this many
+    // voices for a ms of 44.1 kHz audio: where it flattens out, the fixed cost of
+    // the master gain and limiter no longer dominates.
+    const double blockMs = MIXER_BLOCK_FRAMES * 1000.0 / 44100;
+    for (int voices = 1; voices <= 4 * MAX_VOICES; voices *= 2) {
+        double blockSeconds = timeBlock(seconds, [voices] { mixBlock(voices); });
+        printf("%3d voices %8.2f us per block %8.0f voices mixed per ms of CPU\n", voices, blockSeconds * 1e6,
+               voices * blockMs / (blockSeconds * 1000.0));
+    }
+    return 0;
+}
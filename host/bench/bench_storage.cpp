@@ -0,0 +1,63 @@
+// Open to first byte for the two clip storage backends: attach() and the
+// first read a decoder makes, as a press does it, for SpiffsClipStorage
+// (a kept-open handle rewound on the host SPIFFS directory) and for
+// PartitionClipStorage (a directory lookup into the memory-mapped RAM
+// partition from stubs/esp_partition.h). The host file system does not
+// slow down as it fills the way SPIFFS does, so the SPIFFS line is a best
+// case for the device.
+
+#include <chrono>
+#include "host_test.h"
+#include "clip_storage.h"
+
+using Clock = std::chrono::steady_clock;
+
+// Bytes a decoder asks for first, e.g. an ADPCM header and block
+static const uint32_t FIRST_READ = 512;
+
+static void measure(ClipStorage &storage, int rounds, std::vector<uint8_t> &firstBytes) {
+    HostStats open;
+    uint8_t buffer[FIRST_READ];
+    for (int i = 0; i < rounds; i++) {
+        for (int buttonNum = 1; buttonNum <= Pads::buttons; buttonNum++) {
+            int clip = Pads::clipOf(buttonNum, 1);
+            ClipFileSource source;
+            Clock::time_point started = Clock::now();
+            bool attached = storage.attach(clip, source);
+            uint32_t n = attached ? source.read(buffer, sizeof(buffer)) : 0;
+            double ns = std::chrono::duration<double, std::nano>(Clock::now() - started).count();
+            CHECK(n == sizeof(buffer));
+            open.add(ns);
+            if (i == 0) {
+                firstBytes.insert(firstBytes.end(), buffer, buffer + n);
+            }
+        }
+    }
+    printf("%-10s attach + first %u bytes: p50 %.0f ns, p99 %.0f ns, max %.0f ns (%d opens)\n",
+           storage.getName(), FIRST_READ, open.percentile(50), open.percentile(99), open.max(),
+           rounds * Pads::buttons);
+}
+
+int main(int argc, char **argv) {
+    int rounds = hostQuick(argc, argv) ? 100 : 10000;
+    hostMountSpiffs("bench_storage_spiffs");
+    for (int buttonNum = 1; buttonNum <= Pads::buttons; buttonNum++) {
+        ClipPath path = Pads::clipPath(Pads::clipOf(buttonNum, 1), ".adp");
+        CHECK(hostWriteAdpcmClip(path.c_str(), 44100, 2000, 0.5f, 220.0f * buttonNum));
+    }
+    clipIndex.begin();
+
+    SpiffsClipStorage spiffs;
+    spiffs.begin();
+    hostCreatePartition(CLIP_PARTITION_LABEL, CLIP_PARTITION_SUBTYPE, 2 * 1024 * 1024);
+    PartitionClipStorage partition;
+    CHECK(partition.begin());
+
+    // Both have to hand out the same clips
+    std::vector<uint8_t> fromSpiffs;
+    std::vector<uint8_t> fromPartition;
+    measure(spiffs, rounds, fromSpiffs);
+    measure(partition, rounds, fromPartition);
+    CHECK(fromSpiffs == fromPartition);
+    return hostReport("bench_storage");
+}
@@ -0,0 +1,76 @@
+// Trigger latency through the real audio path: a debounced button edge,
+// playButtonSound() from the button source, the audio task's update() and
+// the mixer, up to the first non-zero sample queued to I2S. Also counts heap
+// allocations from the edge to that sample. Button 1 plays an ADPCM clip,
+// button 2 an MP3 clip that starts from its cached PCM prefix; the host MP3
+// stand-in is given a start-up time so the prefix has a decoder to beat.
+// Built with PCM_PREFIX_CACHE_ENABLED (see CMakeLists.txt).
+
+#include "alloc_counter.h"
+#include "host_test.h"
+#include "debouncer.h"
+#include "audio_manager.h"
+
+static void measure(AudioManager &audio, int buttonNum, const char *name, int presses) {
+    EdgeDebouncer debouncer;
+    const uint32_t lockoutUs = DEBOUNCE_DELAY * 1000;
+    debouncer.reset(true, 0, lockoutUs, false);
+
+    HostStats latency;
+    HostStats allocations;
+    for (int i = 0; i < presses; i++) {
+        // The debouncer runs on its own timeline, one press every two lockouts
+        uint32_t edgeTime = (i + 1) * lockoutUs * 2;
+        hostI2S().arm();
+        hostAllocationCount() = 0;
+        hostCountAllocations(true);
+
+        unsigned long edgeAt = micros();
+        if (debouncer.onEdge(false, edgeTime) == EdgeDebouncer::PRESSED) {
+            audio.playButtonSound(buttonNum, 1.0f, AUDIO_SOURCE_BUTTONS);
+        }
+        while (!hostI2S().heard() && micros() - edgeAt < 100000) {
+            audio.update();
+        }
+
+        hostCountAllocations(false);
+        CHECK(hostI2S().heard());
+        latency.add(hostI2S().soundAt - edgeAt);
+        allocations.add(hostAllocationCount());
+
+        // Let it sound briefly, then stop and wait for the fade and the output to finish
+        debouncer.onEdge(true, edgeTime + lockoutUs);
+        unsigned long playing = micros();
+        while (micros() - playing < 5000) {
+            audio.update();
+        }
+        audio.stopCurrentAudio();
+        while (audio.getIsPlaying() && micros() - playing < 1000000) {
+            audio.update();
+        }
+        CHECK(!audio.getIsPlaying());
+    }
+
+    printf("%-12s edge to first sample: p50 %.0f us, p99 %.0f us, max %.0f us (%d presses)\n", name,
+           latency.percentile(50), latency.percentile(99), latency.max(), presses);
+    printf("%-12s allocations per press: p50 %.0f, max %.0f\n", name, allocations.percentile(50), allocations.max());
+}
+
+int main(int argc, char **argv) {
+    int presses = hostQuick(argc, argv) ? 10 : 200;
+    hostMountSpiffs("bench_trigger_spiffs");
+    CHECK(hostWriteAdpcmClip("/audio/button1.adp", 44100, 2000));
+    CHECK(hostWriteMp3Clip("/audio/button2.mp3", 2000));
+    clipIndex.begin();
+
+    hostMp3().modelHelix();
+
+    AudioManager audio;
+    audio.init();
+    audio.startTask(); // No tasks on the host: decodes the PCM prefixes here
+    audio.update();    // Swaps them in
+
+    measure(audio, 1, "ADPCM", presses);
+    measure(audio, 2, "MP3 + prefix", presses);
+    return hostReport("bench_trigger");
+}
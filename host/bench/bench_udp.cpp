@@ -0,0 +1,166 @@
+// UdpTrigger's packet handling, fed the datagrams tools/udp_trigger.py
+// sends: the framing, the HMAC tag (stubs/secrets.h sets a key and
+// stubs/mbedtls/md.h computes it), batches, and per-sender sequence numbers
+// against duplicates, replays and a full sender table. Then the time to
+// take one packet apart and hand its commands on, for one command and for
+// a full batch, most of which is the HMAC. The network and the task wake-up
+// are not included; on the device, `tools/udp_trigger.py bench` times the
+// round trip next to /test.
+
+#include <chrono>
+#include "host_test.h"
+#include "pad_topology.h"
+#include "udp_trigger.h"
+
+using Clock = std::chrono::steady_clock;
+
+static UdpTrigger trigger;
+static UdpCommand received[UDP_MAX_BATCH];
+static int receivedCount = 0;
+
+static void onCommand(const UdpCommand &command) {
+    if (receivedCount < UDP_MAX_BATCH) {
+        received[receivedCount] = command;
+    }
+    receivedCount++;
+}
+
+static sockaddr_in sender(uint32_t address, uint16_t port) {
+    sockaddr_in from;
+    memset(&from, 0, sizeof(from));
+    from.sin_family = AF_INET;
+    from.sin_addr.s_addr = htonl(address);
+    from.sin_port = htons(port);
+    return from;
+}
+
+// As tools/udp_trigger.py lays it out; returns its length
+static size_t buildPacket(uint8_t *packet, uint32_t sequence, const UdpCommand *commands, uint8_t count,
+                          uint8_t flags = 0) {
+    UdpPacketHeader header = {{'A', 'P'}, 1, flags, sequence, count};
+    size_t body = sizeof(header) + count * sizeof(UdpCommand);
+    memcpy(packet, &header, sizeof(header));
+    memcpy(packet + sizeof(header), commands, count * sizeof(UdpCommand));
+    UdpTrigger::appendTag(packet, body);
+    return body + UdpTrigger::tagBytes();
+}
+
+// Whether the packet was accepted
+static bool feed(const uint8_t *packet, size_t length, const sockaddr_in &from) {
+    uint32_t before = trigger.getAccepted();
+    receivedCount = 0;
+    trigger.handlePacket(packet, length, from);
+    return trigger.getAccepted() == before + 1;
+}
+
+static bool feed(uint32_t sequence, const sockaddr_in &from) {
+    UdpCommand play = {UDP_OP_PLAY, 1, 1000};
+    uint8_t packet[UDP_MAX_PACKET];
+    size_t length = buildPacket(packet, sequence, &play, 1);
+    return feed(packet, length, from);
+}
+
+static void checkHmac() {
+    // RFC 4231 test case 2
+    static const char key[] = "Jefe";
+    static const char data[] = "what do ya want for nothing?";
+    static const uint8_t expected[32] = {0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e, 0x6a, 0x04, 0x24,
+                                         0x26, 0x08, 0x95, 0x75, 0xc7, 0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27,
+                                         0x39, 0x83, 0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43};
+    uint8_t digest[32];
+    CHECK(mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), (const uint8_t *)key, sizeof(key) - 1,
+                          (const uint8_t *)data, sizeof(data) - 1, digest) == 0);
+    CHECK(memcmp(digest, expected, sizeof(digest)) == 0);
+    CHECK(UdpTrigger::tagBytes() == UDP_HMAC_BYTES);
+}
+
+static void checkPackets() {
+    sockaddr_in from = sender(0x0a000002, 40000);
+    uint8_t packet[UDP_MAX_PACKET];
+
+    // A batch arrives whole and in order
+    UdpCommand batch[UDP_MAX_BATCH];
+    for (int i = 0; i < UDP_MAX_BATCH; i++) {
+        batch[i] = {UDP_OP_PLAY, (uint8_t)(i + 1), (uint16_t)(100 * i)};
+    }
+    batch[UDP_MAX_BATCH - 1] = {UDP_OP_VOLUME, 0, 400};
+    size_t length = buildPacket(packet, 10, batch, UDP_MAX_BATCH);
+    CHECK(feed(packet, length, from));
+    CHECK(receivedCount == UDP_MAX_BATCH);
+    CHECK(memcmp(received, batch, sizeof(batch)) == 0);
+
+    // Framing and tag
+    uint32_t sequence = 11;
+    length = buildPacket(packet, sequence, batch, 1);
+    CHECK(!feed(packet, length - 1, from));
+    CHECK(!feed(packet, sizeof(UdpPacketHeader) - 1, from));
+    packet[length - 1] ^= 0x01;
+    CHECK(!feed(packet, length, from));
+    packet[length - 1] ^= 0x01;
+    packet[sizeof(UdpPacketHeader)] = UDP_OP_STOP; // Covered by the tag
+    CHECK(!feed(packet, length, from));
+    length = buildPacket(packet, sequence, batch, 1);
+    packet[0] = 'X';
+    CHECK(!feed(packet, length, from));
+    length = buildPacket(packet, sequence, batch, 1);
+    packet[2] = 2;
+    CHECK(!feed(packet, length, from));
+    UdpCommand tooMany[UDP_MAX_BATCH + 1] = {};
+    uint8_t large[UDP_MAX_PACKET + sizeof(UdpCommand)];
+    length = buildPacket(large, sequence, tooMany, UDP_MAX_BATCH + 1);
+    CHECK(!feed(large, length, from));
+    CHECK(receivedCount == 0);
+
+    // Sequence numbers per sender, across wrap-around
+    CHECK(feed(sequence, from));
+    CHECK(!feed(sequence, from));
+    CHECK(!feed(sequence - 1, from));
+    CHECK(feed(sequence + 1, from));
+    CHECK(feed(sequence, sender(0x0a000002, 40001)));
+    sockaddr_in wrapping = sender(0x0a000003, 40000);
+    CHECK(feed(0xfffffffe, wrapping));
+    CHECK(feed(1, wrapping));
+    CHECK(!feed(0xffffffff, wrapping));
+
+    // A full table forgets the sender heard from longest ago, which then starts afresh
+    for (size_t i = 0; i < UDP_MAX_SOURCES; i++) {
+        CHECK(feed(100, sender(0x0a000100 + i, 5000)));
+    }
+    CHECK(feed(100, sender(0x0a000200, 5000)));
+    CHECK(!feed(100, sender(0x0a000101, 5000)));
+    CHECK(feed(100, sender(0x0a000100, 5000)));
+}
+
+static void measure(const char *name, uint8_t count, int packets) {
+    UdpCommand batch[UDP_MAX_BATCH];
+    for (int i = 0; i < count; i++) {
+        batch[i] = {UDP_OP_PLAY, (uint8_t)(i % Pads::buttons + 1), 1000};
+    }
+    sockaddr_in from = sender(0x0a000009, 40000 + count); // Its own sequence numbers
+    uint8_t packet[UDP_MAX_PACKET];
+    HostStats handling;
+    double seconds = 0.0;
+    for (int i = 0; i < packets; i++) {
+        size_t length = buildPacket(packet, 1000 + i, batch, count);
+        Clock::time_point started = Clock::now();
+        trigger.handlePacket(packet, length, from);
+        double elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+        seconds += elapsed;
+        handling.add(elapsed * 1e9);
+    }
+    printf("%-10s %.0f packets/s, p50 %.0f ns, p99 %.0f ns, max %.0f ns per packet\n", name, packets / seconds,
+           handling.percentile(50), handling.percentile(99), handling.max());
+}
+
+int main(int argc, char **argv) {
+    int packets = hostQuick(argc, argv) ? 10000 : 1000000;
+    trigger.setCommandCallback(onCommand);
+    checkHmac();
+    checkPackets();
+
+    uint32_t accepted = trigger.getAccepted();
+    measure("1 command", 1, packets);
+    measure("full batch", UDP_MAX_BATCH, packets);
+    CHECK(trigger.getAccepted() == accepted + 2 * packets);
+    return hostReport("bench_udp");
+}
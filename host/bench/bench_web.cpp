@@ -0,0 +1,143 @@
+// The web server's connection cap and handler cost under load, without
+// AsyncTCP: the host side of tools/http_load.py. Simulated clients send
+// requests through the server's route table (stubs/ESPAsyncWebServer.h)
+// and keep each one open for a while after its reply, as a slow client
+// does, so at most WEB_MAX_CONNECTIONS are admitted and the rest are
+// refused with 503 "Server busy". A button is re-triggered through /test
+// once a second and the audio manager runs between requests, so playback
+// goes on throughout. Reports requests per second of server time, the
+// time from a request's arrival to its last byte sent and any silence at
+// the output. Server and audio share one thread here, unlike on the device,
+// so the host descheduling the bench shows up in both.
+
+#include <chrono>
+#include <deque>
+#include <random>
+#include "host_test.h"
+#include "audio_manager.h"
+#include "web_server.h"
+
+using Clock = std::chrono::steady_clock;
+
+static AudioManager audio;
+static WebServerManager web;
+
+static const char *const ROUTES[] = {"/volume", "/files", "/battery", "/", "/style.css", "/playlist"};
+static const int ROUTE_COUNT = sizeof(ROUTES) / sizeof(ROUTES[0]);
+static const unsigned long PLAY_INTERVAL_US = 1000000; // http_load.py --play-interval, inside the 2 s clips
+
+// A request that has been answered and waits for its client to close it
+struct OpenRequest {
+    AsyncWebServerRequest *request;
+    unsigned long closesAt;
+};
+
+static AsyncWebServerRequest *send(WebRequestMethod method, const char *url, const char *param = nullptr,
+                                   const char *value = nullptr) {
+    AsyncWebServerRequest *request = new AsyncWebServerRequest(method, url);
+    if (param) {
+        request->hostAddParam(param, value, true);
+    }
+    AsyncWebServer::hostLatest()->hostHandle(request);
+    return request;
+}
+
+// The cap on its own: WEB_MAX_CONNECTIONS open requests, then a refusal, then a slot freed by a disconnect
+static void checkAdmission() {
+    AsyncWebServerRequest *open[WEB_MAX_CONNECTIONS];
+    for (int i = 0; i < WEB_MAX_CONNECTIONS; i++) {
+        open[i] = send(HTTP_GET, "/volume");
+        CHECK(open[i]->hostCode() == 200);
+    }
+    AsyncWebServerRequest *refused = send(HTTP_GET, "/battery");
+    CHECK(refused->hostCode() == 503);
+    CHECK(strcmp(refused->hostBody(), "Server busy") == 0);
+    delete refused;
+
+    delete open[0];
+    open[0] = send(HTTP_GET, "/battery");
+    CHECK(open[0]->hostCode() == 200);
+    for (int i = 0; i < WEB_MAX_CONNECTIONS; i++) {
+        delete open[i];
+    }
+    AsyncWebServerRequest *after = send(HTTP_GET, "/volume");
+    CHECK(after->hostCode() == 200);
+    delete after;
+}
+
+static void measure(int clients, unsigned long runMs) {
+    std::mt19937 random(1);
+    std::uniform_int_distribution<unsigned long> holdUs(0, 2000);
+    std::deque<OpenRequest> open;
+    HostStats latency;
+    double serverSeconds = 0.0;
+    int answered = 0;
+    int refused = 0;
+    uint64_t silentBefore = hostI2S().silentFrames;
+
+    int requests = 0;
+    unsigned long runStarted = micros();
+    unsigned long lastPlay = runStarted - PLAY_INTERVAL_US;
+    for (int i = 0; micros() - runStarted < runMs * 1000; i++) {
+        // Clients whose time is up close their connections; a full house waits for the next one
+        unsigned long now = micros();
+        while (!open.empty() && ((long)(now - open.front().closesAt) >= 0 || (int)open.size() >= clients)) {
+            delete open.front().request;
+            open.pop_front();
+        }
+
+        Clock::time_point started = Clock::now();
+        AsyncWebServerRequest *request;
+        if (now - lastPlay >= PLAY_INTERVAL_US) {
+            lastPlay = now;
+            request = send(HTTP_POST, "/test", "button", "1");
+        } else {
+            request = send(HTTP_GET, ROUTES[i % ROUTE_COUNT]);
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+        serverSeconds += seconds;
+        latency.add(seconds * 1e9);
+        requests++;
+        if (request->hostCode() == 503) {
+            refused++;
+        } else {
+            CHECK(request->hostCode() == 200 || request->hostCode() == 304);
+            answered++;
+        }
+        open.push_back({request, micros() + holdUs(random)});
+
+        audio.update();
+    }
+    while (!open.empty()) {
+        delete open.front().request;
+        open.pop_front();
+    }
+
+    CHECK(answered > 0);
+    printf("%d clients: %.0f requests/s of server time, p50 %.0f ns, p99 %.0f ns, max %.0f ns; "
+           "%d answered, %d refused with 503\n",
+           clients, requests / serverSeconds, latency.percentile(50), latency.percentile(99), latency.max(), answered,
+           refused);
+    printf("%d clients: %llu frames of silence in %lu ms of playback\n", clients,
+           (unsigned long long)(hostI2S().silentFrames - silentBefore), runMs);
+}
+
+int main(int argc, char **argv) {
+    unsigned long runMs = hostQuick(argc, argv) ? 200 : 5000;
+    hostMountSpiffs("bench_web_spiffs");
+    for (int buttonNum = 1; buttonNum <= 3; buttonNum++) {
+        CHECK(hostWriteMp3Clip(Pads::clipPath(buttonNum).c_str(), 2000, 0.3f, 220.0f * buttonNum));
+    }
+    clipIndex.begin();
+    audio.init();
+
+    web.setTestButtonCallback([](int buttonNum) { audio.playButtonSound(buttonNum, 1.0f, AUDIO_SOURCE_WEB); });
+    web.setVolumeCallbacks([](float volume) { audio.setVolume(volume, AUDIO_SOURCE_WEB); },
+                           []() { return audio.getVolume(); });
+    web.init();
+
+    checkAdmission();
+    measure(WEB_MAX_CONNECTIONS, runMs);
+    measure(WEB_MAX_CONNECTIONS * 2, runMs);
+    return hostReport("bench_web");
+}
@@ -0,0 +1,124 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+// Shared by the host tests and benchmarks: a check macro that keeps going
+// after a failure, timing statistics and clip fixtures on the host SPIFFS.
+
+#include <algorithm>
+#include <vector>
+#include <math.h>
+#include "Arduino.h"
+#include "SPIFFS.h"
+#include "ima_adpcm.h"
+
+inline int &hostFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                                 \
+    do {                                                                                 \
+        if (!(condition)) {                                                              \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            hostFailures()++;                                                            \
+        }                                                                                \
+    } while (0)
+
+// Exit code for main()
+inline int hostReport(const char *name) {
+    if (hostFailures() > 0) {
+        printf("%s: %d checks failed\n", name, hostFailures());
+        return 1;
+    }
+    printf("%s: all checks passed\n", name);
+    return 0;
+}
+
+// Benchmarks take --quick, which ctest passes to keep the run short
+inline bool hostQuick(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Sorted samples with percentiles
+struct HostStats {
+    std::vector<double> values;
+
+    void add(double value) { values.push_back(value); }
+    double percentile(double p) {
+        if (values.empty()) {
+            return 0.0;
+        }
+        std::sort(values.begin(), values.end());
+        size_t index = (size_t)(p / 100.0 * (values.size() - 1) + 0.5);
+        return values[index];
+    }
+    double max() { return percentile(100.0); }
+};
+
+// Empty SPIFFS in a directory of its own below the working directory
+inline void hostMountSpiffs(const char *directory) {
+    SPIFFS.setRoot(directory);
+    SPIFFS.begin();
+    SPIFFS.wipe();
+    SPIFFS.mkdir("/audio");
+}
+
+// Writes a mono IMA-ADPCM clip as clip_transcoder.h would: a sine tone of
+// the given length, amplitude of full scale and frequency
+inline bool hostWriteAdpcmClip(const char *path, uint32_t sampleRate, uint32_t ms, float amplitude = 0.5f,
+                               float hz = 440.0f) {
+    File file = SPIFFS.open(path, "w");
+    if (!file) {
+        return false;
+    }
+    uint32_t total = (uint32_t)((uint64_t)sampleRate * ms / 1000);
+    AdpcmFileHeader header = {{'I', 'M', 'A', 'D'}, 1, 1, (uint16_t)ADPCM_BLOCK_BYTES, sampleRate, total};
+    file.write((const uint8_t *)&header, sizeof(header));
+
+    AdpcmState state = {0, 0};
+    int16_t pcm[ADPCM_BLOCK_SAMPLES];
+    uint8_t block[ADPCM_BLOCK_BYTES];
+    for (uint32_t done = 0; done < total;) {
+        size_t count = total - done < ADPCM_BLOCK_SAMPLES ? total - done : ADPCM_BLOCK_SAMPLES;
+        for (size_t i = 0; i < count; i++) {
+            pcm[i] = (int16_t)(amplitude * 32767.0f * sinf(2.0f * (float)M_PI * hz * (done + i) / sampleRate));
+        }
+        // A tone that starts at zero would make the first sample silent
+        if (done == 0) {
+            pcm[0] = (int16_t)(amplitude * 1000.0f);
+        }
+        size_t bytes = adpcmEncodeBlock(pcm, count, block, state);
+        file.write(block, bytes);
+        done += count;
+    }
+    file.close();
+    return true;
+}
+
+// Writes an .mp3 clip for the host MP3 stand-in (stubs/AudioGeneratorMP3.h):
+// a 44.1 kHz stereo sine tone as raw 16-bit PCM
+inline bool hostWriteMp3Clip(const char *path, uint32_t ms, float amplitude = 0.5f, float hz = 440.0f) {
+    File file = SPIFFS.open(path, "w");
+    if (!file) {
+        return false;
+    }
+    uint32_t total = (uint32_t)((uint64_t)44100 * ms / 1000);
+    for (uint32_t i = 0; i < total; i++) {
+        int16_t sample = (int16_t)(amplitude * 32767.0f * sinf(2.0f * (float)M_PI * hz * i / 44100));
+        // A tone that starts at zero would make the first sample silent
+        if (i == 0) {
+            sample = (int16_t)(amplitude * 1000.0f);
+        }
+        int16_t frame[2] = {sample, sample};
+        file.write((const uint8_t *)frame, sizeof(frame));
+    }
+    file.close();
+    return true;
+}
+
+#endif
@@ -0,0 +1,273 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Stand-in for the parts of the ESP32 Arduino core that the firmware headers
+// use, so they build and run on a PC (see CMakeLists.txt). Time comes from
+// the host's steady clock, or from a manual clock a test moves itself.
+// FreeRTOS tasks are not started: tests call update() and friends directly.
+// Serial output is dropped unless AUDIOPAD_HOST_SERIAL is set.
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+#define PROGMEM
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+typedef uint8_t byte;
+
+// Clock
+
+struct HostClock {
+    std::atomic<bool> manual{false};
+    std::atomic<uint64_t> manualMicros{0};
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+};
+
+inline HostClock &hostClock() {
+    static HostClock clock;
+    return clock;
+}
+
+// Microseconds since start, never wrapping
+inline uint64_t hostMicros64() {
+    HostClock &clock = hostClock();
+    if (clock.manual) {
+        return clock.manualMicros;
+    }
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - clock.started)
+        .count();
+}
+
+// Freezes the clock at its current value; from then on only hostAdvanceMicros() moves it
+inline void hostUseManualClock() {
+    HostClock &clock = hostClock();
+    clock.manualMicros = hostMicros64();
+    clock.manual = true;
+}
+
+inline void hostAdvanceMicros(uint64_t us) {
+    hostClock().manualMicros += us;
+}
+
+// 32 bits wide like on the ESP32, so wrap-around arithmetic behaves the same
+inline unsigned long micros() { return (uint32_t)hostMicros64(); }
+inline unsigned long millis() { return (uint32_t)(hostMicros64() / 1000); }
+
+inline void delayMicroseconds(uint32_t us) {
+    if (hostClock().manual) {
+        hostAdvanceMicros(us);
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+    }
+}
+
+inline void delay(uint32_t ms) { delayMicroseconds(ms * 1000); }
+inline void yield() { std::this_thread::yield(); }
+
+template<typename T, typename L, typename H>
+inline T constrain(T value, L low, H high) {
+    return value < low ? low : value > high ? high : value;
+}
+
+// GPIO and ADC levels are whatever the test set
+
+inline int &hostPinLevel(int pin) {
+    static int levels[64];
+    return levels[pin & 63];
+}
+
+inline void pinMode(int, int) {}
+inline int digitalRead(int pin) { return hostPinLevel(pin); }
+inline void digitalWrite(int pin, int level) { hostPinLevel(pin) = level; }
+inline int analogRead(int pin) { return hostPinLevel(pin); }
+
+// Serial
+
+class HostSerial {
+private:
+    bool enabled;
+
+public:
+    HostSerial() : enabled(getenv("AUDIOPAD_HOST_SERIAL") != nullptr) {}
+    void begin(unsigned long) {}
+    void flush() { fflush(stdout); }
+
+    // No format checking: the firmware prints size_t with %u, which is right on the 32-bit ESP32
+    size_t printf(const char *format, ...) {
+        if (!enabled) {
+            return 0;
+        }
+        va_list args;
+        va_start(args, format);
+        int n = vprintf(format, args);
+        va_end(args);
+        return n > 0 ? n : 0;
+    }
+    size_t print(const char *text) { return printf("%s", text); }
+    size_t println(const char *text = "") { return printf("%s\n", text); }
+};
+
+inline HostSerial Serial;
+
+// Heap and chip
+
+#define MALLOC_CAP_8BIT (1 << 2)
+
+typedef struct {
+    size_t total_free_bytes;
+    size_t total_allocated_bytes;
+    size_t largest_free_block;
+    size_t minimum_free_bytes;
+    size_t allocated_blocks;
+    size_t free_blocks;
+    size_t total_blocks;
+} multi_heap_info_t;
+
+// The host heap has no block count; tests that care count allocations themselves
+inline void heap_caps_get_info(multi_heap_info_t *info, uint32_t) { memset(info, 0, sizeof(*info)); }
+
+inline bool psramFound() { return false; }
+inline void *ps_malloc(size_t size) { return malloc(size); }
+
+// Seeded, so runs repeat
+inline uint32_t esp_random() {
+    static std::mt19937 generator(12345);
+    return generator();
+}
+
+// FreeRTOS: no tasks are created, so the firmware runs its fallback paths
+
+typedef void *TaskHandle_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY 0xFFFFFFFFUL
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+inline BaseType_t xTaskCreatePinnedToCore(void (*)(void *), const char *, uint32_t, void *, UBaseType_t,
+                                          TaskHandle_t *handle, BaseType_t) {
+    if (handle) {
+        *handle = nullptr;
+    }
+    return pdFAIL;
+}
+
+inline void vTaskDelete(TaskHandle_t) {}
+inline void vTaskDelay(TickType_t ticks) { delay(ticks); }
+inline void xTaskNotifyGive(TaskHandle_t) {}
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+inline TickType_t xTaskGetTickCount() { return millis(); }
+
+// Binary semaphores on the wall clock, so a timed wait ends under the manual clock too
+struct HostSemaphore {
+    std::atomic<bool> given{false};
+};
+typedef HostSemaphore *SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary() { return new HostSemaphore(); }
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    semaphore->given = true;
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ticks);
+    while (!semaphore->given.exchange(false)) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return pdFALSE;
+        }
+        std::this_thread::yield();
+    }
+    return pdTRUE;
+}
+
+// Mutexes are binary semaphores that start out given
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+    SemaphoreHandle_t mutex = new HostSemaphore();
+    mutex->given = true;
+    return mutex;
+}
+
+inline void vTaskDelayUntil(TickType_t *lastWake, TickType_t ticks) {
+    *lastWake += ticks;
+    while ((int32_t)(xTaskGetTickCount() - *lastWake) < 0) {
+        vTaskDelay(1);
+    }
+}
+
+// Queues copy fixed-size items through a ring. No task ever runs on the
+// other end, so a send to a full queue and a receive from an empty one fail
+// at once instead of waiting.
+struct HostQueue {
+    uint8_t *items;
+    size_t itemSize;
+    UBaseType_t length;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+typedef HostQueue *QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, size_t itemSize) {
+    return new HostQueue{(uint8_t *)malloc(length * itemSize), itemSize, length, 0, 0};
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t) {
+    if (queue->count == queue->length) {
+        return pdFALSE;
+    }
+    memcpy(queue->items + (queue->head + queue->count) % queue->length * queue->itemSize, item, queue->itemSize);
+    queue->count++;
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t) {
+    if (queue->count == 0) {
+        return pdFALSE;
+    }
+    memcpy(item, queue->items + queue->head * queue->itemSize, queue->itemSize);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    return pdTRUE;
+}
+
+// Critical sections are a real spinlock, as tests may run several threads
+struct portMUX_TYPE {
+    std::atomic<int> owner;
+};
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+inline void portENTER_CRITICAL(portMUX_TYPE *mux) {
+    while (mux->owner.exchange(1, std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+inline void portEXIT_CRITICAL(portMUX_TYPE *mux) { mux->owner.store(0, std::memory_order_release); }
+
+#include "WString.h"
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef HOST_AUDIO_FILE_SOURCE_ID3_H
+#define HOST_AUDIO_FILE_SOURCE_ID3_H
+
+#include "AudioFileSource.h"
+
+// Passes the source through; the host MP3 stand-in reads raw PCM without tags
+class AudioFileSourceID3 : public AudioFileSource {
+private:
+    AudioFileSource *src;
+
+public:
+    explicit AudioFileSourceID3(AudioFileSource *source) : src(source) {}
+    virtual uint32_t read(void *data, uint32_t len) override { return src->read(data, len); }
+    virtual bool seek(int32_t pos, int dir) override { return src->seek(pos, dir); }
+    virtual bool close() override { return src->close(); }
+    virtual bool isOpen() override { return src->isOpen(); }
+    virtual uint32_t getSize() override { return src->getSize(); }
+    virtual uint32_t getPos() override { return src->getPos(); }
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef HOST_AUDIO_FILE_SOURCE_SPIFFS_H
+#define HOST_AUDIO_FILE_SOURCE_SPIFFS_H
+
+#include "AudioFileSource.h"
+#include "SPIFFS.h"
+
+// Reads a file through the host SPIFFS
+class AudioFileSourceSPIFFS : public AudioFileSource {
+private:
+    File file;
+
+public:
+    AudioFileSourceSPIFFS() {}
+    explicit AudioFileSourceSPIFFS(const char *filename) { open(filename); }
+    virtual bool open(const char *filename) override {
+        file = SPIFFS.open(filename, "r");
+        return (bool)file;
+    }
+    virtual uint32_t read(void *data, uint32_t len) override { return file.read((uint8_t *)data, len); }
+    virtual bool seek(int32_t pos, int dir) override {
+        if (dir == SEEK_CUR) {
+            pos += file.position();
+        } else if (dir == SEEK_END) {
+            pos += file.size();
+        }
+        return file.seek(pos);
+    }
+    virtual bool close() override {
+        file.close();
+        return true;
+    }
+    virtual bool isOpen() override { return (bool)file; }
+    virtual uint32_t getSize() override { return file.size(); }
+    virtual uint32_t getPos() override { return file.position(); }
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef HOST_AUDIO_GENERATOR_H
+#define HOST_AUDIO_GENERATOR_H
+
+#include "AudioFileSource.h"
+#include "AudioOutput.h"
+
+// ESP8266Audio's decoder base class
+class AudioGenerator {
+public:
+    AudioGenerator() : running(false), file(nullptr), output(nullptr) { lastSample[0] = lastSample[1] = 0; }
+    virtual ~AudioGenerator() {}
+    virtual bool begin(AudioFileSource *source, AudioOutput *output) {
+        (void)source;
+        (void)output;
+        return false;
+    }
+    virtual bool loop() { return false; }
+    virtual bool stop() { return false; }
+    virtual bool isRunning() { return false; }
+
+protected:
+    bool running;
+    AudioFileSource *file;
+    AudioOutput *output;
+    int16_t lastSample[2];
+};
+
+#endif
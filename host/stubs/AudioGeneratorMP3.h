@@ -0,0 +1,102 @@
+#ifndef HOST_AUDIO_GENERATOR_MP3_H
+#define HOST_AUDIO_GENERATOR_MP3_H
+
+#include "AudioGenerator.h"
+
+// How the stand-in decoder below is timed. Both default to 0; a benchmark
+// calls modelHelix() to compare against the real decoder.
+struct HostMp3Model {
+    unsigned long startUs = 0; // Spent in begin(), before the first frame
+    unsigned long frameUs = 0; // Spent decoding each frame
+
+    // Roughly Helix on a 240 MHz ESP32 with 44.1 kHz stereo: tens of ms to
+    // the first frame, then about a tenth of real time
+    void modelHelix() {
+        startUs = 30000;
+        frameUs = 2500;
+    }
+};
+
+inline HostMp3Model &hostMp3() {
+    static HostMp3Model model;
+    return model;
+}
+
+// The Helix MP3 decoder is not built on the host. This stand-in reads .mp3
+// clips as raw 44.1 kHz stereo 16-bit PCM (see hostWriteMp3Clip()) in MP3
+// frames of 1152 samples, and busy-waits as hostMp3() says.
+class AudioGeneratorMP3 : public AudioGenerator {
+private:
+    static const uint32_t FRAME_SAMPLES = 1152;
+    int16_t frame[FRAME_SAMPLES * 2];
+    uint32_t frameFrames;
+    uint32_t framePos;
+
+    static void spin(unsigned long us) {
+        unsigned long started = micros();
+        while (micros() - started < us) {
+        }
+    }
+
+    bool decodeFrame() {
+        uint32_t bytes = file->read(frame, sizeof(frame));
+        frameFrames = bytes / (2 * sizeof(int16_t));
+        framePos = 0;
+        spin(hostMp3().frameUs);
+        return frameFrames > 0;
+    }
+
+public:
+    AudioGeneratorMP3() : frameFrames(0), framePos(0) {}
+    AudioGeneratorMP3(void *space, int size) : frameFrames(0), framePos(0) {
+        (void)space;
+        (void)size;
+    }
+    static constexpr int preAllocSize() { return 29 * 1024; }
+    virtual bool begin(AudioFileSource *source, AudioOutput *output) override {
+        if (!source || !output) {
+            return false;
+        }
+        file = source;
+        this->output = output;
+        spin(hostMp3().startUs);
+        output->SetRate(44100);
+        output->SetBitsPerSample(16);
+        output->SetChannels(2);
+        if (!output->begin()) {
+            return false;
+        }
+        frameFrames = 0;
+        framePos = 0;
+        running = true;
+        return true;
+    }
+    virtual bool loop() override {
+        if (!running) {
+            return false;
+        }
+        while (true) {
+            if (framePos == frameFrames && !decodeFrame()) {
+                running = false;
+                return false;
+            }
+            if (!output->ConsumeSample(&frame[framePos * 2])) {
+                return true; // Output full, continue on the next loop()
+            }
+            framePos++;
+        }
+    }
+    virtual bool stop() override {
+        running = false;
+        if (output) {
+            output->stop();
+        }
+        if (file) {
+            file->close();
+        }
+        return true;
+    }
+    virtual bool isRunning() override { return running; }
+};
+
+#endif
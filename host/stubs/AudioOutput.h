@@ -0,0 +1,53 @@
+#ifndef HOST_AUDIO_OUTPUT_H
+#define HOST_AUDIO_OUTPUT_H
+
+#include "Arduino.h"
+
+// ESP8266Audio's output base class, same members and defaults
+class AudioOutput {
+public:
+    AudioOutput() : hertz(44100), bps(16), channels(2), gainF2P6(64) {}
+    virtual ~AudioOutput() {}
+    virtual bool SetRate(int hz) {
+        hertz = hz;
+        return true;
+    }
+    virtual bool SetBitsPerSample(int bits) {
+        bps = bits;
+        return true;
+    }
+    virtual bool SetChannels(int chan) {
+        channels = chan;
+        return true;
+    }
+    virtual bool SetGain(float f) {
+        gainF2P6 = (uint8_t)(f * (1 << 6));
+        return true;
+    }
+    virtual bool begin() { return false; }
+    typedef enum { LEFTCHANNEL = 0, RIGHTCHANNEL = 1 } SampleIndex;
+    virtual bool ConsumeSample(int16_t sample[2]) {
+        (void)sample;
+        return false;
+    }
+    virtual bool stop() { return false; }
+    virtual void flush() {}
+
+protected:
+    void MakeSampleStereo16(int16_t sample[2]) {
+        if (bps == 8) {
+            sample[LEFTCHANNEL] = (((int16_t)(sample[LEFTCHANNEL] & 0xff)) - 128) << 8;
+            sample[RIGHTCHANNEL] = (((int16_t)(sample[RIGHTCHANNEL] & 0xff)) - 128) << 8;
+        }
+        if (channels == 1) {
+            sample[RIGHTCHANNEL] = sample[LEFTCHANNEL];
+        }
+    }
+
+    uint16_t hertz;
+    uint8_t bps;
+    uint8_t channels;
+    uint8_t gainF2P6;
+};
+
+#endif
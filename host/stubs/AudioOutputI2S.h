@@ -0,0 +1,116 @@
+#ifndef HOST_AUDIO_OUTPUT_I2S_H
+#define HOST_AUDIO_OUTPUT_I2S_H
+
+#include "AudioOutput.h"
+
+// What the I2S output did, for tests and benchmarks to read
+struct HostI2SProbe {
+    uint64_t framesQueued = 0;
+    uint64_t silentFrames = 0; // Played while the DMA buffers were empty and the output running
+    bool armed = false;
+    unsigned long soundAt = 0; // micros() of the first non-zero sample queued since arm()
+
+    void arm() {
+        armed = true;
+        soundAt = 0;
+    }
+    bool heard() const { return !armed && soundAt != 0; }
+};
+
+inline HostI2SProbe &hostI2S() {
+    static HostI2SProbe probe;
+    return probe;
+}
+
+// I2S output that plays into nothing in real time. It holds DMA_FRAMES like
+// the driver's 8 DMA buffers and drains them at the sample rate by the host
+// clock, so ConsumeSample() refuses when the real output would.
+class AudioOutputI2S : public AudioOutput {
+private:
+    uint64_t clockedFrom; // Clock time of the last start or rate change
+    uint64_t drained;     // Frames played since then, so rounding never accumulates
+    uint32_t buffered;
+    bool running;
+
+    void drain() {
+        if (!running) {
+            return;
+        }
+        uint64_t frames = (hostMicros64() - clockedFrom) * hertz / 1000000 - drained;
+        if (frames == 0) {
+            return;
+        }
+        drained += frames;
+        if (frames > buffered) {
+            hostI2S().silentFrames += frames - buffered;
+            frames = buffered;
+        }
+        buffered -= frames;
+    }
+
+public:
+    static const uint32_t DMA_FRAMES = 8 * 128;
+
+    AudioOutputI2S(int port = 0, int outputMode = 0, int dmaBufferCount = 8, int useApll = 0)
+        : clockedFrom(0), drained(0), buffered(0), running(false) {
+        (void)port;
+        (void)outputMode;
+        (void)dmaBufferCount;
+        (void)useApll;
+    }
+
+    bool SetPinout(int bclk, int wclk, int dout) {
+        (void)bclk;
+        (void)wclk;
+        (void)dout;
+        return true;
+    }
+
+    virtual bool SetRate(int hz) override {
+        drain();
+        clockedFrom = hostMicros64();
+        drained = 0;
+        return AudioOutput::SetRate(hz);
+    }
+
+    virtual bool begin() override {
+        if (!running) {
+            running = true;
+            buffered = 0;
+            clockedFrom = hostMicros64();
+            drained = 0;
+        }
+        return true;
+    }
+
+    virtual bool ConsumeSample(int16_t sample[2]) override {
+        if (!running) {
+            return false;
+        }
+        drain();
+        if (buffered >= DMA_FRAMES) {
+            return false;
+        }
+        buffered++;
+        HostI2SProbe &probe = hostI2S();
+        probe.framesQueued++;
+        if (probe.armed && (sample[0] != 0 || sample[1] != 0)) {
+            probe.soundAt = micros();
+            probe.armed = false;
+        }
+        return true;
+    }
+
+    virtual bool stop() override {
+        running = false;
+        buffered = 0;
+        return true;
+    }
+
+    uint32_t getBuffered() {
+        drain();
+        return buffered;
+    }
+};
+
+#endif
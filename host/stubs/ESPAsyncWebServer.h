@@ -0,0 +1,339 @@
+#ifndef HOST_ESP_ASYNC_WEB_SERVER_H
+#define HOST_ESP_ASYNC_WEB_SERVER_H
+
+// ESPAsyncWebServer without AsyncTCP. A test builds an AsyncWebServerRequest,
+// hands it to a handler or to AsyncWebServer::hostHandle() and reads back
+// the status and body that were sent. As in the library, a request owns its
+// response until it is destroyed, which is also when its disconnect handler
+// runs and its _tempObject is freed.
+
+#include <functional>
+#include <vector>
+#include "Arduino.h"
+
+class AsyncWebServerRequest;
+
+typedef enum {
+    HTTP_GET = 0b00000001,
+    HTTP_POST = 0b00000010,
+    HTTP_DELETE = 0b00000100,
+    HTTP_PUT = 0b00001000,
+    HTTP_PATCH = 0b00010000,
+    HTTP_HEAD = 0b00100000,
+    HTTP_OPTIONS = 0b01000000,
+    HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+typedef uint8_t WebRequestMethodComposite;
+
+typedef std::function<void(void)> ArDisconnectHandler;
+typedef std::function<void(AsyncWebServerRequest *)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *, const String &, size_t, uint8_t *, size_t, bool)>
+    ArUploadHandlerFunction;
+
+class AsyncWebParameter {
+private:
+    String _name;
+    String _value;
+    bool _post;
+
+public:
+    AsyncWebParameter() : _post(false) {}
+    AsyncWebParameter(const String &name, const String &value, bool post) : _name(name), _value(value), _post(post) {}
+    const String &name() const { return _name; }
+    const String &value() const { return _value; }
+    bool isPost() const { return _post; }
+};
+
+class AsyncWebHeader {
+private:
+    String _name;
+    String _value;
+
+public:
+    AsyncWebHeader() {}
+    AsyncWebHeader(const String &name, const String &value) : _name(name), _value(value) {}
+    const String &name() const { return _name; }
+    const String &value() const { return _value; }
+};
+
+class AsyncWebServerResponse {
+protected:
+    int _code;
+    String _contentType;
+    size_t _contentLength;
+    std::vector<AsyncWebHeader> _headers; // A list of heap nodes in the library, so adding one allocates too
+
+public:
+    AsyncWebServerResponse() : _code(0), _contentLength(0) {}
+    virtual ~AsyncWebServerResponse() {}
+    void addHeader(const String &name, const String &value) { _headers.push_back(AsyncWebHeader(name, value)); }
+    virtual bool _sourceValid() const { return false; }
+    virtual void _respond(AsyncWebServerRequest *request);
+
+    // Host only
+    int hostCode() const { return _code; }
+    const char *hostContentType() const { return _contentType.c_str(); }
+    const char *hostHeader(const char *name) const {
+        for (const AsyncWebHeader &header : _headers) {
+            if (header.name() == name) {
+                return header.value().c_str();
+            }
+        }
+        return nullptr;
+    }
+};
+
+// Sends whatever _fillBuffer() produces
+class AsyncAbstractResponse : public AsyncWebServerResponse {
+public:
+    AsyncAbstractResponse() {}
+    void _respond(AsyncWebServerRequest *request) override;
+    virtual size_t _fillBuffer(uint8_t *buf, size_t maxLen) {
+        (void)buf;
+        (void)maxLen;
+        return 0;
+    }
+};
+
+// beginResponse() and beginResponse_P(): a body that is already in memory
+class AsyncBasicResponse : public AsyncWebServerResponse {
+private:
+    const uint8_t *content;
+
+public:
+    AsyncBasicResponse(int code, const String &contentType = String(), const uint8_t *data = nullptr,
+                       size_t length = 0)
+        : content(data) {
+        _code = code;
+        _contentType = contentType;
+        _contentLength = length;
+    }
+    bool _sourceValid() const override { return true; }
+    void _respond(AsyncWebServerRequest *request) override;
+};
+
+class AsyncClient {
+public:
+    void close(bool now = false) { (void)now; }
+};
+
+class AsyncWebServerRequest {
+private:
+    static const int MAX_PARAMS = 8;
+    static const int MAX_HEADERS = 4;
+
+    WebRequestMethod _method;
+    String _url;
+    AsyncWebParameter _params[MAX_PARAMS];
+    int _paramCount;
+    AsyncWebHeader _requestHeaders[MAX_HEADERS];
+    int _headerCount;
+    AsyncWebServerResponse *_response;
+    ArDisconnectHandler _onDisconnect;
+    char _body[8192]; // What was sent, NUL terminated
+    size_t _bodyLength;
+
+public:
+    void *_tempObject;
+
+    AsyncWebServerRequest(WebRequestMethod method, const char *url)
+        : _method(method), _url(url), _paramCount(0), _headerCount(0), _response(nullptr), _bodyLength(0),
+          _tempObject(nullptr) {
+        _body[0] = '\0';
+    }
+    AsyncWebServerRequest(const AsyncWebServerRequest &) = delete;
+    AsyncWebServerRequest &operator=(const AsyncWebServerRequest &) = delete;
+    ~AsyncWebServerRequest() {
+        if (_onDisconnect) {
+            _onDisconnect();
+        }
+        delete _response;
+        free(_tempObject);
+    }
+
+    WebRequestMethod method() const { return _method; }
+    const String &url() const { return _url; }
+
+    bool hasParam(const String &name, bool post = false, bool file = false) const {
+        return getParam(name, post, file) != nullptr;
+    }
+    AsyncWebParameter *getParam(const String &name, bool post = false, bool file = false) const {
+        (void)file;
+        for (int i = 0; i < _paramCount; i++) {
+            if (_params[i].isPost() == post && _params[i].name() == name) {
+                return const_cast<AsyncWebParameter *>(&_params[i]);
+            }
+        }
+        return nullptr;
+    }
+    bool hasHeader(const String &name) const {
+        for (int i = 0; i < _headerCount; i++) {
+            if (_requestHeaders[i].name() == name) {
+                return true;
+            }
+        }
+        return false;
+    }
+    const String &header(const char *name) const {
+        static const String empty;
+        for (int i = 0; i < _headerCount; i++) {
+            if (_requestHeaders[i].name() == name) {
+                return _requestHeaders[i].value();
+            }
+        }
+        return empty;
+    }
+
+    void onDisconnect(ArDisconnectHandler fn) { _onDisconnect = fn; }
+
+    AsyncWebServerResponse *beginResponse(int code, const String &contentType = String(),
+                                          const String &content = String()) {
+        (void)content;
+        return new AsyncBasicResponse(code, contentType);
+    }
+    AsyncWebServerResponse *beginResponse_P(int code, const String &contentType, const uint8_t *content,
+                                            size_t len) {
+        return new AsyncBasicResponse(code, contentType, content, len);
+    }
+    void send(AsyncWebServerResponse *response) {
+        delete _response;
+        _response = response;
+        _bodyLength = 0;
+        _body[0] = '\0';
+        _response->_respond(this);
+    }
+
+    // Host only: what the request carries and what was sent back
+    void hostAddParam(const char *name, const char *value, bool post = false) {
+        if (_paramCount < MAX_PARAMS) {
+            _params[_paramCount++] = AsyncWebParameter(name, value, post);
+        }
+    }
+    void hostAddHeader(const char *name, const char *value) {
+        if (_headerCount < MAX_HEADERS) {
+            _requestHeaders[_headerCount++] = AsyncWebHeader(name, value);
+        }
+    }
+    void hostSend(const uint8_t *data, size_t length) {
+        if (length > sizeof(_body) - 1 - _bodyLength) {
+            length = sizeof(_body) - 1 - _bodyLength;
+        }
+        memcpy(_body + _bodyLength, data, length);
+        _bodyLength += length;
+        _body[_bodyLength] = '\0';
+    }
+    const AsyncWebServerResponse *hostResponse() const { return _response; }
+    int hostCode() const { return _response ? _response->hostCode() : 0; }
+    const char *hostBody() const { return _body; }
+    size_t hostBodyLength() const { return _bodyLength; }
+};
+
+inline void AsyncWebServerResponse::_respond(AsyncWebServerRequest *request) { (void)request; }
+
+// The library sends in pieces as the socket has room; here it all goes at once
+inline void AsyncAbstractResponse::_respond(AsyncWebServerRequest *request) {
+    uint8_t chunk[512];
+    size_t sent = 0;
+    while (sent < _contentLength) {
+        size_t n = _fillBuffer(chunk, sizeof(chunk));
+        if (n == 0) {
+            break;
+        }
+        request->hostSend(chunk, n);
+        sent += n;
+    }
+}
+
+inline void AsyncBasicResponse::_respond(AsyncWebServerRequest *request) {
+    if (content) {
+        request->hostSend(content, _contentLength);
+    }
+}
+
+class AsyncWebHandler {
+public:
+    virtual ~AsyncWebHandler() {}
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {};
+
+class AsyncEventSourceClient {
+private:
+    AsyncClient _client;
+
+public:
+    AsyncClient *client() { return &_client; }
+};
+
+typedef std::function<void(AsyncEventSourceClient *)> ArEventHandlerFunction;
+
+// No subscribers ever connect on the host
+class AsyncEventSource : public AsyncWebHandler {
+public:
+    explicit AsyncEventSource(const String &url) { (void)url; }
+    void onConnect(ArEventHandlerFunction fn) { (void)fn; }
+    void send(const char *message, const char *event = nullptr, uint32_t id = 0, uint32_t reconnect = 0) {
+        (void)message;
+        (void)event;
+        (void)id;
+        (void)reconnect;
+    }
+    size_t count() const { return 0; }
+};
+
+class AsyncWebServer {
+private:
+    struct Route {
+        String uri;
+        WebRequestMethodComposite method;
+        ArRequestHandlerFunction onRequest;
+    };
+    std::vector<Route> routes;
+    ArRequestHandlerFunction notFound;
+    AsyncCallbackWebHandler handler;
+
+public:
+    explicit AsyncWebServer(uint16_t port) {
+        (void)port;
+        hostLatest() = this;
+    }
+    ~AsyncWebServer() {
+        if (hostLatest() == this) {
+            hostLatest() = nullptr;
+        }
+    }
+    AsyncCallbackWebHandler &on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest) {
+        routes.push_back({uri, method, onRequest});
+        return handler;
+    }
+    // Uploads are not fed through the host server
+    AsyncCallbackWebHandler &on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                                ArUploadHandlerFunction onUpload) {
+        (void)onUpload;
+        return on(uri, method, onRequest);
+    }
+    AsyncWebHandler &addHandler(AsyncWebHandler *added) { return *added; }
+    void onNotFound(ArRequestHandlerFunction fn) { notFound = fn; }
+    void begin() {}
+    void end() {}
+
+    // Host only: the server most recently created, e.g. inside a WebServerManager
+    static AsyncWebServer *&hostLatest() {
+        static AsyncWebServer *latest = nullptr;
+        return latest;
+    }
+    // Host only: routes the request as the library would once its headers and body are in
+    void hostHandle(AsyncWebServerRequest *request) {
+        for (Route &route : routes) {
+            if ((route.method & request->method()) && route.uri == request->url()) {
+                route.onRequest(request);
+                return;
+            }
+        }
+        if (notFound) {
+            notFound(request);
+        }
+    }
+};
+
+#endif
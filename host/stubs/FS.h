@@ -0,0 +1,169 @@
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+// Arduino FS API over a directory of the host filesystem. Paths such as
+// "/audio/button1.mp3" resolve below the root given to SPIFFS.begin().
+// Like the ESP32 core, File is a shared handle and name() has no directory.
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+#include "Arduino.h"
+
+namespace fs {
+
+class File {
+private:
+    struct Handle {
+        FILE *stream = nullptr;
+        std::string path; // On the host
+        std::string name;
+        bool directory = false;
+        std::filesystem::directory_iterator next;
+
+        ~Handle() {
+            if (stream) {
+                fclose(stream);
+            }
+        }
+    };
+    std::shared_ptr<Handle> handle;
+
+public:
+    File() {}
+
+    static File open(const std::string &hostPath, const char *mode) {
+        File file;
+        std::error_code error;
+        bool directory = std::filesystem::is_directory(hostPath, error);
+        if (directory && mode[0] != 'r') {
+            return file;
+        }
+        FILE *stream = nullptr;
+        if (!directory) {
+            // SPIFFS has no real directories, writing anywhere works
+            if (mode[0] != 'r') {
+                std::filesystem::create_directories(std::filesystem::path(hostPath).parent_path(), error);
+            }
+            stream = fopen(hostPath.c_str(), mode[0] == 'w' ? "w+b" : mode[0] == 'a' ? "a+b" : "rb");
+            if (!stream) {
+                return file;
+            }
+        }
+        file.handle = std::make_shared<Handle>();
+        file.handle->stream = stream;
+        file.handle->path = hostPath;
+        file.handle->name = std::filesystem::path(hostPath).filename().string();
+        file.handle->directory = directory;
+        if (directory) {
+            file.handle->next = std::filesystem::directory_iterator(hostPath, error);
+        }
+        return file;
+    }
+
+    explicit operator bool() const { return handle != nullptr; }
+
+    size_t read(uint8_t *buffer, size_t length) {
+        return handle && handle->stream ? fread(buffer, 1, length, handle->stream) : 0;
+    }
+
+    int read() {
+        uint8_t byte;
+        return read(&byte, 1) == 1 ? byte : -1;
+    }
+
+    size_t write(const uint8_t *buffer, size_t length) {
+        return handle && handle->stream ? fwrite(buffer, 1, length, handle->stream) : 0;
+    }
+
+    size_t write(uint8_t byte) { return write(&byte, 1); }
+
+    bool seek(uint32_t position) {
+        return handle && handle->stream && fseek(handle->stream, position, SEEK_SET) == 0;
+    }
+
+    size_t position() const { return handle && handle->stream ? ftell(handle->stream) : 0; }
+
+    size_t size() const {
+        if (!handle || !handle->stream) {
+            return 0;
+        }
+        // fstat rather than std::filesystem, which allocates; the press path calls this
+        fflush(handle->stream);
+        struct stat info;
+        return fstat(fileno(handle->stream), &info) == 0 ? info.st_size : 0;
+    }
+
+    int available() { return (int)(size() - position()); }
+    void flush() {
+        if (handle && handle->stream) {
+            fflush(handle->stream);
+        }
+    }
+    void close() { handle.reset(); }
+    const char *name() const { return handle ? handle->name.c_str() : ""; }
+    bool isDirectory() const { return handle && handle->directory; }
+
+    File openNextFile() {
+        if (!isDirectory()) {
+            return File();
+        }
+        std::filesystem::directory_iterator end;
+        while (handle->next != end) {
+            std::filesystem::path path = handle->next->path();
+            handle->next++;
+            if (std::filesystem::is_regular_file(path)) {
+                return open(path.string(), "r");
+            }
+        }
+        return File();
+    }
+};
+
+class FS {
+private:
+    std::string root;
+
+protected:
+    std::string hostPath(const char *path) const { return root + path; }
+
+public:
+    void setRoot(const std::string &directory) { root = directory; }
+
+    File open(const char *path, const char *mode = "r") { return File::open(hostPath(path), mode); }
+
+    bool exists(const char *path) {
+        std::error_code error;
+        return std::filesystem::exists(hostPath(path), error);
+    }
+
+    bool remove(const char *path) {
+        std::error_code error;
+        return std::filesystem::remove(hostPath(path), error);
+    }
+
+    bool rename(const char *from, const char *to) {
+        std::error_code error;
+        std::filesystem::rename(hostPath(from), hostPath(to), error);
+        return !error;
+    }
+
+    File open(const String &path, const char *mode = "r") { return open(path.c_str(), mode); }
+    bool exists(const String &path) { return exists(path.c_str()); }
+    bool remove(const String &path) { return remove(path.c_str()); }
+    bool rename(const String &from, const String &to) { return rename(from.c_str(), to.c_str()); }
+
+    bool mkdir(const char *path) {
+        std::error_code error;
+        std::filesystem::create_directories(hostPath(path), error);
+        return !error;
+    }
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+
+#endif
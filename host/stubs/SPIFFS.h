@@ -0,0 +1,44 @@
+#ifndef HOST_SPIFFS_H
+#define HOST_SPIFFS_H
+
+#include "FS.h"
+
+// SPIFFS kept in a host directory, by default "spiffs" under the working
+// directory. Tests usually start from an empty one with wipe().
+class SPIFFSFS : public fs::FS {
+public:
+    bool begin(bool formatOnFail = false, const char *basePath = "/spiffs", uint8_t maxOpenFiles = 10,
+               const char *partitionLabel = nullptr) {
+        (void)formatOnFail;
+        (void)basePath;
+        (void)maxOpenFiles;
+        (void)partitionLabel;
+        if (hostPath("").empty()) {
+            setRoot("spiffs");
+        }
+        return mkdir("/");
+    }
+
+    // Host only: empties the directory
+    void wipe() {
+        std::error_code error;
+        std::filesystem::remove_all(hostPath(""), error);
+        mkdir("/");
+    }
+
+    size_t totalBytes() { return 1441792; } // Default 1.4MB SPIFFS partition
+    size_t usedBytes() {
+        size_t used = 0;
+        std::error_code error;
+        for (const auto &entry : std::filesystem::recursive_directory_iterator(hostPath(""), error)) {
+            if (entry.is_regular_file()) {
+                used += entry.file_size();
+            }
+        }
+        return used;
+    }
+};
+
+inline SPIFFSFS SPIFFS;
+
+#endif
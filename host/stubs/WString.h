@@ -0,0 +1,138 @@
+#ifndef HOST_WSTRING_H
+#define HOST_WSTRING_H
+
+// The Arduino core's String, with what the firmware headers use. Like the
+// ESP32 core's, up to 10 characters live inside the object, so short
+// request parameters do not touch the heap; longer ones are malloc()ed, a
+// buffer is reused when it is big enough and moving a String hands its
+// buffer over.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+class String {
+private:
+    static const size_t SSO_CAPACITY = 10;
+    char sso[SSO_CAPACITY + 1];
+    char *heap;
+    size_t len;
+    size_t cap;
+
+    char *buffer() { return heap ? heap : sso; }
+
+    bool reserve(size_t size) {
+        if (size <= cap) {
+            return true;
+        }
+        char *grown = (char *)realloc(heap, size + 1);
+        if (!grown) {
+            return false;
+        }
+        if (!heap) {
+            memcpy(grown, sso, len + 1);
+        }
+        heap = grown;
+        cap = size;
+        return true;
+    }
+
+    String &assign(const char *text, size_t count) {
+        if (!reserve(count)) {
+            return *this;
+        }
+        memmove(buffer(), text, count);
+        len = count;
+        buffer()[len] = '\0';
+        return *this;
+    }
+
+public:
+    String(const char *text = "") : heap(nullptr), len(0), cap(SSO_CAPACITY) {
+        sso[0] = '\0';
+        assign(text ? text : "", text ? strlen(text) : 0);
+    }
+    String(const String &other) : String() { assign(other.c_str(), other.len); }
+    explicit String(long value) : String() {
+        char digits[24];
+        snprintf(digits, sizeof(digits), "%ld", value);
+        assign(digits, strlen(digits));
+    }
+    explicit String(int value) : String((long)value) {}
+    explicit String(unsigned long value) : String() {
+        char digits[24];
+        snprintf(digits, sizeof(digits), "%lu", value);
+        assign(digits, strlen(digits));
+    }
+    String(String &&other) : String() { *this = static_cast<String &&>(other); }
+    ~String() { free(heap); }
+
+    String &operator=(const String &other) { return this == &other ? *this : assign(other.c_str(), other.len); }
+    String &operator=(const char *text) { return assign(text ? text : "", text ? strlen(text) : 0); }
+    String &operator=(String &&other) {
+        if (this == &other) {
+            return *this;
+        }
+        // As in the core: copied when it fits, and either way the other one ends up empty
+        if (cap >= other.len) {
+            assign(other.c_str(), other.len);
+            free(other.heap);
+        } else {
+            free(heap);
+            heap = other.heap;
+            len = other.len;
+            cap = other.cap;
+        }
+        other.heap = nullptr;
+        other.len = 0;
+        other.cap = SSO_CAPACITY;
+        other.sso[0] = '\0';
+        return *this;
+    }
+
+    String &concat(const char *text, size_t count) {
+        if (!reserve(len + count)) {
+            return *this;
+        }
+        memcpy(buffer() + len, text, count);
+        len += count;
+        buffer()[len] = '\0';
+        return *this;
+    }
+    String &operator+=(const char *text) { return concat(text, strlen(text)); }
+    String &operator+=(const String &other) { return concat(other.c_str(), other.len); }
+    friend String operator+(const String &left, const char *right) {
+        String joined(left);
+        joined += right;
+        return joined;
+    }
+
+    const char *c_str() const { return heap ? heap : sso; }
+    unsigned int length() const { return len; }
+    bool operator==(const char *text) const { return strcmp(c_str(), text) == 0; }
+    bool operator==(const String &other) const { return strcmp(c_str(), other.c_str()) == 0; }
+    bool operator!=(const char *text) const { return !(*this == text); }
+
+    long toInt() const { return atol(c_str()); }
+    float toFloat() const { return (float)atof(c_str()); }
+    int indexOf(char c, unsigned int from = 0) const {
+        if (from >= len) {
+            return -1;
+        }
+        const char *found = strchr(c_str() + from, c);
+        return found ? (int)(found - c_str()) : -1;
+    }
+    String substring(unsigned int from, unsigned int to) const {
+        String part;
+        if (to > len) {
+            to = len;
+        }
+        if (from < to) {
+            part.assign(c_str() + from, to - from);
+        }
+        return part;
+    }
+    String substring(unsigned int from) const { return substring(from, len); }
+};
+
+#endif
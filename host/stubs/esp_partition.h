@@ -0,0 +1,102 @@
+#ifndef HOST_ESP_PARTITION_H
+#define HOST_ESP_PARTITION_H
+
+// ESP-IDF partition API over a RAM buffer. There is no partition until a
+// test creates one with hostCreatePartition().
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+#define SPI_FLASH_SEC_SIZE 4096
+
+typedef enum { ESP_PARTITION_TYPE_APP = 0x00, ESP_PARTITION_TYPE_DATA = 0x01 } esp_partition_type_t;
+typedef int esp_partition_subtype_t;
+typedef enum { ESP_PARTITION_MMAP_DATA, ESP_PARTITION_MMAP_INST } esp_partition_mmap_memory_t;
+typedef uint32_t spi_flash_mmap_handle_t;
+
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+    bool encrypted;
+} esp_partition_t;
+
+struct HostPartition {
+    esp_partition_t info;
+    std::vector<uint8_t> flash;
+    bool present = false;
+};
+
+inline HostPartition &hostPartition() {
+    static HostPartition partition;
+    return partition;
+}
+
+// Erased flash reads as 0xFF
+inline void hostCreatePartition(const char *label, esp_partition_subtype_t subtype, uint32_t size) {
+    HostPartition &partition = hostPartition();
+    memset(&partition.info, 0, sizeof(partition.info));
+    partition.info.type = ESP_PARTITION_TYPE_DATA;
+    partition.info.subtype = subtype;
+    partition.info.size = size;
+    strncpy(partition.info.label, label, sizeof(partition.info.label) - 1);
+    partition.flash.assign(size, 0xFF);
+    partition.present = true;
+}
+
+inline const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                       const char *label) {
+    HostPartition &partition = hostPartition();
+    if (!partition.present || partition.info.type != type || partition.info.subtype != subtype ||
+        (label && strcmp(label, partition.info.label) != 0)) {
+        return nullptr;
+    }
+    return &partition.info;
+}
+
+inline bool hostPartitionRange(const esp_partition_t *partition, size_t offset, size_t size) {
+    return partition == &hostPartition().info && offset + size <= partition->size;
+}
+
+inline esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size) {
+    if (!hostPartitionRange(partition, offset, size) || offset % SPI_FLASH_SEC_SIZE || size % SPI_FLASH_SEC_SIZE) {
+        return ESP_FAIL;
+    }
+    memset(hostPartition().flash.data() + offset, 0xFF, size);
+    return ESP_OK;
+}
+
+// Like NOR flash, writing can only clear bits
+inline esp_err_t esp_partition_write(const esp_partition_t *partition, size_t offset, const void *data, size_t size) {
+    if (!hostPartitionRange(partition, offset, size)) {
+        return ESP_FAIL;
+    }
+    uint8_t *flash = hostPartition().flash.data() + offset;
+    for (size_t i = 0; i < size; i++) {
+        flash[i] &= static_cast<const uint8_t *>(data)[i];
+    }
+    return ESP_OK;
+}
+
+inline esp_err_t esp_partition_mmap(const esp_partition_t *partition, size_t offset, size_t size,
+                                    esp_partition_mmap_memory_t memory, const void **out,
+                                    spi_flash_mmap_handle_t *handle) {
+    (void)memory;
+    if (!hostPartitionRange(partition, offset, size)) {
+        return ESP_FAIL;
+    }
+    *out = hostPartition().flash.data() + offset;
+    *handle = 1;
+    return ESP_OK;
+}
+
+inline void spi_flash_munmap(spi_flash_mmap_handle_t handle) { (void)handle; }
+
+#endif
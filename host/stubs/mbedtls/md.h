@@ -0,0 +1,136 @@
+#ifndef HOST_MBEDTLS_MD_H
+#define HOST_MBEDTLS_MD_H
+
+// The one mbedTLS message digest call the firmware makes: HMAC-SHA256
+// (FIPS 180-4, RFC 2104), so tags match tools/udp_trigger.py.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef enum { MBEDTLS_MD_NONE = 0, MBEDTLS_MD_SHA256 = 6 } mbedtls_md_type_t;
+
+struct mbedtls_md_info_t {
+    mbedtls_md_type_t type;
+};
+
+inline const mbedtls_md_info_t *mbedtls_md_info_from_type(mbedtls_md_type_t type) {
+    static const mbedtls_md_info_t sha256 = {MBEDTLS_MD_SHA256};
+    return type == MBEDTLS_MD_SHA256 ? &sha256 : nullptr;
+}
+
+struct HostSha256 {
+    uint32_t state[8];
+    uint8_t block[64];
+    size_t fill;
+    uint64_t total;
+
+    static uint32_t rotate(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+    HostSha256() : state{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19},
+                   fill(0), total(0) {}
+
+    void compress() {
+        static const uint32_t k[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (uint32_t)block[i * 4] << 24 | (uint32_t)block[i * 4 + 1] << 16 | (uint32_t)block[i * 4 + 2] << 8 |
+                   block[i * 4 + 3];
+        }
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = rotate(w[i - 15], 7) ^ rotate(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotate(w[i - 2], 17) ^ rotate(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t v[8];
+        memcpy(v, state, sizeof(v));
+        for (int i = 0; i < 64; i++) {
+            uint32_t s1 = rotate(v[4], 6) ^ rotate(v[4], 11) ^ rotate(v[4], 25);
+            uint32_t choice = (v[4] & v[5]) ^ (~v[4] & v[6]);
+            uint32_t t1 = v[7] + s1 + choice + k[i] + w[i];
+            uint32_t s0 = rotate(v[0], 2) ^ rotate(v[0], 13) ^ rotate(v[0], 22);
+            uint32_t majority = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+            memmove(v + 1, v, 7 * sizeof(uint32_t));
+            v[4] += t1;
+            v[0] = t1 + s0 + majority;
+        }
+        for (int i = 0; i < 8; i++) {
+            state[i] += v[i];
+        }
+    }
+
+    void update(const uint8_t *data, size_t length) {
+        total += length;
+        while (length > 0) {
+            size_t n = length < 64 - fill ? length : 64 - fill;
+            memcpy(block + fill, data, n);
+            fill += n;
+            data += n;
+            length -= n;
+            if (fill == 64) {
+                compress();
+                fill = 0;
+            }
+        }
+    }
+
+    void finish(uint8_t digest[32]) {
+        uint64_t bits = total * 8;
+        uint8_t pad = 0x80;
+        update(&pad, 1);
+        pad = 0;
+        while (fill != 56) {
+            update(&pad, 1);
+        }
+        uint8_t length[8];
+        for (int i = 0; i < 8; i++) {
+            length[i] = (uint8_t)(bits >> (56 - i * 8));
+        }
+        update(length, 8);
+        for (int i = 0; i < 32; i++) {
+            digest[i] = (uint8_t)(state[i / 4] >> (24 - (i % 4) * 8));
+        }
+    }
+};
+
+inline int mbedtls_md_hmac(const mbedtls_md_info_t *info, const unsigned char *key, size_t keyLength,
+                           const unsigned char *input, size_t inputLength, unsigned char *output) {
+    if (!info || info->type != MBEDTLS_MD_SHA256) {
+        return -1;
+    }
+    uint8_t block[64] = {0};
+    if (keyLength > sizeof(block)) {
+        HostSha256 hashed;
+        hashed.update(key, keyLength);
+        hashed.finish(block);
+    } else {
+        memcpy(block, key, keyLength);
+    }
+    uint8_t pad[64];
+    for (int i = 0; i < 64; i++) {
+        pad[i] = block[i] ^ 0x36;
+    }
+    HostSha256 inner;
+    inner.update(pad, sizeof(pad));
+    inner.update(input, inputLength);
+    uint8_t innerDigest[32];
+    inner.finish(innerDigest);
+    for (int i = 0; i < 64; i++) {
+        pad[i] = block[i] ^ 0x5c;
+    }
+    HostSha256 outer;
+    outer.update(pad, sizeof(pad));
+    outer.update(innerDigest, sizeof(innerDigest));
+    outer.finish(output);
+    return 0;
+}
+
+#endif
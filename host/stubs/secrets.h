@@ -0,0 +1,9 @@
+#ifndef HOST_SECRETS_H
+#define HOST_SECRETS_H
+
+// The sketch's secrets.h is not in the repository. The host build signs UDP
+// trigger packets, so the HMAC path is the one under test.
+
+#define UDP_TRIGGER_KEY "audiopad-host-key"
+
+#endif
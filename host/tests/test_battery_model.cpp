@@ -0,0 +1,173 @@
+// BatteryFilter and liionStateOfCharge() against battery traces sampled as
+// battery_monitor.h does, BATTERY_SAMPLE_INTERVAL_MS apart. The traces are
+// generated from a known open-circuit voltage so the filter output can be
+// checked against it: oversampled ADC noise, single-sample spikes from the
+// amplifier's current steps, and playback bursts pulling the reading down by
+// BATTERY_PLAYBACK_AMPS through BATTERY_INTERNAL_OHMS.
+
+#include <random>
+#include <vector>
+#include "host_test.h"
+#include "battery_model.h"
+#include "config.h"
+
+struct Sample {
+    float volts;     // What the ADC reads
+    float loadAmps;  // What the monitor assumes is drawn, from getIsPlaying()
+    float openVolts; // The truth
+};
+
+static const int SAMPLES_PER_SECOND = 1000 / BATTERY_SAMPLE_INTERVAL_MS;
+
+// Inverse of the discharge curve, for building traces from a state of charge
+static float openVoltsAt(float soc) {
+    float low = 3.0f;
+    float high = 4.2f;
+    for (int i = 0; i < 40; i++) {
+        float mid = (low + high) / 2;
+        (liionStateOfCharge(mid) < soc ? low : high) = mid;
+    }
+    return (low + high) / 2;
+}
+
+// Discharge from fromSoc to toSoc over the given minutes, with playback for
+// 8 s out of every 20 s, noise, and a spike every now and then
+static std::vector<Sample> dischargeTrace(float fromSoc, float toSoc, int minutes, float noiseVolts,
+                                          float spikesPerMinute) {
+    std::mt19937 rng(7);
+    std::normal_distribution<float> noise(0.0f, noiseVolts);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::vector<Sample> trace;
+    int count = minutes * 60 * SAMPLES_PER_SECOND;
+    for (int i = 0; i < count; i++) {
+        float soc = fromSoc + (toSoc - fromSoc) * i / count;
+        bool playing = (i / SAMPLES_PER_SECOND) % 20 < 8;
+        Sample sample;
+        sample.openVolts = openVoltsAt(soc);
+        sample.loadAmps = playing ? BATTERY_PLAYBACK_AMPS : 0.0f;
+        sample.volts = sample.openVolts - sample.loadAmps * BATTERY_INTERNAL_OHMS + noise(rng);
+        if (uniform(rng) < spikesPerMinute / (60.0f * SAMPLES_PER_SECOND)) {
+            sample.volts -= 0.3f + 0.2f * uniform(rng); // Brownout dip on a current step
+        }
+        trace.push_back(sample);
+    }
+    return trace;
+}
+
+// Replays a trace; returns the largest error against the truth after settling
+static float replay(const std::vector<Sample> &trace, float internalOhms, std::vector<float> *output = nullptr) {
+    BatteryFilter<BATTERY_MEDIAN_WINDOW> filter(BATTERY_FILTER_ALPHA);
+    float worst = 0.0f;
+    for (size_t i = 0; i < trace.size(); i++) {
+        float volts = filter.add(trace[i].volts, trace[i].loadAmps, internalOhms);
+        if (output) {
+            output->push_back(volts);
+        }
+        if (i >= (size_t)(30 * SAMPLES_PER_SECOND)) {
+            worst = fmaxf(worst, fabsf(volts - trace[i].openVolts));
+        }
+    }
+    return worst;
+}
+
+static void testFirstReading() {
+    BatteryFilter<BATTERY_MEDIAN_WINDOW> filter(BATTERY_FILTER_ALPHA);
+    CHECK(!filter.isValid());
+    // Starts where the cell is rather than climbing from zero
+    CHECK(fabsf(filter.add(3.9f, 0.0f, BATTERY_INTERNAL_OHMS) - 3.9f) < 1e-6f);
+    CHECK(filter.isValid());
+    // Load compensation applies from the first reading
+    filter.reset();
+    float compensated = filter.add(3.8f, BATTERY_PLAYBACK_AMPS, BATTERY_INTERNAL_OHMS);
+    CHECK(fabsf(compensated - (3.8f + BATTERY_PLAYBACK_AMPS * BATTERY_INTERNAL_OHMS)) < 1e-6f);
+}
+
+// Isolated spikes, however large, never reach the output
+static void testSpikes() {
+    BatteryFilter<BATTERY_MEDIAN_WINDOW> filter(BATTERY_FILTER_ALPHA);
+    float worst = 0.0f;
+    for (int i = 0; i < 1000; i++) {
+        float volts = i % 7 == 3 ? 2.5f : i % 11 == 5 ? 4.6f : 3.85f;
+        worst = fmaxf(worst, fabsf(filter.add(volts, 0.0f, BATTERY_INTERNAL_OHMS) - 3.85f));
+    }
+    CHECK(worst < 1e-5f);
+}
+
+// A step (charger unplugged, a fresh cell) settles within the time the config promises
+static void testStep() {
+    BatteryFilter<BATTERY_MEDIAN_WINDOW> filter(BATTERY_FILTER_ALPHA);
+    for (int i = 0; i < 100; i++) {
+        filter.add(4.1f, 0.0f, BATTERY_INTERNAL_OHMS);
+    }
+    int settledAfter = -1;
+    for (int i = 0; i < 60 * SAMPLES_PER_SECOND; i++) {
+        float volts = filter.add(3.9f, 0.0f, BATTERY_INTERNAL_OHMS);
+        CHECK(volts <= 4.1f + 1e-6f && volts >= 3.9f - 1e-6f); // No overshoot
+        if (settledAfter < 0 && volts - 3.9f < 0.005f) {
+            settledAfter = i;
+        }
+    }
+    CHECK(settledAfter >= 0 && settledAfter < 30 * SAMPLES_PER_SECOND);
+    printf("Step 4.1 V -> 3.9 V: within 5 mV after %.1f s\n", (float)settledAfter / SAMPLES_PER_SECOND);
+}
+
+// Two hours of use from full to nearly empty
+static void testDischarge() {
+    std::vector<Sample> trace = dischargeTrace(95.0f, 10.0f, 120, 0.015f, 2.0f);
+    std::vector<float> filtered;
+    float compensatedError = replay(trace, BATTERY_INTERNAL_OHMS, &filtered);
+    float uncompensatedError = replay(trace, 0.0f);
+    printf("Discharge: worst error %.1f mV compensated, %.1f mV without load compensation\n",
+           compensatedError * 1000, uncompensatedError * 1000);
+    CHECK(compensatedError < 0.015f);
+    // Playback alone moves an uncompensated reading by tens of millivolts, several percent of charge
+    CHECK(uncompensatedError > 2 * compensatedError);
+
+    // Smooth: the output moves far less per sample than the raw noise and spikes
+    float worstStep = 0.0f;
+    for (size_t i = 1; i < filtered.size(); i++) {
+        worstStep = fmaxf(worstStep, fabsf(filtered[i] - filtered[i - 1]));
+    }
+    printf("Discharge: largest change between samples %.2f mV\n", worstStep * 1000);
+    CHECK(worstStep < 0.004f);
+
+    // Reported charge only ever falls, give or take jitter: on the flat middle
+    // of the curve (3.77-3.79 V) each millivolt of residual noise is 0.5%
+    float lowest = 100.0f;
+    float worstRise = 0.0f;
+    for (size_t i = 30 * SAMPLES_PER_SECOND; i < filtered.size(); i++) {
+        float soc = liionStateOfCharge(filtered[i]);
+        worstRise = fmaxf(worstRise, soc - lowest);
+        lowest = fminf(lowest, soc);
+    }
+    printf("Discharge: largest rise in reported charge %.1f%%\n", worstRise);
+    CHECK(worstRise < 8.0f);
+    CHECK(fabsf(liionStateOfCharge(filtered.back()) - 10.0f) < 2.0f);
+}
+
+static void testStateOfCharge() {
+    CHECK(liionStateOfCharge(2.5f) == 0.0f);
+    CHECK(liionStateOfCharge(3.0f) == 0.0f);
+    CHECK(liionStateOfCharge(4.2f) == 100.0f);
+    CHECK(liionStateOfCharge(4.35f) == 100.0f);
+    CHECK(fabsf(liionStateOfCharge(3.82f) - 50.0f) < 0.01f);
+
+    // Monotonic and continuous across the whole range
+    float previous = liionStateOfCharge(2.9f);
+    for (float volts = 2.9f; volts <= 4.3f; volts += 0.001f) {
+        float soc = liionStateOfCharge(volts);
+        CHECK(soc >= previous);
+        CHECK(soc - previous < 0.5f);
+        CHECK(soc >= 0.0f && soc <= 100.0f);
+        previous = soc;
+    }
+}
+
+int main() {
+    testFirstReading();
+    testSpikes();
+    testStep();
+    testDischarge();
+    testStateOfCharge();
+    return hostReport("test_battery_model");
+}
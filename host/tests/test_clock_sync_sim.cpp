@@ -0,0 +1,259 @@
+// Several simulated Audiopads syncing to a leader, then playing one press
+// together. Each node has its own crystal (offset and drift against true
+// time). Sync exchanges and the play broadcast are real UDP datagrams
+// between loopback sockets, one per node. Network delay is simulated: each
+// datagram carries the true time it arrives, with a fixed one-way base per
+// direction plus random queueing delay. Followers fit the leader's clock with
+// ClockModel as clock_sync.h does, convert the shared start time to their
+// own clock and trim their mixer by ClockFit::trimPpm(). Each node's output
+// is rendered through the real AudioMixer to count the frames its trim
+// drops or repeats.
+//
+// Reports start skew and the skew at the end of a long clip against the
+// leader, with and without the trim. Both must stay under 1 ms. A constant
+// path asymmetry cannot be measured by NTP-style exchanges and shows up as
+// half its size in the start skew.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+#include "host_test.h"
+#include "audio_mixer.h"
+#include "clock_model.h"
+
+enum SimType : uint8_t { SIM_REQUEST, SIM_RESPONSE, SIM_PLAY };
+
+// On the wire, with the simulated arrival time in front
+struct SimPacket {
+    int64_t arrivesAt; // True time
+    uint8_t type;
+    int32_t from;
+    uint32_t sequence;
+    int64_t t1;
+    int64_t t2;
+    int64_t t3;
+};
+
+struct Node {
+    double driftPpm;
+    int64_t offsetUs;
+    double forwardUs;  // Base one-way delay to the leader
+    double backwardUs; // And from it
+    int sock;
+    sockaddr_in address;
+    std::vector<SimPacket> inbox;
+
+    // Follower state, as in ClockSync
+    ClockModel<CLOCK_SYNC_WINDOW> model;
+    uint32_t requestSequence;
+    int64_t requestSentAt;
+    int64_t nextRequestAt; // True time
+    bool havePlay;
+    int64_t startAt;       // True time the press sounds here
+
+    int64_t local(int64_t trueUs) const { return offsetUs + trueUs + (int64_t)(trueUs * driftPpm / 1e6); }
+    int64_t trueTime(int64_t localUs) const { return (int64_t)((localUs - offsetUs) / (1.0 + driftPpm / 1e6)); }
+};
+
+static std::mt19937 rng(20240601);
+static std::vector<Node> nodes;
+
+// Mostly a few hundred microseconds of queueing, now and then a burst of several milliseconds
+static double queueingUs() {
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    double delay = -300.0 * log(1.0 - uniform(rng));
+    if (uniform(rng) < 0.1) {
+        delay += 2000.0 + 6000.0 * uniform(rng);
+    }
+    return delay;
+}
+
+static void send(int to, SimPacket packet) {
+    CHECK(sendto(nodes[packet.from].sock, &packet, sizeof(packet), 0, (const sockaddr *)&nodes[to].address,
+                 sizeof(sockaddr_in)) == (ssize_t)sizeof(packet));
+    // Loopback delivers at once; pick it up into the inbox, which is ordered by arrival time
+    SimPacket received;
+    while (recv(nodes[to].sock, &received, sizeof(received), MSG_DONTWAIT) == (ssize_t)sizeof(received)) {
+        nodes[to].inbox.push_back(received);
+    }
+}
+
+static void handle(int index, const SimPacket &packet, int64_t now) {
+    Node &node = nodes[index];
+    switch (packet.type) {
+        case SIM_REQUEST: {
+            SimPacket reply = packet;
+            reply.type = SIM_RESPONSE;
+            reply.from = index;
+            reply.t2 = node.local(now);
+            int64_t sentAt = now + 50; // Leader task turnaround
+            reply.t3 = node.local(sentAt);
+            reply.arrivesAt = sentAt + (int64_t)(nodes[packet.from].backwardUs + queueingUs());
+            send(packet.from, reply);
+            break;
+        }
+        case SIM_RESPONSE:
+            // Only the answer to the latest request, as in ClockSync::handleResponse()
+            if (packet.sequence == node.requestSequence && packet.t1 == node.requestSentAt) {
+                node.model.addExchange(packet.t1, packet.t2, packet.t3, node.local(now));
+            }
+            break;
+        case SIM_PLAY:
+            node.startAt = node.trueTime(node.model.toLocal(packet.t1));
+            node.havePlay = true;
+            break;
+    }
+}
+
+// Runs the network until the given true time
+static void runUntil(int64_t until) {
+    for (;;) {
+        int64_t next = until;
+        int who = -1;
+        bool isRequest = false;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            for (const SimPacket &packet : nodes[i].inbox) {
+                if (packet.arrivesAt < next) {
+                    next = packet.arrivesAt;
+                    who = i;
+                    isRequest = false;
+                }
+            }
+            if (i > 0 && nodes[i].nextRequestAt < next) {
+                next = nodes[i].nextRequestAt;
+                who = i;
+                isRequest = true;
+            }
+        }
+        if (who < 0) {
+            return;
+        }
+        Node &node = nodes[who];
+        if (isRequest) {
+            SimPacket request = {};
+            request.type = SIM_REQUEST;
+            request.from = who;
+            request.sequence = ++node.requestSequence;
+            request.t1 = node.local(next);
+            node.requestSentAt = request.t1;
+            request.arrivesAt = next + (int64_t)(node.forwardUs + queueingUs());
+            send(0, request);
+            // Requests go out on the follower's clock
+            node.nextRequestAt = next + (int64_t)(CLOCK_SYNC_INTERVAL_MS * 1000 / (1.0 + node.driftPpm / 1e6));
+        } else {
+            auto earliest = std::min_element(node.inbox.begin(), node.inbox.end(),
+                                             [](const SimPacket &a, const SimPacket &b) {
+                                                 return a.arrivesAt < b.arrivesAt;
+                                             });
+            SimPacket packet = *earliest;
+            node.inbox.erase(earliest);
+            handle(who, packet, next);
+        }
+    }
+}
+
+// Counts the output frames for a clip through a mixer trimmed by ppm
+class CountingSink : public AudioOutput {
+public:
+    uint64_t frames = 0;
+    virtual bool begin() override { return true; }
+    virtual bool ConsumeSample(int16_t sample[2]) override {
+        (void)sample;
+        frames++;
+        return true;
+    }
+    virtual bool stop() override { return true; }
+};
+
+static uint64_t renderedFrames(uint32_t clipFrames, int32_t trimPpm) {
+    static AudioMixer<1> mixer;
+    CountingSink sink;
+    mixer.setSink(&sink);
+    mixer.setTrimPpm(trimPpm);
+    MixerVoice *voice = mixer.voice(0);
+    voice->reset(1.0f);
+    int16_t sample[2] = {1000, 1000};
+    uint32_t fed = 0;
+    while (fed < clipFrames) {
+        while (fed < clipFrames && voice->ConsumeSample(sample)) {
+            fed++;
+        }
+        mixer.pump();
+    }
+    voice->finish();
+    while (mixer.getActiveVoices() > 0) {
+        mixer.pump();
+    }
+    return sink.frames;
+}
+
+int main() {
+    // Leader first; followers with typical crystal errors and unequal paths
+    const struct {
+        double driftPpm;
+        int64_t offsetUs;
+        double forwardUs;
+        double backwardUs;
+    } setups[] = {{0.0, 0, 0.0, 0.0},
+                  {80.0, 1234567890LL, 1200.0, 900.0},
+                  {-60.0, -987654321LL, 800.0, 800.0},
+                  {25.0, 42000000LL, 2500.0, 2000.0},
+                  {-110.0, 5000LL, 600.0, 1100.0}};
+    for (const auto &setup : setups) {
+        Node node = {};
+        node.driftPpm = setup.driftPpm;
+        node.offsetUs = setup.offsetUs;
+        node.forwardUs = setup.forwardUs;
+        node.backwardUs = setup.backwardUs;
+        node.sock = socket(AF_INET, SOCK_DGRAM, 0);
+        CHECK(node.sock >= 0);
+        node.address.sin_family = AF_INET;
+        node.address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        node.address.sin_port = 0;
+        CHECK(bind(node.sock, (const sockaddr *)&node.address, sizeof(node.address)) == 0);
+        socklen_t length = sizeof(node.address);
+        getsockname(node.sock, (sockaddr *)&node.address, &length);
+        node.nextRequestAt = 100000 * (nodes.size() + 1); // Staggered
+        nodes.push_back(node);
+    }
+
+    // Two minutes of sync, then a press on the leader
+    runUntil(120LL * 1000000);
+    int64_t pressAt = 120LL * 1000000;
+    SimPacket play = {};
+    play.type = SIM_PLAY;
+    play.from = 0;
+    play.t1 = nodes[0].local(pressAt) + (int64_t)SYNC_PLAY_DELAY_MS * 1000; // Shared time T
+    nodes[0].startAt = nodes[0].trueTime(play.t1);
+    for (size_t i = 1; i < nodes.size(); i++) {
+        play.arrivesAt = pressAt + (int64_t)(nodes[i].backwardUs + queueingUs());
+        send(i, play);
+    }
+    runUntil(pressAt + 1000000);
+
+    // Every node plays the same 60 s clip
+    const uint32_t clipFrames = 60 * 44100;
+    double leaderEnd = nodes[0].startAt + renderedFrames(clipFrames, 0) * 1e6 / 44100.0;
+    printf("node  drift ppm  trim ppm  start skew us  end skew us  untrimmed end us\n");
+    for (size_t i = 1; i < nodes.size(); i++) {
+        Node &node = nodes[i];
+        CHECK(node.havePlay);
+        int32_t trim = node.model.getFit().trimPpm(CLOCK_SYNC_MAX_TRIM_PPM);
+        // The output runs off the node's own crystal
+        double outputRate = 44100.0 * (1.0 + node.driftPpm / 1e6);
+        double end = node.startAt + renderedFrames(clipFrames, trim) * 1e6 / outputRate;
+        double untrimmedEnd = node.startAt + renderedFrames(clipFrames, 0) * 1e6 / outputRate;
+        double startSkew = (double)(node.startAt - nodes[0].startAt);
+        double endSkew = end - leaderEnd;
+        printf("%4zu  %9.1f  %8d  %13.0f  %11.0f  %16.0f\n", i, node.driftPpm, trim, startSkew, endSkew,
+               untrimmedEnd - leaderEnd);
+        CHECK(fabs(startSkew) < 1000.0);
+        CHECK(fabs(endSkew) < 1000.0);
+        close(node.sock);
+    }
+    close(nodes[0].sock);
+    return hostReport("test_clock_sync_sim");
+}
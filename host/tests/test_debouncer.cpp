@@ -0,0 +1,163 @@
+// EdgeDebouncer replayed against bounce traces. The traces follow what a
+// tactile switch on a pulled-up GPIO does (active low): bursts of edges for
+// 1-5 ms after each transition. Edges go to onEdge() as the ISR would, and
+// poll() runs every BUTTON_SETTLE_POLL_MS while a bounce is pending, as on
+// the button task.
+
+#include <vector>
+#include "host_test.h"
+#include "debouncer.h"
+#include "config.h"
+
+struct Edge {
+    bool level;
+    uint32_t us;
+};
+
+struct Reported {
+    EdgeDebouncer::Event event;
+    uint32_t us;
+};
+
+static const uint32_t LOCKOUT_US = DEBOUNCE_DELAY * 1000;
+static const uint32_t POLL_US = BUTTON_SETTLE_POLL_MS * 1000;
+
+// Feeds the trace from start and keeps polling until endUs
+static std::vector<Reported> replay(const std::vector<Edge> &trace, uint32_t start, uint32_t endUs) {
+    EdgeDebouncer debouncer;
+    debouncer.reset(true, start, LOCKOUT_US, false);
+    std::vector<Reported> reported;
+    uint32_t now = start;
+    size_t next = 0;
+    while ((int32_t)(now - endUs) < 0) {
+        uint32_t nextPoll = now + POLL_US;
+        // Edges before the next poll arrive first
+        while (next < trace.size() && (int32_t)(trace[next].us - nextPoll) < 0) {
+            EdgeDebouncer::Event event = debouncer.onEdge(trace[next].level, trace[next].us);
+            if (event != EdgeDebouncer::NONE) {
+                reported.push_back({event, trace[next].us});
+            }
+            next++;
+        }
+        now = nextPoll;
+        if (debouncer.isPending()) {
+            EdgeDebouncer::Event event = debouncer.poll(now);
+            if (event != EdgeDebouncer::NONE) {
+                reported.push_back({event, now});
+            }
+        }
+    }
+    return reported;
+}
+
+// Edges relative to a base time
+static std::vector<Edge> shift(std::vector<Edge> trace, uint32_t base) {
+    for (Edge &edge : trace) {
+        edge.us += base;
+    }
+    return trace;
+}
+
+static void append(std::vector<Edge> &to, const std::vector<Edge> &trace, uint32_t base) {
+    for (const Edge &edge : shift(trace, base)) {
+        to.push_back(edge);
+    }
+}
+
+// Press: 2.3 ms of bounce settling low
+static const std::vector<Edge> PRESS_BOUNCE = {
+    {false, 0}, {true, 40}, {false, 95}, {true, 180}, {false, 230}, {true, 410},
+    {false, 470}, {true, 900}, {false, 960}, {true, 1500}, {false, 1530}, {true, 2240}, {false, 2300}};
+
+// Release: 4.1 ms of bounce settling high
+static const std::vector<Edge> RELEASE_BOUNCE = {
+    {true, 0}, {false, 120}, {true, 300}, {false, 340}, {true, 1100}, {false, 1180},
+    {true, 2600}, {false, 2650}, {true, 4100}};
+
+static void testCleanPress() {
+    std::vector<Edge> trace = {{false, 1000}, {true, 200000}};
+    std::vector<Reported> reported = replay(trace, 0, 400000);
+    CHECK(reported.size() == 2);
+    if (reported.size() == 2) {
+        // Reported on the edge itself, no added delay
+        CHECK(reported[0].event == EdgeDebouncer::PRESSED && reported[0].us == 1000);
+        CHECK(reported[1].event == EdgeDebouncer::RELEASED && reported[1].us == 200000);
+    }
+}
+
+static void testBouncyPress() {
+    std::vector<Edge> trace;
+    append(trace, PRESS_BOUNCE, 10000);
+    append(trace, RELEASE_BOUNCE, 150000);
+    std::vector<Reported> reported = replay(trace, 0, 400000);
+    CHECK(reported.size() == 2);
+    if (reported.size() == 2) {
+        CHECK(reported[0].event == EdgeDebouncer::PRESSED && reported[0].us == 10000);
+        CHECK(reported[1].event == EdgeDebouncer::RELEASED && reported[1].us == 150000);
+    }
+}
+
+// A tap shorter than the lockout: the release arrives while edges are still
+// ignored, so poll() reports it once the line has been quiet for the lockout
+static void testShortTap() {
+    std::vector<Edge> trace;
+    append(trace, PRESS_BOUNCE, 10000);
+    append(trace, RELEASE_BOUNCE, 30000);
+    std::vector<Reported> reported = replay(trace, 0, 300000);
+    CHECK(reported.size() == 2);
+    if (reported.size() == 2) {
+        CHECK(reported[0].event == EdgeDebouncer::PRESSED && reported[0].us == 10000);
+        CHECK(reported[1].event == EdgeDebouncer::RELEASED);
+        uint32_t settled = 30000 + 4100 + LOCKOUT_US;
+        CHECK(reported[1].us >= settled && reported[1].us < settled + POLL_US);
+    }
+}
+
+// Presses spaced just over two lockouts apart all count
+static void testFastRepeats() {
+    std::vector<Edge> trace;
+    const uint32_t period = 2 * LOCKOUT_US + 10000;
+    for (int i = 0; i < 10; i++) {
+        append(trace, PRESS_BOUNCE, 10000 + i * period);
+        append(trace, RELEASE_BOUNCE, 10000 + i * period + LOCKOUT_US + 5000);
+    }
+    std::vector<Reported> reported = replay(trace, 0, 10000 + 11 * period);
+    CHECK(reported.size() == 20);
+    for (size_t i = 0; i < reported.size(); i++) {
+        CHECK(reported[i].event == (i % 2 == 0 ? EdgeDebouncer::PRESSED : EdgeDebouncer::RELEASED));
+    }
+}
+
+// An edge repeating the settled level, e.g. after a missed interrupt, is not an event
+static void testRepeatedLevel() {
+    std::vector<Edge> trace = {{true, 1000}, {true, 2000}, {false, 100000}, {false, 100500}};
+    std::vector<Reported> reported = replay(trace, 0, 200000);
+    CHECK(reported.size() == 1);
+    if (reported.size() == 1) {
+        CHECK(reported[0].event == EdgeDebouncer::PRESSED && reported[0].us == 100000);
+    }
+}
+
+// micros() wraps every 71.6 minutes; a press across the wrap behaves the same
+static void testWrap() {
+    uint32_t start = 0xFFFFFFFFu - 20000;
+    std::vector<Edge> trace;
+    append(trace, PRESS_BOUNCE, start + 10000);
+    append(trace, RELEASE_BOUNCE, start + 150000);
+    std::vector<Reported> reported = replay(trace, start, start + 400000);
+    CHECK(reported.size() == 2);
+    if (reported.size() == 2) {
+        CHECK(reported[0].event == EdgeDebouncer::PRESSED && reported[0].us == start + 10000);
+        CHECK(reported[1].event == EdgeDebouncer::RELEASED && reported[1].us == start + 150000);
+    }
+}
+
+int main() {
+    testCleanPress();
+    testBouncyPress();
+    testShortTap();
+    testFastRepeats();
+    testRepeatedLevel();
+    testWrap();
+    return hostReport("test_debouncer");
+}
@@ -0,0 +1,68 @@
+// AudioMixer::frameAt() over a long held-open stream. The mixer runs on the
+// manual clock into the I2S stub for 40 minutes, past the 35.8 minutes where
+// a 32-bit signed microsecond difference overflows and across the 71.6
+// minute wrap of micros(). All along, frameAt(now) must name the frame the
+// output is playing, and frameAt() of a later time must run at the sample
+// rate plus the trim.
+
+#include "host_test.h"
+#include "audio_mixer.h"
+#include "AudioOutputI2S.h"
+
+static const uint64_t STEP_US = 5000;
+
+// Frames between frameAt(now) and what the output is playing. The stream
+// frame counts the block the mixer is still handing out, so frameAt() may be
+// up to a block behind this estimate, never ahead.
+static int32_t playingError(AudioMixer<2> &mixer, AudioOutputI2S &output) {
+    uint32_t playing = mixer.getStreamFrame() - output.getBuffered();
+    return (int32_t)(mixer.frameAt(micros()) - playing);
+}
+
+static void runFor(int32_t trimPpm) {
+    static AudioMixer<2> mixer;
+    AudioOutputI2S output;
+    mixer.setSink(&output);
+    mixer.setTrimPpm(trimPpm);
+    mixer.setHoldOpen(true);
+
+    // Start 20 minutes before micros() wraps
+    hostAdvanceMicros(0x100000000ull - 20ull * 60 * 1000000 - micros());
+    mixer.pump();
+    CHECK(mixer.isClockRunning());
+
+    int32_t worst = 0;
+    const uint64_t steps = 40ull * 60 * 1000000 / STEP_US;
+    for (uint64_t i = 0; i < steps; i++) {
+        hostAdvanceMicros(STEP_US);
+        mixer.pump();
+        if (i % 1000 == 0) {
+            int32_t error = playingError(mixer, output);
+            worst = abs(error) > abs(worst) ? error : worst;
+            CHECK(error >= -(int32_t)MIXER_BLOCK_FRAMES - 8 && error <= 8);
+        }
+    }
+    printf("Trim %d ppm: frameAt(now) at most %d frames off the playing frame over 40 minutes\n", trimPpm, worst);
+
+    // One second and ten minutes ahead
+    uint32_t now = micros();
+    double rate = 44100.0 * (1.0 + trimPpm / 1e6);
+    CHECK(fabs((double)(mixer.frameAt(now + 1000000) - mixer.frameAt(now)) - rate) <= 1.0);
+    CHECK(fabs((double)(mixer.frameAt(now + 600000000) - mixer.frameAt(now)) - 600 * rate) <= 1.0);
+
+    // Released, the output stops once the block in hand has gone out
+    mixer.setHoldOpen(false);
+    for (int i = 0; i < 10 && mixer.isClockRunning(); i++) {
+        hostAdvanceMicros(STEP_US);
+        mixer.pump();
+    }
+    CHECK(!mixer.isClockRunning());
+}
+
+int main() {
+    hostUseManualClock();
+    runFor(0);
+    runFor(100);
+    runFor(-250);
+    return hostReport("test_mixer_clock");
+}
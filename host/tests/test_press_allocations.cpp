@@ -0,0 +1,95 @@
+// The press path must not touch the heap: after init(), pressing, playing,
+// retriggering, chaining a playlist, scheduling and stopping run the real
+// AudioManager with every allocation counted, and the count must stay zero.
+
+#include "alloc_counter.h"
+#include "host_test.h"
+#include "audio_manager.h"
+
+static AudioManager audio;
+
+// Runs the audio task's loop for a while
+static void run(unsigned long ms) {
+    unsigned long started = micros();
+    while (micros() - started < ms * 1000) {
+        audio.update();
+    }
+}
+
+static void settle() {
+    audio.stopCurrentAudio();
+    unsigned long started = micros();
+    while (audio.getIsPlaying() && micros() - started < 1000000) {
+        audio.update();
+    }
+}
+
+static uint64_t counted(void (*scenario)()) {
+    hostAllocationCount() = 0;
+    hostCountAllocations(true);
+    scenario();
+    hostCountAllocations(false);
+    uint64_t count = hostAllocationCount();
+    settle();
+    return count;
+}
+
+int main() {
+    hostMountSpiffs("test_press_allocations_spiffs");
+    for (int i = 1; i <= 3; i++) {
+        ClipPath path = Pads::clipPath(i, ".adp");
+        CHECK(hostWriteAdpcmClip(path.c_str(), 44100, 300, 0.3f, 220.0f * i));
+    }
+    // A second file of button 1, button1_2
+    ClipPath second = Pads::clipPath(Pads::clipOf(1, 2), ".adp");
+    CHECK(strcmp(second.name(), "button1_2.adp") == 0);
+    CHECK(hostWriteAdpcmClip(second.c_str(), 44100, 300, 0.3f, 330.0f));
+    clipIndex.begin();
+    audio.init();
+
+    // Warm up once so one-time setup (static locals, the output) is not counted
+    audio.playButtonSound(1);
+    run(20);
+    settle();
+
+    uint64_t single = counted([] {
+        audio.playButtonSound(1, 1.0f, AUDIO_SOURCE_BUTTONS);
+        run(50);
+    });
+    CHECK(single == 0);
+
+    uint64_t overlapping = counted([] {
+        for (int i = 1; i <= 3; i++) {
+            audio.playButtonSound(i, 1.0f, AUDIO_SOURCE_BUTTONS);
+            run(5);
+        }
+        audio.playButtonSound(2, 1.0f, AUDIO_SOURCE_BUTTONS); // Retrigger
+        run(50);
+        audio.stopButtonSound(1, AUDIO_SOURCE_BUTTONS);
+        run(20);
+    });
+    CHECK(overlapping == 0);
+
+    // A sequence of three clips on button 1, one of them its second file, primes
+    // and hands over between voices
+    uint8_t clips[3] = {1, (uint8_t)Pads::clipOf(1, 2), 3};
+    CHECK(playlists.set(1, clips, 3, PLAYLIST_SEQUENCE));
+    uint64_t chained = counted([] {
+        audio.playButtonSound(1, 1.0f, AUDIO_SOURCE_BUTTONS);
+        run(1000);
+    });
+    CHECK(chained == 0);
+    uint8_t own[1] = {1};
+    playlists.set(1, own, 1, PLAYLIST_ROUND_ROBIN);
+
+    uint64_t scheduled = counted([] {
+        audio.scheduleButtonSound(2, micros() + 30000, 1.0f, AUDIO_SOURCE_WEB);
+        audio.scheduleButtonSound(3, micros() + 60000, 1.0f, AUDIO_SOURCE_WEB);
+        run(150);
+    });
+    CHECK(scheduled == 0);
+
+    printf("Allocations: single %llu, overlapping %llu, chained %llu, scheduled %llu\n", (unsigned long long)single,
+           (unsigned long long)overlapping, (unsigned long long)chained, (unsigned long long)scheduled);
+    return hostReport("test_press_allocations");
+}
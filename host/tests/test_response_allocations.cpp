@@ -0,0 +1,79 @@
+// Answering a request must not touch the heap: the JSON and text handlers
+// that build their reply in a FixedResponse run with every allocation
+// counted, from the handler to the request being freed, and the count must
+// stay zero. The request itself is the library's and is built beforehand.
+
+#include "alloc_counter.h"
+#include "host_test.h"
+#include "web_server.h"
+
+static WebServerManager web;
+static int testedButton = 0;
+static float setVolume = -1.0f;
+
+static AsyncWebServerRequest *request(const char *url, const char *param = nullptr, const char *value = nullptr) {
+    AsyncWebServerRequest *built = new AsyncWebServerRequest(HTTP_GET, url);
+    if (param) {
+        built->hostAddParam(param, value);
+    }
+    return built;
+}
+
+// Runs a handler on a prepared request and frees it, as the server does once sent
+static uint64_t counted(void (WebServerManager::*handler)(AsyncWebServerRequest *), AsyncWebServerRequest *prepared,
+                        int code, const char *body) {
+    hostAllocationCount() = 0;
+    hostCountAllocations(true);
+    (web.*handler)(prepared);
+    CHECK(prepared->hostCode() == code);
+    CHECK(strstr(prepared->hostBody(), body) != nullptr);
+    delete prepared;
+    hostCountAllocations(false);
+    return hostAllocationCount();
+}
+
+int main() {
+    hostMountSpiffs("test_response_allocations_spiffs");
+    for (int i = 1; i <= 3; i++) {
+        ClipPath path = Pads::clipPath(i);
+        CHECK(hostWriteMp3Clip(path.c_str(), 300));
+    }
+    clipIndex.begin();
+    web.setTestButtonCallback([](int buttonNum) { testedButton = buttonNum; });
+    web.setVolumeCallbacks([](float volume) { setVolume = volume; }, []() { return 0.75f; });
+    web.setStopAudioCallback([]() {});
+
+    // Warm up once so one-time setup (static locals, each pool slot) is not counted
+    for (int i = 0; i < FIXED_RESPONSE_POOL_SIZE; i++) {
+        counted(&WebServerManager::handleGetVolume, request("/volume"), 200, "0.75");
+    }
+
+    uint64_t battery = counted(&WebServerManager::handleBattery, request("/battery"), 200, "{");
+    uint64_t volume = counted(&WebServerManager::handleGetVolume, request("/volume"), 200, "{\"volume\":0.75}");
+    uint64_t files = counted(&WebServerManager::handleListFiles, request("/list"), 200, "\"button3.mp3\"");
+    uint64_t playlists = counted(&WebServerManager::handleGetPlaylists, request("/playlists"), 200, "{");
+    uint64_t test = counted(&WebServerManager::handleTestButton, request("/test", "button", "2"), 200,
+                            "Testing button 2");
+    CHECK(testedButton == 2);
+    uint64_t invalid = counted(&WebServerManager::handleTestButton, request("/test", "button", "99"), 400,
+                               "Invalid button number");
+    uint64_t loud = counted(&WebServerManager::handleSetVolume, request("/volume", "volume", "7"), 200,
+                            "Volume set to 1.00");
+    CHECK(setVolume == MAX_AUDIO_GAIN);
+    uint64_t stop = counted(&WebServerManager::handleStopAudio, request("/stop"), 200, "Audio stopped");
+    CHECK(battery == 0);
+    CHECK(volume == 0);
+    CHECK(files == 0);
+    CHECK(playlists == 0);
+    CHECK(test == 0);
+    CHECK(invalid == 0);
+    CHECK(loud == 0);
+    CHECK(stop == 0);
+
+    printf("Allocations: battery %llu, volume %llu, files %llu, playlists %llu, test %llu, invalid %llu, "
+           "set volume %llu, stop %llu\n",
+           (unsigned long long)battery, (unsigned long long)volume, (unsigned long long)files,
+           (unsigned long long)playlists, (unsigned long long)test, (unsigned long long)invalid,
+           (unsigned long long)loud, (unsigned long long)stop);
+    return hostReport("test_response_allocations");
+}
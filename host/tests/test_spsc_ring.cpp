@@ -0,0 +1,108 @@
+// SpscRing: single-threaded behaviour, then one producer and one consumer
+// thread hammering a small ring with multi-word items, which would show lost,
+// repeated, reordered or torn items.
+
+#include <thread>
+#include "host_test.h"
+#include "spsc_ring.h"
+
+// Larger than a word, like AudioCommand, so a torn copy is detectable
+struct Item {
+    uint32_t sequence;
+    uint32_t check;
+    uint64_t payload[3];
+};
+
+static Item makeItem(uint32_t sequence) {
+    Item item;
+    item.sequence = sequence;
+    item.check = sequence * 2654435761u;
+    for (int i = 0; i < 3; i++) {
+        item.payload[i] = (uint64_t)sequence << (i * 8);
+    }
+    return item;
+}
+
+static bool intact(const Item &item) {
+    bool ok = item.check == item.sequence * 2654435761u;
+    for (int i = 0; i < 3; i++) {
+        ok = ok && item.payload[i] == (uint64_t)item.sequence << (i * 8);
+    }
+    return ok;
+}
+
+static void testSingleThread() {
+    SpscRing<int, 4> ring;
+    int value = 0;
+    CHECK(ring.empty());
+    CHECK(!ring.pop(value));
+    CHECK(ring.capacity() == 4);
+
+    for (int i = 0; i < 4; i++) {
+        CHECK(ring.push(i));
+    }
+    CHECK(!ring.push(99)); // Full
+    CHECK(ring.size() == 4);
+
+    // Many laps around the slots keep first-in first-out
+    for (int i = 4; i < 1000; i++) {
+        CHECK(ring.pop(value));
+        CHECK(value == i - 4);
+        CHECK(ring.push(i));
+        CHECK(ring.size() == 4);
+    }
+    for (int i = 996; i < 1000; i++) {
+        CHECK(ring.pop(value));
+        CHECK(value == i);
+    }
+    CHECK(ring.empty());
+}
+
+static void testStress() {
+    const uint32_t COUNT = 2000000;
+    static SpscRing<Item, 16> ring;
+    uint32_t received = 0;
+    uint32_t bad = 0;
+    size_t maxSize = 0;
+
+    std::thread consumer([&] {
+        Item item;
+        while (received < COUNT) {
+            size_t size = ring.size();
+            if (size > maxSize) {
+                maxSize = size;
+            }
+            if (!ring.pop(item)) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (item.sequence != received || !intact(item)) {
+                bad++;
+            }
+            received++;
+        }
+    });
+
+    uint32_t fullCount = 0;
+    for (uint32_t i = 0; i < COUNT;) {
+        if (ring.push(makeItem(i))) {
+            i++;
+        } else {
+            fullCount++;
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+
+    CHECK(received == COUNT);
+    CHECK(bad == 0);
+    CHECK(maxSize <= ring.capacity());
+    CHECK(ring.empty());
+    printf("Stress: %u items, %u pushes refused while full, %u bad\n", COUNT, fullCount, bad);
+}
+
+int main() {
+    testSingleThread();
+    testStress();
+    return hostReport("test_spsc_ring");
+}
@@ -0,0 +1,115 @@
+#ifndef IMA_ADPCM_H
+#define IMA_ADPCM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Mono IMA-ADPCM block codec. Every block starts with a 4-byte header holding
+// the first sample and the step index, followed by 4-bit codes (low nibble
+// first), so any block can be decoded on its own. No Arduino dependencies.
+
+const size_t ADPCM_BLOCK_BYTES = 256;
+const size_t ADPCM_BLOCK_SAMPLES = 1 + (ADPCM_BLOCK_BYTES - 4) * 2; // 505
+
+// Header at the start of a transcoded clip file, followed by the blocks
+struct AdpcmFileHeader {
+    char magic[4];        // "IMAD"
+    uint8_t version;
+    uint8_t channels;     // Always 1
+    uint16_t blockBytes;
+    uint32_t sampleRate;
+    uint32_t totalSamples;
+};
+
+static const int16_t ADPCM_STEP_TABLE[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767
+};
+
+static const int8_t ADPCM_INDEX_TABLE[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+struct AdpcmState {
+    int32_t predictor;
+    int32_t index;
+};
+
+static inline int16_t adpcmDecodeNibble(AdpcmState &state, uint8_t code) {
+    int32_t step = ADPCM_STEP_TABLE[state.index];
+    int32_t diff = step >> 3;
+    if (code & 4) diff += step;
+    if (code & 2) diff += step >> 1;
+    if (code & 1) diff += step >> 2;
+    state.predictor += (code & 8) ? -diff : diff;
+    if (state.predictor > 32767) state.predictor = 32767;
+    if (state.predictor < -32768) state.predictor = -32768;
+    state.index += ADPCM_INDEX_TABLE[code & 15];
+    if (state.index < 0) state.index = 0;
+    if (state.index > 88) state.index = 88;
+    return (int16_t)state.predictor;
+}
+
+static inline uint8_t adpcmEncodeSample(AdpcmState &state, int16_t sample) {
+    int32_t step = ADPCM_STEP_TABLE[state.index];
+    int32_t diff = sample - state.predictor;
+    uint8_t code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+    if (diff >= step) { code |= 4; diff -= step; }
+    step >>= 1;
+    if (diff >= step) { code |= 2; diff -= step; }
+    step >>= 1;
+    if (diff >= step) { code |= 1; }
+    
+    // Track the decoder so both sides stay in sync
+    adpcmDecodeNibble(state, code);
+    return code;
+}
+
+// Encodes up to ADPCM_BLOCK_SAMPLES samples, returns the number of bytes written
+static inline size_t adpcmEncodeBlock(const int16_t *pcm, size_t count, uint8_t *out, AdpcmState &state) {
+    if (count == 0) {
+        return 0;
+    }
+    state.predictor = pcm[0];
+    out[0] = (uint8_t)(pcm[0] & 0xFF);
+    out[1] = (uint8_t)((pcm[0] >> 8) & 0xFF);
+    out[2] = (uint8_t)state.index;
+    out[3] = 0;
+    
+    size_t bytes = 4;
+    for (size_t i = 1; i < count; i += 2) {
+        uint8_t lo = adpcmEncodeSample(state, pcm[i]);
+        uint8_t hi = (i + 1 < count) ? adpcmEncodeSample(state, pcm[i + 1]) : 0;
+        out[bytes++] = lo | (hi << 4);
+    }
+    return bytes;
+}
+
+// Decodes one block, returns the number of samples produced
+static inline size_t adpcmDecodeBlock(const uint8_t *in, size_t length, int16_t *pcm) {
+    if (length < 4) {
+        return 0;
+    }
+    AdpcmState state;
+    state.predictor = (int16_t)(in[0] | (in[1] << 8));
+    state.index = in[2] > 88 ? 88 : in[2];
+    pcm[0] = (int16_t)state.predictor;
+    
+    size_t count = 1;
+    for (size_t i = 4; i < length; i++) {
+        pcm[count++] = adpcmDecodeNibble(state, in[i] & 0x0F);
+        pcm[count++] = adpcmDecodeNibble(state, in[i] >> 4);
+    }
+    return count;
+}
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Probes are written as METRIC_* macros so that with METRICS_ENABLED set to 0
+// neither the timing code nor the histograms are compiled in.
+#if METRICS_ENABLED
+
+const int HISTOGRAM_BUCKETS = 18; // Upper bounds 16 us, 32 us, ... 2.1 s, then +Inf
+
+// Latency histogram with power-of-two microsecond buckets. Each histogram has
+// a single writer task; /metrics reads it without locking, so a scrape may
+// catch one observation half recorded.
+class Histogram {
+private:
+    volatile uint32_t counts[HISTOGRAM_BUCKETS + 1];
+    volatile uint32_t total;
+    volatile uint64_t sum;
+
+public:
+    Histogram();
+    void observe(uint32_t us);
+    void write(Print &out, const char *name, const char *help) const;
+};
+
+struct Metrics {
+    Histogram pressToCallback;       // Button edge to the press callback (button task)
+    Histogram callbackToFirstSample; // Play request to first decoded sample (audio task)
+    Histogram decodeCall;            // One decoder loop() call (audio task)
+    Histogram mixBlock;              // Mixing, volume and limiter of one mixer block (audio task)
+    Histogram loopIteration;         // One pass of loop(), excluding its delay (loop task)
+    Histogram httpHandler;           // One HTTP route handler (AsyncTCP task)
+    Histogram wifiConnectCached;     // WiFi join after deep sleep with the cached access point, in ms (loop task)
+    Histogram wifiConnectScan;       // WiFi join with a full scan, in ms: cold boot or after a failure (loop task)
+    volatile uint32_t i2sUnderruns;  // Output ran dry while playing (audio task)
+    volatile uint32_t bootToFirstSampleUs; // Boot to the first decoded sample, 0 until a clip plays (audio task)
+    
+    void write(Print &out) const;
+};
+
+Metrics metrics;
+
+#define METRIC_TIMER_START(name) uint32_t name = micros()
+#define METRIC_OBSERVE(histogram, us) metrics.histogram.observe(us)
+#define METRIC_OBSERVE_SINCE(histogram, start) metrics.histogram.observe(micros() - (start))
+#define METRIC_COUNT(counter) (metrics.counter = metrics.counter + 1)
+#define METRIC_SET_ONCE(gauge, value) do { if (metrics.gauge == 0) metrics.gauge = (value); } while (0)
+
+// Implementation
+Histogram::Histogram() {
+    for (int i = 0; i <= HISTOGRAM_BUCKETS; i++) {
+        counts[i] = 0;
+    }
+    total = 0;
+    sum = 0;
+}
+
+void Histogram::observe(uint32_t us) {
+    // Smallest bucket whose bound 16 << i is at least us
+    int bucket = 0;
+    if (us > 16) {
+        bucket = 32 - __builtin_clz(us - 1) - 4;
+        if (bucket > HISTOGRAM_BUCKETS) {
+            bucket = HISTOGRAM_BUCKETS;
+        }
+    }
+    counts[bucket] = counts[bucket] + 1;
+    total = total + 1;
+    sum = sum + us;
+}
+
+void Histogram::write(Print &out, const char *name, const char *help) const {
+    out.printf("# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+    uint32_t cumulative = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        cumulative += counts[i];
+        out.printf("%s_bucket{le=\"%lu\"} %lu\n", name, 16UL << i, (unsigned long)cumulative);
+    }
+    cumulative += counts[HISTOGRAM_BUCKETS];
+    out.printf("%s_bucket{le=\"+Inf\"} %lu\n", name, (unsigned long)cumulative);
+    out.printf("%s_sum %llu\n%s_count %lu\n", name, (unsigned long long)sum, name, (unsigned long)total);
+}
+
+void Metrics::write(Print &out) const {
+    pressToCallback.write(out, "audiopad_press_to_callback_us", "Button edge to press callback");
+    callbackToFirstSample.write(out, "audiopad_callback_to_first_sample_us", "Play request to first decoded sample");
+    decodeCall.write(out, "audiopad_decode_call_us", "Time in one decoder loop call");
+    mixBlock.write(out, "audiopad_mix_block_us", "Time to mix, scale and limit one mixer block");
+    loopIteration.write(out, "audiopad_loop_iteration_us", "Time in one pass of loop");
+    httpHandler.write(out, "audiopad_http_handler_us", "Time in one HTTP handler");
+    wifiConnectCached.write(out, "audiopad_wifi_connect_cached_ms", "WiFi connect time after deep sleep, cached AP");
+    wifiConnectScan.write(out, "audiopad_wifi_connect_scan_ms", "WiFi connect time with a full scan");
+    
+    out.printf("# HELP audiopad_i2s_underruns_total Times the output ran dry while playing\n"
+               "# TYPE audiopad_i2s_underruns_total counter\naudiopad_i2s_underruns_total %lu\n",
+               (unsigned long)i2sUnderruns);
+    out.printf("# HELP audiopad_boot_to_first_sample_us Boot to the first decoded sample, 0 until a clip plays\n"
+               "# TYPE audiopad_boot_to_first_sample_us gauge\naudiopad_boot_to_first_sample_us %lu\n",
+               (unsigned long)bootToFirstSampleUs);
+    // The lowest free heap seen is the high-water mark of heap use
+    out.printf("# HELP audiopad_heap_free_bytes Free heap now\n"
+               "# TYPE audiopad_heap_free_bytes gauge\naudiopad_heap_free_bytes %lu\n",
+               (unsigned long)ESP.getFreeHeap());
+    out.printf("# HELP audiopad_heap_min_free_bytes Lowest free heap since boot\n"
+               "# TYPE audiopad_heap_min_free_bytes gauge\naudiopad_heap_min_free_bytes %lu\n",
+               (unsigned long)ESP.getMinFreeHeap());
+    out.printf("# HELP audiopad_heap_size_bytes Total heap\n"
+               "# TYPE audiopad_heap_size_bytes gauge\naudiopad_heap_size_bytes %lu\n",
+               (unsigned long)ESP.getHeapSize());
+}
+
+#else
+
+#define METRIC_TIMER_START(name) do {} while (0)
+#define METRIC_OBSERVE(histogram, us) do {} while (0)
+#define METRIC_OBSERVE_SINCE(histogram, start) do {} while (0)
+#define METRIC_COUNT(counter) do {} while (0)
+#define METRIC_SET_ONCE(gauge, value) do {} while (0)
+
+#endif
+
+#endif
@@ -4,8 +4,14 @@
 #include <ArduinoOTA.h>
 
 class OTAManager {
+private:
+    bool running = false;
+
 public:
     void init();
+    // Restart and end the OTA listener as the network comes and goes; init() starts it
+    void start();
+    void stop();
     void handle();
 };
 
@@ -46,11 +52,27 @@ void OTAManager::init() {
         }
     });
     
-    ArduinoOTA.begin();
+    start();
+}
+
+void OTAManager::start() {
+    if (!running) {
+        ArduinoOTA.begin();
+        running = true;
+    }
+}
+
+void OTAManager::stop() {
+    if (running) {
+        ArduinoOTA.end();
+        running = false;
+    }
 }
 
 void OTAManager::handle() {
-    ArduinoOTA.handle();
+    if (running) {
+        ArduinoOTA.handle();
+    }
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,117 @@
+#ifndef PAD_TOPOLOGY_H
+#define PAD_TOPOLOGY_H
+
+#include <stdint.h>
+#include <string.h>
+#include "config.h"
+
+// Clip file path in a fixed buffer, e.g. "/audio/button12.mp3" or "/audio/button12_3.mp3"
+struct ClipPath {
+    char text[32]; // Room for a ".tmp" suffix
+    
+    const char *c_str() const { return text; }
+    const char *name() const { return text + 7; } // Without the "/audio/" directory
+    const char *label() const { return text + 13; } // "12" or "12_3" for a path built with no extension
+};
+
+// Compile-time description of a pad: how many buttons it has and on which
+// GPIOs, how many can sound at once and how their clips are named. The
+// managers are templates over it, so every per-button and per-voice table is
+// a fixed-size array and all range checks share one limit. The clip tables
+// (ClipIndex, clip storage, PcmCache, PlaylistTable) exist once and use Pads.
+//
+// Each button has up to MAX_CLIPS_PER_BUTTON clip files: buttonN.mp3, then
+// buttonN_2.mp3 and on. Clips are numbered 1..clips with a button's first
+// clip numbered as the button itself, so clip N of a single-clip setup is
+// still buttonN.mp3; clip k of button N is (k - 1) * buttons + N.
+template<int BUTTONS, int VOICES, const int *PINS>
+struct PadTopology {
+    static_assert(BUTTONS >= 1 && BUTTONS <= 99, "Clip names have room for two digits of button number");
+    static_assert(MAX_CLIPS_PER_BUTTON >= 1 && MAX_CLIPS_PER_BUTTON <= 9, "Clip names have one digit of clip number");
+    static_assert(BUTTONS * MAX_CLIPS_PER_BUTTON <= 255, "Playlists store clip numbers in a byte");
+    static_assert(VOICES >= 1, "At least one voice is needed");
+    
+    static constexpr int buttons = BUTTONS;
+    static constexpr int voices = VOICES;
+    static constexpr int clips = BUTTONS * MAX_CLIPS_PER_BUTTON;
+    
+    static constexpr int pin(int index) { return PINS[index]; }
+    static constexpr bool isButton(int buttonNum) { return buttonNum >= 1 && buttonNum <= BUTTONS; }
+    static constexpr bool isClip(int clip) { return clip >= 1 && clip <= clips; }
+    static constexpr int clipOf(int buttonNum, int number) { return (number - 1) * BUTTONS + buttonNum; }
+    static constexpr int clipButton(int clip) { return (clip - 1) % BUTTONS + 1; }
+    static constexpr int clipNumber(int clip) { return (clip - 1) / BUTTONS + 1; }
+    
+    // "/audio/buttonN" or "/audio/buttonN_k" + extension, built without the heap
+    static ClipPath clipPath(int clip, const char *extension = ".mp3");
+    // Clip of a file name such as "button12.mp3" or "button12_3.mp3", 0 if it is not one
+    static int clipFromName(const char *name);
+    // Clip of a label such as "12" or "12_3" at the start of the text, 0 if
+    // it is not one; end is set to where the label stops
+    static int clipFromLabel(const char *label, const char **end = nullptr);
+};
+
+// Implementation
+template<int BUTTONS, int VOICES, const int *PINS>
+ClipPath PadTopology<BUTTONS, VOICES, PINS>::clipPath(int clip, const char *extension) {
+    ClipPath path;
+    memcpy(path.text, "/audio/button", 13);
+    size_t length = 13;
+    int buttonNum = clipButton(clip);
+    if (buttonNum >= 10) {
+        path.text[length++] = '0' + buttonNum / 10;
+    }
+    path.text[length++] = '0' + buttonNum % 10;
+    if (clipNumber(clip) > 1) {
+        path.text[length++] = '_';
+        path.text[length++] = '0' + clipNumber(clip);
+    }
+    strncpy(path.text + length, extension, sizeof(path.text) - length - 1);
+    path.text[sizeof(path.text) - 1] = '\0';
+    return path;
+}
+
+template<int BUTTONS, int VOICES, const int *PINS>
+int PadTopology<BUTTONS, VOICES, PINS>::clipFromLabel(const char *label, const char **end) {
+    const char *p = label;
+    int buttonNum = 0;
+    int number = 1;
+    if (*p == '0') {
+        return 0;
+    }
+    while (*p >= '0' && *p <= '9' && buttonNum <= BUTTONS) {
+        buttonNum = buttonNum * 10 + (*p++ - '0');
+    }
+    if (*p == '_') {
+        p++;
+        if (*p < '2' || *p > '9') {
+            return 0;
+        }
+        number = *p++ - '0';
+    }
+    if (end) {
+        *end = p;
+    }
+    if (!isButton(buttonNum) || number > MAX_CLIPS_PER_BUTTON) {
+        return 0;
+    }
+    return clipOf(buttonNum, number);
+}
+
+template<int BUTTONS, int VOICES, const int *PINS>
+int PadTopology<BUTTONS, VOICES, PINS>::clipFromName(const char *name) {
+    if (strncmp(name, "button", 6) != 0) {
+        return 0;
+    }
+    const char *end = nullptr;
+    int clip = clipFromLabel(name + 6, &end);
+    if (clip == 0 || strcmp(end, ".mp3") != 0) {
+        return 0;
+    }
+    return clip;
+}
+
+// The pad this firmware is built for
+typedef PadTopology<NUM_BUTTONS, MAX_VOICES, BUTTON_PINS> Pads;
+
+#endif
@@ -0,0 +1,331 @@
+#ifndef PCM_CACHE_H
+#define PCM_CACHE_H
+
+#include "AudioFileSourceSPIFFS.h"
+#include "AudioFileSourceID3.h"
+#include "AudioGeneratorMP3.h"
+#include "AudioOutput.h"
+#include "clip_index.h"
+#include "config.h"
+#include "pad_topology.h"
+
+// Decoded start of one clip, stored as interleaved stereo 16-bit frames
+struct PcmPrefix {
+    int16_t *frames;
+    uint32_t frameCount;
+    uint16_t sampleRate;
+};
+
+// AudioOutput that records the first PCM_PREFIX_MS of decoded audio into RAM
+class PcmCaptureOutput : public AudioOutput {
+private:
+    int16_t *buffer;
+    uint32_t capacity;
+    uint32_t count;
+    size_t budgetLeft;
+    bool failed;
+
+public:
+    PcmCaptureOutput(size_t budget);
+    virtual bool begin() override { return true; }
+    virtual bool ConsumeSample(int16_t sample[2]) override;
+    virtual bool stop() override { return true; }
+    bool isFull() const { return capacity > 0 && count >= capacity; }
+    bool hasFailed() const { return failed; }
+    // Hands the captured frames over to the caller, who becomes responsible for freeing them
+    int16_t *release(uint32_t &frameCount, uint16_t &sampleRate);
+};
+
+// Output stage placed between the MP3 decoder and its mixer voice. It first plays the
+// cached prefix, while the decoder catches up by discarding the frames that
+// the prefix already covered, then passes decoded audio straight through.
+class PrefixHandoffOutput : public AudioOutput {
+private:
+    AudioOutput *sink;
+    const PcmPrefix *prefix;
+    uint32_t prefixPos;
+    uint32_t skipped;
+
+public:
+    PrefixHandoffOutput();
+    void setSink(AudioOutput *output) { sink = output; }
+    void start(const PcmPrefix *cached);
+    void pumpPrefix();
+    bool prefixDone() const { return prefix == nullptr || prefixPos >= prefix->frameCount; }
+    
+    virtual bool SetRate(int hz) override { return sink->SetRate(hz); }
+    virtual bool SetBitsPerSample(int bits) override { return sink->SetBitsPerSample(bits); }
+    virtual bool SetChannels(int chan) override { return sink->SetChannels(chan); }
+    virtual bool begin() override { return sink->begin(); }
+    virtual bool ConsumeSample(int16_t sample[2]) override;
+    virtual bool stop() override;
+};
+
+// Bounded per-clip cache of decoded clip prefixes. prepare() decodes a
+// prefix into a staging slot on a background task; the audio task takes it
+// live with swapIn(), so decoding never holds up playback. get(), swapIn()
+// and invalidate() run on the audio task only.
+class PcmCache {
+private:
+    PcmPrefix entries[Pads::clips]; // Live
+    PcmPrefix staged[Pads::clips];  // Decoded by prepare(), waiting for swapIn()
+    bool ready[Pads::clips];        // staged holds a result, possibly empty
+    uint32_t epochs[Pads::clips];   // Bumped by invalidate(), so a decode it overtook is dropped
+    size_t bytesUsed;               // Live and staged
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED; // Guards staged, ready, epochs and bytesUsed
+    
+    bool decode(int clip, PcmPrefix &prefix);
+    static size_t bytesOf(const PcmPrefix &prefix) { return prefix.frameCount * 2 * sizeof(int16_t); }
+
+public:
+    PcmCache();
+    ~PcmCache();
+    void prepareAll();
+    bool prepare(int clip);
+    void swapIn(int clip);
+    void swapInAll();
+    void invalidate(int clip);
+    const PcmPrefix *get(int clip) const;
+    size_t getBytesUsed() const { return bytesUsed; }
+};
+
+// Implementation
+PcmCaptureOutput::PcmCaptureOutput(size_t budget) {
+    buffer = nullptr;
+    capacity = 0;
+    count = 0;
+    budgetLeft = budget;
+    failed = false;
+    hertz = 44100;
+    bps = 16;
+    channels = 2;
+}
+
+bool PcmCaptureOutput::ConsumeSample(int16_t sample[2]) {
+    if (failed || isFull()) {
+        return false;
+    }
+    
+    // The decoder reports the sample rate before its first sample, so size the buffer now
+    if (!buffer) {
+        capacity = (uint32_t)((uint64_t)hertz * PCM_PREFIX_MS / 1000);
+        size_t bytes = capacity * 2 * sizeof(int16_t);
+        if (capacity == 0 || bytes > budgetLeft) {
+            failed = true;
+            return false;
+        }
+        buffer = psramFound() ? (int16_t *)ps_malloc(bytes) : nullptr;
+        if (!buffer) {
+            buffer = (int16_t *)malloc(bytes);
+        }
+        if (!buffer) {
+            failed = true;
+            return false;
+        }
+    }
+    
+    int16_t frame[2] = {sample[0], sample[1]};
+    MakeSampleStereo16(frame);
+    buffer[count * 2] = frame[0];
+    buffer[count * 2 + 1] = frame[1];
+    count++;
+    return true;
+}
+
+int16_t *PcmCaptureOutput::release(uint32_t &frameCount, uint16_t &sampleRate) {
+    int16_t *frames = buffer;
+    frameCount = count;
+    sampleRate = hertz;
+    buffer = nullptr;
+    capacity = 0;
+    count = 0;
+    return frames;
+}
+
+PrefixHandoffOutput::PrefixHandoffOutput() {
+    sink = nullptr;
+    prefix = nullptr;
+    prefixPos = 0;
+    skipped = 0;
+}
+
+void PrefixHandoffOutput::start(const PcmPrefix *cached) {
+    prefix = cached;
+    prefixPos = 0;
+    skipped = 0;
+    
+    if (prefix) {
+        sink->SetRate(prefix->sampleRate);
+        sink->SetBitsPerSample(16);
+        sink->SetChannels(2);
+        sink->begin();
+        pumpPrefix();
+    }
+}
+
+void PrefixHandoffOutput::pumpPrefix() {
+    while (!prefixDone()) {
+        if (!sink->ConsumeSample(&prefix->frames[prefixPos * 2])) {
+            break; // I2S DMA buffers are full, continue on the next update
+        }
+        prefixPos++;
+    }
+}
+
+bool PrefixHandoffOutput::ConsumeSample(int16_t sample[2]) {
+    if (prefix) {
+        // Drop decoded frames that the cached prefix already played
+        if (skipped < prefix->frameCount) {
+            skipped++;
+            return true;
+        }
+        // Hold the decoder back until the prefix has been fully queued
+        if (!prefixDone()) {
+            return false;
+        }
+    }
+    
+    return sink->ConsumeSample(sample);
+}
+
+bool PrefixHandoffOutput::stop() {
+    prefix = nullptr;
+    return sink->stop();
+}
+
+PcmCache::PcmCache() {
+    for (int i = 0; i < Pads::clips; i++) {
+        entries[i] = {nullptr, 0, 0};
+        staged[i] = {nullptr, 0, 0};
+        ready[i] = false;
+        epochs[i] = 0;
+    }
+    bytesUsed = 0;
+}
+
+PcmCache::~PcmCache() {
+    for (int i = 1; i <= Pads::clips; i++) {
+        invalidate(i);
+    }
+}
+
+void PcmCache::prepareAll() {
+    for (int i = 1; i <= Pads::clips; i++) {
+        prepare(i);
+    }
+    Serial.printf("PCM prefix cache: %u bytes used of %u\n", bytesUsed, PCM_CACHE_BUDGET_BYTES);
+}
+
+// Stages the clip's prefix, or no prefix if it has none; false if there is none
+bool PcmCache::prepare(int clip) {
+    if (!Pads::isClip(clip)) {
+        return false;
+    }
+    portENTER_CRITICAL(&lock);
+    uint32_t epoch = epochs[clip - 1];
+    portEXIT_CRITICAL(&lock);
+    
+    PcmPrefix prefix = {nullptr, 0, 0};
+    bool decoded = clipIndex.has(clip) && decode(clip, prefix);
+    
+    PcmPrefix replaced = {nullptr, 0, 0};
+    portENTER_CRITICAL(&lock);
+    if (epochs[clip - 1] == epoch) {
+        replaced = staged[clip - 1];
+        staged[clip - 1] = prefix;
+        ready[clip - 1] = true;
+        bytesUsed += bytesOf(prefix);
+        bytesUsed -= bytesOf(replaced);
+    } else {
+        replaced = prefix; // The clip was closed while it decoded
+        decoded = false;
+    }
+    portEXIT_CRITICAL(&lock);
+    free(replaced.frames);
+    return decoded;
+}
+
+bool PcmCache::decode(int clip, PcmPrefix &prefix) {
+    ClipPath filename = Pads::clipPath(clip);
+    portENTER_CRITICAL(&lock);
+    size_t budget = bytesUsed < PCM_CACHE_BUDGET_BYTES ? PCM_CACHE_BUDGET_BYTES - bytesUsed : 0;
+    portEXIT_CRITICAL(&lock);
+    
+    AudioFileSourceSPIFFS file(filename.c_str());
+    AudioFileSourceID3 id3(&file);
+    AudioGeneratorMP3 decoder;
+    PcmCaptureOutput capture(budget);
+    
+    if (!decoder.begin(&id3, &capture)) {
+        Serial.printf("PCM cache: cannot decode %s\n", filename.c_str());
+        return false;
+    }
+    while (!capture.isFull() && !capture.hasFailed() && decoder.loop()) {
+    }
+    decoder.stop();
+    
+    prefix.frames = capture.release(prefix.frameCount, prefix.sampleRate);
+    if (capture.hasFailed() || !prefix.frames || prefix.frameCount == 0) {
+        Serial.printf("PCM cache: no room for %s\n", filename.c_str());
+        free(prefix.frames);
+        prefix = {nullptr, 0, 0};
+        return false;
+    }
+    Serial.printf("PCM cache: %s prefix %u frames @ %u Hz\n", filename.c_str(), prefix.frameCount, prefix.sampleRate);
+    return true;
+}
+
+// Takes the staged prefix live; keeps the live one if nothing was staged
+void PcmCache::swapIn(int clip) {
+    if (!Pads::isClip(clip)) {
+        return;
+    }
+    PcmPrefix &entry = entries[clip - 1];
+    PcmPrefix replaced = entry;
+    portENTER_CRITICAL(&lock);
+    if (!ready[clip - 1]) {
+        portEXIT_CRITICAL(&lock);
+        return;
+    }
+    entry = staged[clip - 1];
+    staged[clip - 1] = {nullptr, 0, 0};
+    ready[clip - 1] = false;
+    bytesUsed -= bytesOf(replaced);
+    portEXIT_CRITICAL(&lock);
+    free(replaced.frames);
+}
+
+void PcmCache::swapInAll() {
+    for (int i = 1; i <= Pads::clips; i++) {
+        swapIn(i);
+    }
+}
+
+// Drops the live prefix and any staged or still decoding one
+void PcmCache::invalidate(int clip) {
+    if (!Pads::isClip(clip)) {
+        return;
+    }
+    PcmPrefix &entry = entries[clip - 1];
+    PcmPrefix live = entry;
+    portENTER_CRITICAL(&lock);
+    PcmPrefix pending = staged[clip - 1];
+    staged[clip - 1] = {nullptr, 0, 0};
+    ready[clip - 1] = false;
+    epochs[clip - 1]++;
+    bytesUsed -= bytesOf(live) + bytesOf(pending);
+    entry = {nullptr, 0, 0};
+    portEXIT_CRITICAL(&lock);
+    free(live.frames);
+    free(pending.frames);
+}
+
+const PcmPrefix *PcmCache::get(int clip) const {
+    if (!Pads::isClip(clip)) {
+        return nullptr;
+    }
+    const PcmPrefix &entry = entries[clip - 1];
+    return entry.frames ? &entry : nullptr;
+}
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef PLAYLIST_H
+#define PLAYLIST_H
+
+#include <atomic>
+#include <SPIFFS.h>
+#include <FS.h>
+#include "config.h"
+#include "pad_topology.h"
+
+// What a press does with the clips of a button's playlist
+enum PlaylistMode : uint8_t {
+    PLAYLIST_ROUND_ROBIN, // Each press plays the next clip
+    PLAYLIST_RANDOM,      // Each press plays a random clip, never the same one twice in a row
+    PLAYLIST_SEQUENCE,    // A press plays every clip back to back, once
+    PLAYLIST_LOOP,        // A press plays every clip back to back until stopped
+    PLAYLIST_MODE_COUNT
+};
+
+// A playlist is a list of clip numbers (see pad_topology.h), so it can mix a
+// button's own files (buttonN.mp3, buttonN_2.mp3, ...) with other buttons'.
+// By default every button plays only its first clip, buttonN.mp3.
+struct Playlist {
+    uint8_t clips[PLAYLIST_MAX_CLIPS];
+    uint8_t count;
+    PlaylistMode mode;
+    uint8_t cursor; // Next position for round-robin, last one played for random
+    
+    bool chains() const { return mode == PLAYLIST_SEQUENCE || mode == PLAYLIST_LOOP; }
+    // Position played after the given one in a chain, -1 once a sequence is done
+    int after(int position) const;
+};
+
+// Playlist of every button. Set from the web handlers, read and advanced by
+// the audio task, so each access copies under a short lock. set() only marks
+// the table changed; the loop task saves it to PLAYLIST_PATH through
+// saveChanges(), so no SPIFFS write runs on the AsyncTCP task.
+class PlaylistTable {
+private:
+    Playlist lists[Pads::buttons];
+    mutable portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    std::atomic<bool> changed;
+
+public:
+    PlaylistTable();
+    void begin();
+    bool set(int buttonNum, const uint8_t *clips, int count, PlaylistMode mode);
+    void saveChanges();
+    Playlist get(int buttonNum) const;
+    // Position a new press of the button starts at; moves round-robin and random on
+    int pick(int buttonNum, uint32_t random);
+    
+    static const char *modeName(PlaylistMode mode);
+    static bool parseMode(const char *name, PlaylistMode &mode);
+};
+
+PlaylistTable playlists;
+
+// Implementation
+int Playlist::after(int position) const {
+    if (position + 1 < count) {
+        return position + 1;
+    }
+    return mode == PLAYLIST_LOOP ? 0 : -1;
+}
+
+PlaylistTable::PlaylistTable() : changed(false) {
+    for (int i = 0; i < Pads::buttons; i++) {
+        memset(&lists[i], 0, sizeof(Playlist));
+        lists[i].clips[0] = i + 1;
+        lists[i].count = 1;
+        lists[i].mode = PLAYLIST_ROUND_ROBIN;
+    }
+}
+
+void PlaylistTable::begin() {
+    File file = SPIFFS.open(PLAYLIST_PATH, "r");
+    if (!file) {
+        return;
+    }
+    Playlist saved[Pads::buttons];
+    bool valid = file.read((uint8_t *)saved, sizeof(saved)) == sizeof(saved);
+    file.close();
+    for (int i = 0; valid && i < Pads::buttons; i++) {
+        valid = saved[i].count >= 1 && saved[i].count <= PLAYLIST_MAX_CLIPS && saved[i].mode < PLAYLIST_MODE_COUNT;
+        for (int j = 0; valid && j < saved[i].count; j++) {
+            valid = Pads::isClip(saved[i].clips[j]);
+        }
+    }
+    if (!valid) {
+        Serial.println("Ignoring invalid playlist file");
+        return;
+    }
+    memcpy(lists, saved, sizeof(lists));
+}
+
+bool PlaylistTable::set(int buttonNum, const uint8_t *clips, int count, PlaylistMode mode) {
+    if (!Pads::isButton(buttonNum) || count < 1 || count > PLAYLIST_MAX_CLIPS || mode >= PLAYLIST_MODE_COUNT) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (!Pads::isClip(clips[i])) {
+            return false;
+        }
+    }
+    Playlist list;
+    memset(&list, 0, sizeof(list));
+    memcpy(list.clips, clips, count);
+    list.count = count;
+    list.mode = mode;
+    list.cursor = mode == PLAYLIST_RANDOM ? count : 0; // Random: nothing played yet
+    
+    portENTER_CRITICAL(&lock);
+    lists[buttonNum - 1] = list;
+    portEXIT_CRITICAL(&lock);
+    changed = true;
+    return true;
+}
+
+Playlist PlaylistTable::get(int buttonNum) const {
+    portENTER_CRITICAL(&lock);
+    Playlist list = lists[buttonNum - 1];
+    portEXIT_CRITICAL(&lock);
+    return list;
+}
+
+int PlaylistTable::pick(int buttonNum, uint32_t random) {
+    portENTER_CRITICAL(&lock);
+    Playlist &list = lists[buttonNum - 1];
+    int position = 0;
+    if (list.mode == PLAYLIST_ROUND_ROBIN) {
+        position = list.cursor < list.count ? list.cursor : 0;
+        list.cursor = (position + 1) % list.count;
+    } else if (list.mode == PLAYLIST_RANDOM) {
+        if (list.cursor < list.count && list.count > 1) {
+            // Draw from the others, then step over the one played last
+            position = random % (list.count - 1);
+            if (position >= list.cursor) {
+                position++;
+            }
+        } else {
+            position = random % list.count;
+        }
+        list.cursor = position;
+    }
+    portEXIT_CRITICAL(&lock);
+    return position;
+}
+
+void PlaylistTable::saveChanges() {
+    if (!changed.exchange(false)) {
+        return;
+    }
+    Playlist saved[Pads::buttons];
+    portENTER_CRITICAL(&lock);
+    memcpy(saved, lists, sizeof(saved));
+    portEXIT_CRITICAL(&lock);
+    
+    File file = SPIFFS.open(PLAYLIST_PATH, "w");
+    if (!file || file.write((const uint8_t *)saved, sizeof(saved)) != sizeof(saved)) {
+        Serial.println("Failed to save playlists");
+    }
+    file.close();
+}
+
+const char *PlaylistTable::modeName(PlaylistMode mode) {
+    switch (mode) {
+        case PLAYLIST_RANDOM:
+            return "random";
+        case PLAYLIST_SEQUENCE:
+            return "sequence";
+        case PLAYLIST_LOOP:
+            return "loop";
+        default:
+            return "round-robin";
+    }
+}
+
+bool PlaylistTable::parseMode(const char *name, PlaylistMode &mode) {
+    for (int i = 0; i < PLAYLIST_MODE_COUNT; i++) {
+        if (strcmp(name, modeName((PlaylistMode)i)) == 0) {
+            mode = (PlaylistMode)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif
@@ -2,44 +2,104 @@
 #define POWER_MANAGER_H
 
 #include "esp_sleep.h"
+#include "esp_pm.h"
 #include "driver/rtc_io.h"   // Needed for RTC GPIO functions
+#include "power_model.h"
 #include "config.h"
 
+// Three tiers: fully on, automatic light sleep between events, and deep
+// sleep. PowerModel picks the tier. Light sleep is allowed while nobody holds
+// awakeLock, so updateActivity() and keepAwake() only have to take the lock to
+// keep the chip awake for the press, cue or clip at hand. They may run on any
+// task; the radio's sleep setting blocks on the WiFi driver, so it follows
+// the tier on the loop task in update().
 class PowerManager {
 private:
-    unsigned long lastActivityTime;
+    PowerModel model;
+    volatile PowerTier tier;
     bool sleepEnabled;
+    bool lightSleepAvailable; // The core supports automatic light sleep
+    int wakeButton;           // Button whose press woke the device from deep sleep, 0 if none
+    esp_pm_lock_handle_t awakeLock;
+    uint32_t wakeups;         // keepAwake() calls, so a sleep decision can tell it is stale
+    bool radioSleeping;       // Loop task only
+    // updateActivity() is called from the button, web, UDP and clock sync tasks, keepAwake() also from audio
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
     
+    void setupLightSleep();
     void setupWakeupSources();
+    void relax(PowerTier next, uint32_t decidedAt);
     void enterDeepSleep();
-    
+
 public:
     PowerManager();
     void init();
+    void update();
     void updateActivity();
+    void keepAwake();
     void checkSleepConditions(bool isAudioPlaying);
     void enableSleep(bool enable);
     bool isSleepEnabled() const { return sleepEnabled; }
+    PowerTier getTier() const { return tier; }
+    int getWakeButton() const { return wakeButton; }
     unsigned long getTimeSinceActivity() const;
     void handleWakeup();
 };
 
 // Implementation
-PowerManager::PowerManager() {
-    lastActivityTime = millis();
+static const PowerTierCost POWER_TIER_COSTS[POWER_TIER_COUNT] = {
+    {POWER_ACTIVE_MA, 0.0f},
+    {POWER_LIGHT_SLEEP_MA, LIGHT_SLEEP_WAKE_MS},
+    {POWER_DEEP_SLEEP_MA, DEEP_SLEEP_WAKE_MS},
+};
+
+PowerManager::PowerManager()
+    : model(POWER_TIER_COSTS, POWER_LATENCY_WEIGHT, LIGHT_SLEEP_HOLD_MS, SLEEP_TIMEOUT_MS) {
+    model.extend(millis());
+    tier = POWER_TIER_ACTIVE;
     sleepEnabled = true;
+    lightSleepAvailable = false;
+    wakeButton = 0;
+    awakeLock = nullptr;
+    wakeups = 0;
+    radioSleeping = false;
 }
 
 void PowerManager::init() {
     // Print wake up reason
     handleWakeup();
     
-    // Setup wake up sources
-    setupWakeupSources();
+    if (LIGHT_SLEEP_ENABLED) {
+        setupLightSleep();
+    }
     
     Serial.printf("Power management initialized. Sleep timeout: %lu seconds\n", SLEEP_TIMEOUT_MS / 1000);
 }
 
+void PowerManager::setupLightSleep() {
+    // Held from the start: the device begins in the active tier
+    if (esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "awake", &awakeLock) != ESP_OK) {
+        Serial.println("Light sleep unavailable: cannot create power lock");
+        return;
+    }
+    esp_pm_lock_acquire(awakeLock);
+    
+    // A fixed clock keeps I2S and the ADC timing as they are
+    esp_pm_config_esp32_t config;
+    config.max_freq_mhz = CPU_FREQ_MHZ;
+    config.min_freq_mhz = CPU_FREQ_MHZ;
+    config.light_sleep_enable = true;
+    esp_err_t result = esp_pm_configure(&config);
+    if (result != ESP_OK) {
+        Serial.printf("Light sleep unavailable (%s), the core needs CONFIG_PM_ENABLE\n", esp_err_to_name(result));
+        return;
+    }
+    // The buttons arm themselves as level wake sources, see button_manager.h
+    esp_sleep_enable_gpio_wakeup();
+    lightSleepAvailable = true;
+    Serial.println("Light sleep enabled between events");
+}
+
 void PowerManager::handleWakeup() {
     esp_sleep_wakeup_cause_t wakeup_reason = esp_sleep_get_wakeup_cause();
     
@@ -47,7 +107,7 @@ void PowerManager::handleWakeup() {
         case ESP_SLEEP_WAKEUP_EXT0:
             Serial.println("Wakeup caused by external signal using RTC_IO");
             break;
-
+        
         case ESP_SLEEP_WAKEUP_EXT1: {
             Serial.println("Wakeup caused by external signal using RTC_CNTL");
             uint64_t wakeup_pin_mask = esp_sleep_get_ext1_wakeup_status();
@@ -56,30 +116,34 @@ void PowerManager::handleWakeup() {
                     int pin = BUTTON_PINS[i];
                     if (wakeup_pin_mask & (1ULL << pin)) {
                         Serial.printf("Wake up from Button %d (GPIO %d)\n", i + 1, pin);
+                        if (wakeButton == 0) {
+                            wakeButton = i + 1;
+                        }
                     }
                 }
             }
             break;
         }
-
+        
         case ESP_SLEEP_WAKEUP_TIMER:
             Serial.println("Wakeup caused by timer");
             break;
-
+        
         case ESP_SLEEP_WAKEUP_TOUCHPAD:
             Serial.println("Wakeup caused by touchpad");
             break;
-
+        
         case ESP_SLEEP_WAKEUP_ULP:
             Serial.println("Wakeup caused by ULP program");
             break;
-
+        
         default:
             Serial.printf("Wakeup was not caused by deep sleep: %d\n", wakeup_reason);
             break;
     }
 }
 
+// Armed right before deep sleep: the ext1 level would end every light sleep at once
 void PowerManager::setupWakeupSources() {
     uint64_t ext_wakeup_pin_mask = 0;
     
@@ -90,7 +154,7 @@ void PowerManager::setupWakeupSources() {
         if (rtc_gpio_is_valid_gpio((gpio_num_t)pin)) {
             ext_wakeup_pin_mask |= (1ULL << pin);
             Serial.printf("Button %d (GPIO %d) configured as wake source\n", i + 1, pin);
-
+            
             // Configure pin for wakeup: disable pull-up, enable pulldown
             rtc_gpio_pullup_dis((gpio_num_t)pin);
             rtc_gpio_pulldown_en((gpio_num_t)pin);
@@ -106,37 +170,92 @@ void PowerManager::setupWakeupSources() {
     } else {
         Serial.println("Warning: No valid RTC GPIO pins found for wake up!");
     }
-
+    
     // Optional: timer wake up as backup
     // esp_sleep_enable_timer_wakeup(SLEEP_TIMEOUT_MS * 1000); // Convert to microseconds
 }
 
 void PowerManager::updateActivity() {
-    lastActivityTime = millis();
+    portENTER_CRITICAL(&lock);
+    model.addEvent(millis());
+    portEXIT_CRITICAL(&lock);
+    // Stay awake for whatever the event starts
+    keepAwake();
+}
+
+// Takes the lock at once, for a queued cue or a clip about to start
+void PowerManager::keepAwake() {
+    portENTER_CRITICAL(&lock);
+    wakeups++;
+    bool wasActive = tier == POWER_TIER_ACTIVE;
+    tier = POWER_TIER_ACTIVE;
+    if (!wasActive && lightSleepAvailable) {
+        esp_pm_lock_acquire(awakeLock);
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+// Runs on the loop task
+void PowerManager::update() {
+    if (radioSleeping && tier == POWER_TIER_ACTIVE) {
+        WiFi.setSleep(false); // Answer requests without waiting for the next beacon
+        radioSleeping = false;
+    }
+}
+
+// Runs on the loop task. Drops to a lower tier unless keepAwake() ran since
+// the decision was taken, when wakeups read decidedAt.
+void PowerManager::relax(PowerTier next, uint32_t decidedAt) {
+    if (lightSleepAvailable && !radioSleeping) {
+        WiFi.setSleep(true); // Modem sleep, required for light sleep with WiFi connected
+        radioSleeping = true;
+    }
+    portENTER_CRITICAL(&lock);
+    bool current = wakeups == decidedAt;
+    bool release = current && tier == POWER_TIER_ACTIVE && lightSleepAvailable;
+    if (current) {
+        tier = next;
+    }
+    if (release) {
+        esp_pm_lock_release(awakeLock);
+    }
+    portEXIT_CRITICAL(&lock);
+    if (release) {
+        Serial.println("Entering light sleep between events");
+    }
 }
 
 void PowerManager::checkSleepConditions(bool isAudioPlaying) {
-    if (!sleepEnabled) {
-        return;
+    unsigned long now = millis();
+    portENTER_CRITICAL(&lock);
+    if (isAudioPlaying) {
+        model.extend(now); // Reset activity timer while audio is playing
     }
+    PowerTier next = model.choose(now, isAudioPlaying);
+    uint32_t decidedAt = wakeups;
+    portEXIT_CRITICAL(&lock);
     
-    // Don't sleep while audio is playing
-    if (isAudioPlaying) {
-        updateActivity(); // Reset activity timer while audio is playing
+    if (next == POWER_TIER_ACTIVE) {
+        keepAwake();
+    } else if (next != POWER_TIER_DEEP_SLEEP || !sleepEnabled) {
+        relax(POWER_TIER_LIGHT_SLEEP, decidedAt);
+    }
+    if (!sleepEnabled || isAudioPlaying) {
         return;
     }
     
     unsigned long timeSinceActivity = getTimeSinceActivity();
     
     // Check if it's time to sleep
-    if (timeSinceActivity >= SLEEP_TIMEOUT_MS) {
+    if (next == POWER_TIER_DEEP_SLEEP) {
         Serial.printf("Entering deep sleep after %lu seconds of inactivity\n", timeSinceActivity / 1000);
         
         // Give some time for serial output
         delay(100);
         
         enterDeepSleep();
-    } else if (timeSinceActivity >= (SLEEP_TIMEOUT_MS - SLEEP_WARNING_TIME_MS)) {
+    } else if (timeSinceActivity >= (SLEEP_TIMEOUT_MS - SLEEP_WARNING_TIME_MS) &&
+               timeSinceActivity < SLEEP_TIMEOUT_MS) {
         // Optional: Print warning before sleep (only once)
         static bool warningPrinted = false;
         if (!warningPrinted) {
@@ -151,6 +270,8 @@ void PowerManager::enterDeepSleep() {
     Serial.println("Preparing for deep sleep...");
     Serial.flush();
     
+    setupWakeupSources();
+    
     // Disable WiFi to save power
     WiFi.disconnect(true);
     WiFi.mode(WIFI_OFF);
@@ -172,7 +293,7 @@ void PowerManager::enableSleep(bool enable) {
 }
 
 unsigned long PowerManager::getTimeSinceActivity() const {
-    return millis() - lastActivityTime;
+    return model.idleMs(millis());
 }
 
 #endif
@@ -0,0 +1,90 @@
+#ifndef POWER_MODEL_H
+#define POWER_MODEL_H
+
+#include <stdint.h>
+
+enum PowerTier : uint8_t {
+    POWER_TIER_ACTIVE,      // CPU and radio always on, nothing to wake up
+    POWER_TIER_LIGHT_SLEEP, // Automatic light sleep and WiFi modem sleep between events
+    POWER_TIER_DEEP_SLEEP,  // Off until a button press reboots the device
+    POWER_TIER_COUNT
+};
+
+// What sitting idle in one tier costs
+struct PowerTierCost {
+    float milliamps; // Average draw while idle
+    float wakeMs;    // From a button press to the first sample
+};
+
+// Picks a power tier from recent activity. A running average of the gaps
+// between activity events predicts how long the current quiet spell lasts:
+// at least that average, or as long as it has already lasted if that is
+// longer. Each tier costs its draw over that gap plus its wake latency
+// weighed at latencyWeight (mA*s per ms of delay), and the cheapest tier the
+// device is allowed to be in wins. Light sleep is allowed holdMs after the
+// last event, deep sleep deepAfterMs after it. No Arduino dependencies, so
+// activity traces can be replayed on a PC.
+class PowerModel {
+private:
+    PowerTierCost costs[POWER_TIER_COUNT];
+    float latencyWeight;
+    uint32_t holdMs;
+    uint32_t deepAfterMs;
+    float meanGapMs;
+    uint32_t lastEventMs;
+
+public:
+    PowerModel(const PowerTierCost (&costs)[POWER_TIER_COUNT], float latencyWeight, uint32_t holdMs,
+               uint32_t deepAfterMs);
+    void addEvent(uint32_t nowMs);
+    // Activity that goes on, such as playback: restarts the idle time without counting as an event
+    void extend(uint32_t nowMs) { lastEventMs = nowMs; }
+    // busy: audio is playing, which needs the CPU and I2S clocks running
+    PowerTier choose(uint32_t nowMs, bool busy) const;
+    float expectedGapMs(uint32_t nowMs) const;
+    uint32_t idleMs(uint32_t nowMs) const { return nowMs - lastEventMs; }
+};
+
+// Implementation
+inline PowerModel::PowerModel(const PowerTierCost (&costs)[POWER_TIER_COUNT], float latencyWeight, uint32_t holdMs,
+                              uint32_t deepAfterMs)
+    : latencyWeight(latencyWeight), holdMs(holdMs), deepAfterMs(deepAfterMs), meanGapMs(0.0f), lastEventMs(0) {
+    for (int i = 0; i < POWER_TIER_COUNT; i++) {
+        this->costs[i] = costs[i];
+    }
+}
+
+inline void PowerModel::addEvent(uint32_t nowMs) {
+    // Gaps shorter than the hold time are one burst of activity, not a pattern
+    uint32_t gap = nowMs - lastEventMs;
+    if (gap >= holdMs) {
+        meanGapMs = meanGapMs == 0.0f ? gap : meanGapMs + 0.25f * (gap - meanGapMs);
+    }
+    lastEventMs = nowMs;
+}
+
+inline float PowerModel::expectedGapMs(uint32_t nowMs) const {
+    float idle = (float)idleMs(nowMs);
+    return idle > meanGapMs ? idle : meanGapMs;
+}
+
+inline PowerTier PowerModel::choose(uint32_t nowMs, bool busy) const {
+    uint32_t idle = idleMs(nowMs);
+    if (busy || idle < holdMs) {
+        return POWER_TIER_ACTIVE;
+    }
+    int allowed = idle >= deepAfterMs ? POWER_TIER_DEEP_SLEEP : POWER_TIER_LIGHT_SLEEP;
+    float gapSeconds = expectedGapMs(nowMs) / 1000.0f;
+    PowerTier best = POWER_TIER_ACTIVE;
+    float bestCost = 0.0f;
+    for (int i = 0; i <= allowed; i++) {
+        float cost = costs[i].milliamps * gapSeconds + latencyWeight * costs[i].wakeMs;
+        if (i == 0 || cost < bestCost) {
+            best = (PowerTier)i;
+            bestCost = cost;
+        }
+    }
+    return best;
+}
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef RESPONSE_WRITER_H
+#define RESPONSE_WRITER_H
+
+#include <utility>
+#include <ESPAsyncWebServer.h>
+#include "config.h"
+
+// "\"name\":" joined by the compiler, e.g. json.text("{" JSON_KEY("volume"))
+#define JSON_KEY(name) "\"" name "\":"
+
+// Appends text and numbers to a caller-owned buffer, keeping it NUL
+// terminated. Nothing here touches the heap; numbers are formatted by hand
+// because newlib's printf allocates when it formats floats.
+class ResponseWriter {
+private:
+    char *buffer;
+    size_t capacity;
+    size_t length;
+    bool overflow;
+
+public:
+    ResponseWriter(char *buffer, size_t capacity);
+    
+    // String literals; their length is known at compile time
+    template<size_t N>
+    ResponseWriter &text(const char (&literal)[N]) { return append(literal, N - 1); }
+    ResponseWriter &append(const char *text);
+    ResponseWriter &append(const char *text, size_t count);
+    // Wrapped in double quotes, not escaped: only for names this firmware made up
+    ResponseWriter &quoted(const char *text);
+    ResponseWriter &integer(long value);
+    ResponseWriter &decimal(float value, int decimals = 2);
+    ResponseWriter &boolean(bool value);
+    
+    const char *c_str() const { return buffer; }
+    size_t size() const { return length; }
+    bool overflowed() const { return overflow; }
+};
+
+// Response that carries its body inside the object, so a handler writes the
+// reply straight into the memory the server sends from. The server deletes
+// each response once sent; the objects come from a fixed pool so answering a
+// request does not allocate. Responses are created and deleted on the
+// AsyncTCP task only, which is what makes the pool safe without a lock.
+class FixedResponse : public AsyncAbstractResponse {
+private:
+    char body[WEB_RESPONSE_BYTES];
+    ResponseWriter writer;
+    size_t readLength;
+
+public:
+    FixedResponse(int code, const char *contentType);
+    ~FixedResponse();
+    ResponseWriter &content() { return writer; }
+    
+    // AsyncAbstractResponse interface
+    void _respond(AsyncWebServerRequest *request) override;
+    bool _sourceValid() const override { return true; }
+    size_t _fillBuffer(uint8_t *buf, size_t maxLen) override;
+    
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr);
+};
+
+// Sends a fixed message such as "Missing filename"
+template<size_t N>
+void sendText(AsyncWebServerRequest *request, int code, const char *contentType, const char (&text)[N]) {
+    FixedResponse *response = new FixedResponse(code, contentType);
+    response->content().text(text);
+    request->send(response);
+}
+
+// Implementation
+ResponseWriter::ResponseWriter(char *buffer, size_t capacity)
+    : buffer(buffer), capacity(capacity), length(0), overflow(false) {
+    buffer[0] = '\0';
+}
+
+ResponseWriter &ResponseWriter::append(const char *text) {
+    return append(text, strlen(text));
+}
+
+ResponseWriter &ResponseWriter::append(const char *text, size_t count) {
+    if (count > capacity - 1 - length) {
+        count = capacity - 1 - length;
+        overflow = true;
+    }
+    memcpy(buffer + length, text, count);
+    length += count;
+    buffer[length] = '\0';
+    return *this;
+}
+
+ResponseWriter &ResponseWriter::quoted(const char *text) {
+    return append("\"", 1).append(text).append("\"", 1);
+}
+
+ResponseWriter &ResponseWriter::integer(long value) {
+    char digits[12];
+    int count = 0;
+    unsigned long magnitude = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+    do {
+        digits[sizeof(digits) - 1 - count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        digits[sizeof(digits) - 1 - count++] = '-';
+    }
+    return append(digits + sizeof(digits) - count, count);
+}
+
+ResponseWriter &ResponseWriter::decimal(float value, int decimals) {
+    long scale = 1;
+    for (int i = 0; i < decimals; i++) {
+        scale *= 10;
+    }
+    long scaled = lroundf(value * scale);
+    if (scaled < 0) {
+        append("-", 1);
+        scaled = -scaled;
+    }
+    integer(scaled / scale);
+    if (decimals > 0) {
+        char fraction[10];
+        long rest = scaled % scale;
+        for (int i = decimals - 1; i >= 0; i--) {
+            fraction[i] = '0' + rest % 10;
+            rest /= 10;
+        }
+        append(".", 1).append(fraction, decimals);
+    }
+    return *this;
+}
+
+ResponseWriter &ResponseWriter::boolean(bool value) {
+    return value ? text("true") : text("false");
+}
+
+// One spare slot covers a 503 sent while every connection is in use
+const int FIXED_RESPONSE_POOL_SIZE = WEB_MAX_CONNECTIONS + 1;
+alignas(FixedResponse) static uint8_t fixedResponsePool[FIXED_RESPONSE_POOL_SIZE][sizeof(FixedResponse)];
+static bool fixedResponseInUse[FIXED_RESPONSE_POOL_SIZE];
+// The library keeps the content type in a String, which takes the heap past
+// the core's 10 characters ("application/json"). Each slot keeps one such
+// buffer between responses, sized on its first use for the longest type.
+static String fixedResponseTypes[FIXED_RESPONSE_POOL_SIZE];
+static const char FIXED_RESPONSE_LONGEST_TYPE[] = "application/octet-stream";
+
+static int fixedResponseSlot(const void *ptr) {
+    for (int i = 0; i < FIXED_RESPONSE_POOL_SIZE; i++) {
+        if (ptr == fixedResponsePool[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+FixedResponse::FixedResponse(int code, const char *contentType) : writer(body, sizeof(body)), readLength(0) {
+    _code = code;
+    int slot = fixedResponseSlot(this);
+    if (slot >= 0) {
+        if (fixedResponseTypes[slot].length() == 0) {
+            fixedResponseTypes[slot] = FIXED_RESPONSE_LONGEST_TYPE;
+        }
+        _contentType = std::move(fixedResponseTypes[slot]);
+    }
+    _contentType = contentType;
+}
+
+FixedResponse::~FixedResponse() {
+    int slot = fixedResponseSlot(this);
+    if (slot >= 0) {
+        // A String moves its buffer only when the text would not fit the other one's own space
+        _contentType = FIXED_RESPONSE_LONGEST_TYPE;
+        fixedResponseTypes[slot] = std::move(_contentType);
+    }
+}
+
+void FixedResponse::_respond(AsyncWebServerRequest *request) {
+    if (writer.overflowed()) {
+        Serial.printf("Response truncated at %u bytes\n", writer.size());
+    }
+    _contentLength = writer.size();
+    AsyncAbstractResponse::_respond(request);
+}
+
+size_t FixedResponse::_fillBuffer(uint8_t *buf, size_t maxLen) {
+    size_t count = writer.size() - readLength;
+    if (count > maxLen) {
+        count = maxLen;
+    }
+    memcpy(buf, body + readLength, count);
+    readLength += count;
+    return count;
+}
+
+void *FixedResponse::operator new(size_t size) {
+    for (int i = 0; i < FIXED_RESPONSE_POOL_SIZE; i++) {
+        if (!fixedResponseInUse[i]) {
+            fixedResponseInUse[i] = true;
+            return fixedResponsePool[i];
+        }
+    }
+    // More responses than connections only happens in bursts of refusals
+    return ::operator new(size);
+}
+
+void FixedResponse::operator delete(void *ptr) {
+    int slot = fixedResponseSlot(ptr);
+    if (slot >= 0) {
+        fixedResponseInUse[slot] = false;
+        return;
+    }
+    ::operator delete(ptr);
+}
+
+#endif
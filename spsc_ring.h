@@ -0,0 +1,52 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Lock-free single-producer/single-consumer ring buffer.
+// Exactly one thread (or ISR) may push and exactly one other thread may pop.
+// Neither side ever blocks; push fails when the ring is full.
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+
+private:
+    T slots[N];
+    std::atomic<uint32_t> head; // Next slot to write, owned by the producer
+    std::atomic<uint32_t> tail; // Next slot to read, owned by the consumer
+
+public:
+    SpscRing() : head(0), tail(0) {}
+
+    // Always inlined: the producer can be an ISR in IRAM, which must not call into flash
+    __attribute__((always_inline)) bool push(const T &item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= N) {
+            return false;
+        }
+        slots[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (head.load(std::memory_order_acquire) == t) {
+            return false;
+        }
+        item = slots[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return N; }
+};
+
+#endif
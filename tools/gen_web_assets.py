@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""Gzip the web UI strings from web_interface.h into web_assets.h.
+
+Run from the repository root after editing web_interface.h:
+
+    python3 tools/gen_web_assets.py
+
+Each asset becomes a PROGMEM byte array plus a strong ETag derived from the
+content hash, so the firmware can answer conditional requests with 304.
+"""
+
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE = os.path.join(ROOT, "web_interface.h")
+TARGET = os.path.join(ROOT, "web_assets.h")
+
+ASSETS = ["WEB_HTML", "WEB_CSS"]
+
+
+def extract(source, name):
+    match = re.search(r'const char\s*\*\s*' + name + r'\s*=\s*R"=====\((.*?)\)====="', source, re.S)
+    if not match:
+        sys.exit("%s not found in web_interface.h" % name)
+    return match.group(1).encode("utf-8")
+
+
+def c_array(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("    " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return "\n".join(lines)
+
+
+def main():
+    with open(SOURCE, encoding="utf-8") as f:
+        source = f.read()
+
+    out = [
+        "#ifndef WEB_ASSETS_H",
+        "#define WEB_ASSETS_H",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "// Generated by tools/gen_web_assets.py from web_interface.h, do not edit.",
+        "",
+    ]
+    for name in ASSETS:
+        raw = extract(source, name)
+        # mtime=0 keeps the output byte-identical for unchanged input
+        packed = gzip.compress(raw, compresslevel=9, mtime=0)
+        etag = hashlib.sha256(raw).hexdigest()[:16]
+        out += [
+            "// %d bytes raw, %d bytes gzipped" % (len(raw), len(packed)),
+            "const uint8_t %s_GZ[] PROGMEM = {" % name,
+            c_array(packed),
+            "};",
+            "const size_t %s_GZ_LEN = %d;" % (name, len(packed)),
+            'const char %s_ETAG[] = "\\"%s\\"";' % (name, etag),
+            "",
+        ]
+        print("%s: %d -> %d bytes, ETag %s" % (name, len(raw), len(packed), etag))
+    out += ["#endif", ""]
+
+    with open(TARGET, "w", encoding="utf-8", newline="\n") as f:
+        f.write("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
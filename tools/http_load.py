@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""Load-test the Audiopad web server from a PC on the same network.
+
+    python3 tools/http_load.py 192.168.1.50 --clients 8 --seconds 20 --play 1
+
+Several clients loop over the read-only routes while one more keeps
+re-triggering a button through /test, so audio keeps playing during the run.
+Prints requests/sec, latency percentiles and how many requests got 503
+because the server's WEB_MAX_CONNECTIONS limit was reached. Uses only the
+Python standard library.
+"""
+
+import argparse
+import http.client
+import threading
+import time
+
+ROUTES = ["/volume", "/files", "/battery", "/", "/style.css"]
+
+
+def request(host, method, path, body=None, headers=None):
+    conn = http.client.HTTPConnection(host, 80, timeout=10)
+    started = time.perf_counter()
+    try:
+        conn.request(method, path, body=body, headers=headers or {})
+        response = conn.getresponse()
+        response.read()
+        return response.status, response.getheader("ETag"), time.perf_counter() - started
+    except OSError:
+        return None, None, time.perf_counter() - started
+    finally:
+        conn.close()
+
+
+def client(host, deadline, results, lock):
+    etags = {}
+    i = 0
+    while time.perf_counter() < deadline:
+        path = ROUTES[i % len(ROUTES)]
+        i += 1
+        headers = {"If-None-Match": etags[path]} if path in etags else None
+        status, etag, elapsed = request(host, "GET", path, headers=headers)
+        if etag:
+            etags[path] = etag
+        with lock:
+            results.append((status, elapsed))
+
+
+def player(host, deadline, button, interval):
+    form = {"Content-Type": "application/x-www-form-urlencoded"}
+    while time.perf_counter() < deadline:
+        request(host, "POST", "/test", body="button=%d" % button, headers=form)
+        time.sleep(interval)
+
+
+def percentile(sorted_values, fraction):
+    if not sorted_values:
+        return 0.0
+    index = min(len(sorted_values) - 1, int(fraction * len(sorted_values)))
+    return sorted_values[index]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("host", help="IP address or hostname of the Audiopad")
+    parser.add_argument("--clients", type=int, default=4, help="concurrent connections (default 4)")
+    parser.add_argument("--seconds", type=float, default=10.0, help="test duration (default 10)")
+    parser.add_argument("--play", type=int, default=0, help="button to keep playing during the run, 0 for none")
+    parser.add_argument("--play-interval", type=float, default=2.0, help="seconds between re-triggers (default 2)")
+    args = parser.parse_args()
+
+    results = []
+    lock = threading.Lock()
+    started = time.perf_counter()
+    deadline = started + args.seconds
+
+    threads = [threading.Thread(target=client, args=(args.host, deadline, results, lock)) for _ in range(args.clients)]
+    if args.play:
+        threads.append(threading.Thread(target=player, args=(args.host, deadline, args.play, args.play_interval)))
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    duration = time.perf_counter() - started
+
+    ok = sorted(elapsed for status, elapsed in results if status in (200, 304))
+    busy = sum(1 for status, _ in results if status == 503)
+    failed = sum(1 for status, _ in results if status not in (200, 304, 503))
+
+    print("requests:   %d in %.1f s (%.1f req/s)" % (len(results), duration, len(results) / duration))
+    print("ok:         %d, busy (503): %d, failed: %d" % (len(ok), busy, failed))
+    print("latency ms: p50 %.1f, p90 %.1f, p99 %.1f, max %.1f" % (
+        percentile(ok, 0.50) * 1000, percentile(ok, 0.90) * 1000,
+        percentile(ok, 0.99) * 1000, (ok[-1] if ok else 0.0) * 1000))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""Send UDP trigger packets to the Audiopad, or benchmark them against HTTP.
+
+    python3 tools/udp_trigger.py 192.168.1.50 play 3
+    python3 tools/udp_trigger.py 192.168.1.50 play 1 play 2 --gain 0.8   # one batched packet
+    python3 tools/udp_trigger.py 192.168.1.50 stop 3
+    python3 tools/udp_trigger.py 192.168.1.50 stopall
+    python3 tools/udp_trigger.py 192.168.1.50 volume 0.4
+    python3 tools/udp_trigger.py 192.168.1.50 bench 1 --count 200
+
+Pass --key when UDP_TRIGGER_KEY is defined in secrets.h. The bench mode
+compares the round trip of POST /test with a UDP play that asks for an ack,
+and prints p50/p99 for both. See udp_trigger.h for the packet layout.
+"""
+
+import argparse
+import hashlib
+import hmac
+import http.client
+import socket
+import struct
+import time
+
+PORT = 5005
+OPS = {"play": 1, "stop": 2, "stopall": 3, "volume": 4}
+FLAG_ACK = 0x01
+HEADER = struct.Struct("<2sBBIB")
+COMMAND = struct.Struct("<BBH")
+
+
+class Sender:
+    def __init__(self, host, key):
+        self.host = host
+        self.key = key.encode() if key else None
+        # Seeding from the clock keeps sequences increasing across runs
+        self.sequence = int(time.time() * 1000) & 0xFFFFFFFF
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.settimeout(1.0)
+
+    def packet(self, commands, flags=0):
+        self.sequence = (self.sequence + 1) & 0xFFFFFFFF
+        data = HEADER.pack(b"AP", 1, flags, self.sequence, len(commands))
+        data += b"".join(COMMAND.pack(op, button, value) for op, button, value in commands)
+        if self.key:
+            data += hmac.new(self.key, data, hashlib.sha256).digest()[:16]
+        return data
+
+    def send(self, commands, ack=False):
+        self.sock.sendto(self.packet(commands, FLAG_ACK if ack else 0), (self.host, PORT))
+        if not ack:
+            return True
+        try:
+            reply, _ = self.sock.recvfrom(64)
+        except socket.timeout:
+            return False
+        return len(reply) == HEADER.size and HEADER.unpack(reply)[3] == self.sequence
+
+
+def parse_commands(words, gain):
+    commands = []
+    i = 0
+    while i < len(words):
+        op = words[i]
+        if op not in OPS:
+            raise SystemExit("unknown command: %s" % op)
+        if op == "stopall":
+            commands.append((OPS[op], 0, 0))
+            i += 1
+        elif op == "volume":
+            commands.append((OPS[op], 0, int(float(words[i + 1]) * 1000)))
+            i += 2
+        else:
+            value = int(gain * 1000) if op == "play" else 0
+            commands.append((OPS[op], int(words[i + 1]), value))
+            i += 2
+    return commands
+
+
+def percentiles(samples):
+    samples = sorted(samples)
+    if not samples:
+        return "no replies"
+    pick = lambda f: samples[min(len(samples) - 1, int(f * len(samples)))] * 1000
+    return "p50 %.1f ms, p99 %.1f ms, max %.1f ms (%d samples)" % (pick(0.5), pick(0.99), samples[-1] * 1000, len(samples))
+
+
+def bench(sender, button, count):
+    http_times = []
+    for _ in range(count):
+        conn = http.client.HTTPConnection(sender.host, 80, timeout=5)
+        started = time.perf_counter()
+        try:
+            conn.request("POST", "/test", body="button=%d" % button,
+                         headers={"Content-Type": "application/x-www-form-urlencoded"})
+            conn.getresponse().read()
+            http_times.append(time.perf_counter() - started)
+        except OSError:
+            pass
+        finally:
+            conn.close()
+        time.sleep(0.05)
+
+    udp_times = []
+    for _ in range(count):
+        started = time.perf_counter()
+        if sender.send([(OPS["play"], button, 1000)], ack=True):
+            udp_times.append(time.perf_counter() - started)
+        time.sleep(0.05)
+
+    print("HTTP /test: " + percentiles(http_times))
+    print("UDP play:   " + percentiles(udp_times))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("host")
+    parser.add_argument("commands", nargs="+", help="play N | stop N | stopall | volume V | bench N")
+    parser.add_argument("--key", help="HMAC key, same as UDP_TRIGGER_KEY")
+    parser.add_argument("--gain", type=float, default=1.0, help="gain for play commands (default 1.0)")
+    parser.add_argument("--count", type=int, default=100, help="round trips per protocol in bench mode")
+    args = parser.parse_args()
+
+    sender = Sender(args.host, args.key)
+    if args.commands[0] == "bench":
+        bench(sender, int(args.commands[1]), args.count)
+        return
+    commands = parse_commands(args.commands, args.gain)
+    if not sender.send(commands, ack=True):
+        raise SystemExit("no ack from %s (check the key and that UDP_TRIGGER_ENABLED is set)" % args.host)
+
+
+if __name__ == "__main__":
+    main()
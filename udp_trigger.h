@@ -0,0 +1,264 @@
+#ifndef UDP_TRIGGER_H
+#define UDP_TRIGGER_H
+
+#include <lwip/sockets.h>
+#include <mbedtls/md.h>
+#include "secrets.h"
+#include "config.h"
+
+// Binary remote-control protocol on UDP_TRIGGER_PORT. All fields are little-endian:
+//   header    "AP", version 1, flags, uint32 sequence, uint8 command count
+//   commands  count x {uint8 op, uint8 button, uint16 value}
+//   tag       16 bytes of HMAC-SHA256 over everything before it, only when
+//             UDP_TRIGGER_KEY is defined in secrets.h
+// value is a gain or volume in thousandths. Sequence numbers must increase
+// from packet to packet of each sender, an address and port (clients seed
+// them from the clock); anything else is dropped as a duplicate or replay.
+// The last UDP_MAX_SOURCES senders are remembered; one that has not been
+// heard from the longest makes room for a new one and starts afresh when it
+// returns. With UDP_FLAG_ACK set, the header is sent back once the commands
+// have been queued for the audio task.
+
+enum UdpOp : uint8_t {
+    UDP_OP_PLAY = 1,     // button, value = gain
+    UDP_OP_STOP = 2,     // button
+    UDP_OP_STOP_ALL = 3,
+    UDP_OP_VOLUME = 4    // value = volume
+};
+
+const uint8_t UDP_FLAG_ACK = 0x01;
+
+struct __attribute__((packed)) UdpPacketHeader {
+    char magic[2];     // "AP"
+    uint8_t version;
+    uint8_t flags;
+    uint32_t sequence;
+    uint8_t count;
+};
+
+struct __attribute__((packed)) UdpCommand {
+    uint8_t op;
+    uint8_t button;
+    uint16_t value;
+};
+
+// Last sequence number accepted from one sender
+struct UdpSource {
+    uint32_t address;  // Network byte order, as in sockaddr_in
+    uint16_t port;
+    uint32_t lastSequence;
+    uint32_t lastUsed; // Packet count when last accepted, 0 for a free slot
+};
+
+const size_t UDP_HMAC_BYTES = 16;
+const size_t UDP_MAX_PACKET = sizeof(UdpPacketHeader) + UDP_MAX_BATCH * sizeof(UdpCommand) + UDP_HMAC_BYTES;
+
+// Receives trigger packets on its own task, which sleeps in recvfrom() and
+// hands each command to the callback as soon as the packet arrives
+class UdpTrigger {
+private:
+    int sock;
+    TaskHandle_t taskHandle;
+    UdpSource sources[UDP_MAX_SOURCES]; // Only the UDP task touches these
+    uint32_t useCounter;
+    volatile uint32_t accepted;
+    volatile uint32_t rejected;
+    
+    // Runs on the UDP task
+    void (*onCommand)(const UdpCommand &command) = nullptr;
+    
+    static void taskEntry(void *arg);
+    UdpSource *findSource(const sockaddr_in &from);
+
+public:
+    UdpTrigger();
+    ~UdpTrigger();
+    bool begin();
+    void setCommandCallback(void (*callback)(const UdpCommand &));
+    uint32_t getAccepted() const { return accepted; }
+    uint32_t getRejected() const { return rejected; }
+    // One datagram as received. Runs on the UDP task; public so packets can also be fed in without a socket
+    void handlePacket(const uint8_t *data, size_t length, const sockaddr_in &from);
+    
+    // HMAC helpers, shared with clock_sync.h. The tag sits right after the
+    // length bytes it covers; both are no-ops without UDP_TRIGGER_KEY.
+    static size_t tagBytes();
+    static void appendTag(uint8_t *data, size_t length);
+    static bool verifyTag(const uint8_t *data, size_t length);
+};
+
+// Implementation
+UdpTrigger::UdpTrigger() {
+    sock = -1;
+    taskHandle = nullptr;
+    memset(sources, 0, sizeof(sources));
+    useCounter = 0;
+    accepted = 0;
+    rejected = 0;
+}
+
+UdpTrigger::~UdpTrigger() {
+    if (taskHandle) {
+        vTaskDelete(taskHandle);
+        taskHandle = nullptr;
+    }
+    if (sock >= 0) {
+        closesocket(sock);
+        sock = -1;
+    }
+}
+
+bool UdpTrigger::begin() {
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        Serial.println("UDP trigger: failed to create socket");
+        return false;
+    }
+    
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(UDP_TRIGGER_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (sockaddr *)&addr, sizeof(addr)) < 0) {
+        Serial.printf("UDP trigger: failed to bind port %u\n", UDP_TRIGGER_PORT);
+        closesocket(sock);
+        sock = -1;
+        return false;
+    }
+    
+    if (xTaskCreatePinnedToCore(taskEntry, "udptrig", UDP_TASK_STACK_SIZE, this,
+                                UDP_TASK_PRIORITY, &taskHandle, UDP_TASK_CORE) != pdPASS) {
+        Serial.println("UDP trigger: failed to start task");
+        taskHandle = nullptr;
+        closesocket(sock);
+        sock = -1;
+        return false;
+    }
+
+#ifdef UDP_TRIGGER_KEY
+    Serial.printf("UDP trigger listening on port %u (HMAC required)\n", UDP_TRIGGER_PORT);
+#else
+    Serial.printf("UDP trigger listening on port %u\n", UDP_TRIGGER_PORT);
+#endif
+    return true;
+}
+
+void UdpTrigger::setCommandCallback(void (*callback)(const UdpCommand &)) {
+    onCommand = callback;
+}
+
+void UdpTrigger::taskEntry(void *arg) {
+    UdpTrigger *self = static_cast<UdpTrigger *>(arg);
+    uint8_t packet[UDP_MAX_PACKET];
+    for (;;) {
+        sockaddr_in from;
+        socklen_t fromLength = sizeof(from);
+        int length = recvfrom(self->sock, packet, sizeof(packet), 0, (sockaddr *)&from, &fromLength);
+        if (length > 0) {
+            self->handlePacket(packet, length, from);
+        }
+    }
+}
+
+size_t UdpTrigger::tagBytes() {
+#ifdef UDP_TRIGGER_KEY
+    return UDP_HMAC_BYTES;
+#else
+    return 0;
+#endif
+}
+
+#ifdef UDP_TRIGGER_KEY
+static bool udpTriggerHmac(const uint8_t *data, size_t length, uint8_t digest[32]) {
+    static const char key[] = UDP_TRIGGER_KEY;
+    const mbedtls_md_info_t *sha256 = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+    return mbedtls_md_hmac(sha256, (const uint8_t *)key, sizeof(key) - 1, data, length, digest) == 0;
+}
+#endif
+
+void UdpTrigger::appendTag(uint8_t *data, size_t length) {
+#ifdef UDP_TRIGGER_KEY
+    uint8_t digest[32];
+    if (!udpTriggerHmac(data, length, digest)) {
+        memset(digest, 0, sizeof(digest));
+    }
+    memcpy(data + length, digest, UDP_HMAC_BYTES);
+#endif
+}
+
+bool UdpTrigger::verifyTag(const uint8_t *data, size_t length) {
+#ifdef UDP_TRIGGER_KEY
+    uint8_t digest[32];
+    if (!udpTriggerHmac(data, length, digest)) {
+        return false;
+    }
+    // Constant-time compare so the tag cannot be guessed byte by byte
+    uint8_t diff = 0;
+    for (size_t i = 0; i < UDP_HMAC_BYTES; i++) {
+        diff |= digest[i] ^ data[length + i];
+    }
+    return diff == 0;
+#else
+    return true;
+#endif
+}
+
+// The sender's slot, or the least recently used one cleared for it
+UdpSource *UdpTrigger::findSource(const sockaddr_in &from) {
+    UdpSource *oldest = &sources[0];
+    for (size_t i = 0; i < UDP_MAX_SOURCES; i++) {
+        UdpSource &source = sources[i];
+        if (source.lastUsed != 0 && source.address == from.sin_addr.s_addr && source.port == from.sin_port) {
+            return &source;
+        }
+        if (source.lastUsed < oldest->lastUsed) {
+            oldest = &source;
+        }
+    }
+    oldest->lastUsed = 0;
+    return oldest;
+}
+
+void UdpTrigger::handlePacket(const uint8_t *data, size_t length, const sockaddr_in &from) {
+    UdpPacketHeader header;
+    if (length < sizeof(header)) {
+        rejected++;
+        return;
+    }
+    memcpy(&header, data, sizeof(header));
+    
+    size_t body = sizeof(header) + header.count * sizeof(UdpCommand);
+    if (header.magic[0] != 'A' || header.magic[1] != 'P' || header.version != 1 ||
+        header.count > UDP_MAX_BATCH || length != body + tagBytes() || !verifyTag(data, body)) {
+        rejected++;
+        return;
+    }
+    
+    // Drop duplicates, reordered and replayed packets
+    UdpSource *source = findSource(from);
+    if (source->lastUsed != 0 && (int32_t)(header.sequence - source->lastSequence) <= 0) {
+        rejected++;
+        return;
+    }
+    source->address = from.sin_addr.s_addr;
+    source->port = from.sin_port;
+    source->lastSequence = header.sequence;
+    source->lastUsed = ++useCounter;
+    accepted++;
+    
+    for (uint8_t i = 0; i < header.count; i++) {
+        UdpCommand command;
+        memcpy(&command, data + sizeof(header) + i * sizeof(UdpCommand), sizeof(command));
+        if (onCommand != nullptr) {
+            onCommand(command);
+        }
+    }
+    
+    if (header.flags & UDP_FLAG_ACK) {
+        header.count = 0;
+        sendto(sock, &header, sizeof(header), 0, (const sockaddr *)&from, sizeof(from));
+    }
+}
+
+#endif
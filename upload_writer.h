@@ -0,0 +1,432 @@
+#ifndef UPLOAD_WRITER_H
+#define UPLOAD_WRITER_H
+
+#include <SPIFFS.h>
+#include <FS.h>
+#include "clip_transcoder.h"
+#include "config.h"
+#include "pad_topology.h"
+
+// Streams an HTTP upload to flash through a pool of UPLOAD_BUFFER_COUNT
+// buffers. The web handler fills one buffer while a background task writes the
+// others. The handler never waits: when the writer has no buffer to spare, the
+// upload is dropped as UPLOAD_BUSY and the client is told to retry. Data goes
+// to a temp file that replaces the target only once the whole upload has
+// arrived. Every SPIFFS call, the swap and clip deletes included, runs on that
+// task, so the handler never waits for the audio task to let go of a clip.
+// When TRANSCODE_UPLOADS_ENABLED is set, a second, lower priority task converts
+// each new clip to ADPCM, so a transcode never holds up the next upload; the
+// writer task then closes the clip as it does for a swap. Each clip whose
+// files changed is reported once through takeDone(), always closed.
+class UploadWriter {
+public:
+    enum Result { UPLOAD_OK, UPLOAD_TOO_LARGE, UPLOAD_WRITE_FAILED, UPLOAD_ABORTED, UPLOAD_BUSY };
+
+private:
+    enum JobType : uint8_t { JOB_START, JOB_BUFFER, JOB_FINISH, JOB_ABORT, JOB_DELETE, JOB_TRANSCODED };
+    struct Job {
+        JobType type;
+        uint8_t index;  // Buffer, for JOB_BUFFER
+        size_t length;
+        int tag;
+        ClipPath path; // Target file
+    };
+    
+    struct Ingest {
+        int tag;
+        ClipPath path;
+    };
+    static const uint8_t NO_BUFFER = 0xFF;
+    
+    uint8_t buffers[UPLOAD_BUFFER_COUNT][UPLOAD_BUFFER_SIZE];
+    uint8_t active;           // Buffer the handler is filling, or NO_BUFFER
+    size_t activeFill;
+    QueueHandle_t jobQueue;   // Work for the writer task, in order
+    QueueHandle_t freeQueue;  // Buffers the handler may fill
+    QueueHandle_t doneQueue;  // Tags of clips whose files changed
+    QueueHandle_t ingestQueue; // New clips for the transcoder task
+    SemaphoreHandle_t clipLock; // Held while clip files are swapped, removed or transcoded
+    TaskHandle_t taskHandle;
+    TaskHandle_t ingestHandle;
+    ClipPath target;          // Of the upload being received
+    int targetTag;
+    bool receiving;
+    size_t received;
+    unsigned long startedAt;
+    unsigned long elapsedMs;
+    Result lastResult;
+    bool (*onClose)(int tag) = nullptr;
+    
+    // Writer task only
+    File file;
+    ClipPath openTemp;        // Temp file behind file
+    bool writeFailed;
+    
+    static void taskEntry(void *arg);
+    static void ingestEntry(void *arg);
+    void run(const Job &job);
+    void swapIn(const Job &job);
+    void erase(const Job &job);
+    void dropOpenTemp();
+    bool post(JobType type, uint8_t index = 0, size_t length = 0);
+    bool takeBuffer();
+    void releaseBuffer();
+    bool submitActive();
+    void discard(Result result);
+    static ClipPath withSuffix(const ClipPath &path, const char *suffix);
+
+public:
+    UploadWriter();
+    bool init();
+    bool start(const ClipPath &path, int tag = 0);
+    bool write(const uint8_t *data, size_t length);
+    // Hands the upload to the writer task, which swaps it in. start(), write()
+    // and finish() never block; they fail with UPLOAD_BUSY when the writer is
+    // behind.
+    bool finish();
+    void abort();
+    // Removes a clip and its .adp on the writer task; false if the queue is full
+    bool queueDelete(const ClipPath &path, int tag);
+    // Tag of a clip whose files the writer task changed, one per call
+    bool takeDone(int &tag);
+    // Called on the writer task with the tag before the target and its .adp
+    // are replaced or removed; false keeps them as they are
+    void setCloseCallback(bool (*callback)(int tag)) { onClose = callback; }
+    bool isReceiving() const { return receiving; }
+    Result getLastResult() const { return lastResult; }
+    size_t getBytesReceived() const { return received; }
+    float getThroughputKBps() const;
+};
+
+// Implementation
+UploadWriter::UploadWriter() {
+    active = NO_BUFFER;
+    activeFill = 0;
+    jobQueue = nullptr;
+    freeQueue = nullptr;
+    doneQueue = nullptr;
+    ingestQueue = nullptr;
+    clipLock = nullptr;
+    taskHandle = nullptr;
+    ingestHandle = nullptr;
+    targetTag = 0;
+    receiving = false;
+    received = 0;
+    startedAt = 0;
+    elapsedMs = 0;
+    lastResult = UPLOAD_OK;
+    writeFailed = false;
+}
+
+bool UploadWriter::init() {
+    // Every buffer, the start and finish of two uploads and a few deletes
+    jobQueue = xQueueCreate(UPLOAD_BUFFER_COUNT + 8, sizeof(Job));
+    freeQueue = xQueueCreate(UPLOAD_BUFFER_COUNT, sizeof(uint8_t));
+    doneQueue = xQueueCreate(8, sizeof(int));
+    ingestQueue = xQueueCreate(4, sizeof(Ingest));
+    clipLock = xSemaphoreCreateMutex();
+    if (!jobQueue || !freeQueue || !doneQueue || !ingestQueue || !clipLock) {
+        Serial.println("Upload writer: failed to create queues");
+        return false;
+    }
+    
+    for (uint8_t i = 0; i < UPLOAD_BUFFER_COUNT; i++) {
+        xQueueSend(freeQueue, &i, 0);
+    }
+    
+    if (xTaskCreatePinnedToCore(taskEntry, "flashwr", UPLOAD_TASK_STACK_SIZE, this,
+                                UPLOAD_TASK_PRIORITY, &taskHandle, UPLOAD_TASK_CORE) != pdPASS) {
+        Serial.println("Upload writer: failed to start task");
+        taskHandle = nullptr;
+        return false;
+    }
+    if (TRANSCODE_UPLOADS_ENABLED &&
+        xTaskCreatePinnedToCore(ingestEntry, "ingest", INGEST_TASK_STACK_SIZE, this,
+                                INGEST_TASK_PRIORITY, &ingestHandle, UPLOAD_TASK_CORE) != pdPASS) {
+        // Uploads still work, they just stay MP3
+        Serial.println("Upload writer: failed to start transcoder task");
+        ingestHandle = nullptr;
+    }
+    return true;
+}
+
+void UploadWriter::taskEntry(void *arg) {
+    UploadWriter *self = static_cast<UploadWriter *>(arg);
+    Job job;
+    for (;;) {
+        if (xQueueReceive(self->jobQueue, &job, portMAX_DELAY) == pdTRUE) {
+            self->run(job);
+        }
+    }
+}
+
+void UploadWriter::ingestEntry(void *arg) {
+    UploadWriter *self = static_cast<UploadWriter *>(arg);
+    Ingest ingest;
+    for (;;) {
+        if (xQueueReceive(self->ingestQueue, &ingest, portMAX_DELAY) == pdTRUE) {
+            xSemaphoreTake(self->clipLock, portMAX_DELAY);
+            ClipTranscoder::transcode(String(ingest.path.c_str()));
+            xSemaphoreGive(self->clipLock);
+            // The writer task closes the clip before anyone picks up the new .adp
+            Job done = {JOB_TRANSCODED, 0, 0, ingest.tag, ingest.path};
+            xQueueSend(self->jobQueue, &done, portMAX_DELAY);
+        }
+    }
+}
+
+ClipPath UploadWriter::withSuffix(const ClipPath &path, const char *suffix) {
+    ClipPath result = path;
+    size_t length = strlen(result.text);
+    strncpy(result.text + length, suffix, sizeof(result.text) - length - 1);
+    result.text[sizeof(result.text) - 1] = '\0';
+    return result;
+}
+
+void UploadWriter::run(const Job &job) {
+    ClipPath tempPath = withSuffix(job.path, ".tmp");
+    switch (job.type) {
+        case JOB_START:
+            // An abort the handler could not queue leaves the last upload open
+            dropOpenTemp();
+            writeFailed = false;
+            openTemp = tempPath;
+            file = SPIFFS.open(tempPath.c_str(), "w");
+            if (!file) {
+                Serial.printf("Failed to create file: %s\n", tempPath.c_str());
+                writeFailed = true;
+            }
+            break;
+        case JOB_BUFFER:
+            if (!writeFailed && file.write(buffers[job.index], job.length) != job.length) {
+                writeFailed = true;
+            }
+            xQueueSend(freeQueue, &job.index, 0); // Sized for every buffer, never full
+            break;
+        case JOB_FINISH:
+            file.close();
+            openTemp = ClipPath();
+            if (writeFailed) {
+                Serial.printf("File write failed: %s\n", job.path.c_str());
+                SPIFFS.remove(tempPath.c_str());
+            } else {
+                swapIn(job);
+            }
+            break;
+        case JOB_ABORT:
+            dropOpenTemp();
+            break;
+        case JOB_DELETE:
+            erase(job);
+            break;
+        case JOB_TRANSCODED:
+            // Picking up the .adp rewrites the clip's partition slot, which nothing may read meanwhile
+            if (onClose && !onClose(job.tag)) {
+                Serial.printf("%s is busy, keeps playing its MP3\n", job.path.c_str());
+                break;
+            }
+            xQueueSend(doneQueue, &job.tag, 0);
+            break;
+    }
+}
+
+void UploadWriter::dropOpenTemp() {
+    if (file) {
+        file.close();
+        SPIFFS.remove(openTemp.c_str());
+    }
+    openTemp = ClipPath();
+}
+
+void UploadWriter::swapIn(const Job &job) {
+    ClipPath tempPath = withSuffix(job.path, ".tmp");
+    // Nothing may read the previous clip while it is swapped out
+    if (onClose && !onClose(job.tag)) {
+        Serial.printf("%s is busy, upload dropped\n", job.path.c_str());
+        SPIFFS.remove(tempPath.c_str());
+        return;
+    }
+    xSemaphoreTake(clipLock, portMAX_DELAY); // Waits out a transcode of the previous clip
+    
+    // A transcoded copy of the previous clip must not outlive it
+    String adpcmPath = ClipTranscoder::adpcmPathFor(String(job.path.c_str()));
+    if (SPIFFS.exists(adpcmPath)) {
+        SPIFFS.remove(adpcmPath);
+    }
+    
+    // Swap the finished file in; the previous clip stays intact until this point
+    if (SPIFFS.exists(job.path.c_str())) {
+        SPIFFS.remove(job.path.c_str());
+    }
+    bool renamed = SPIFFS.rename(tempPath.c_str(), job.path.c_str());
+    if (!renamed) {
+        Serial.printf("Failed to rename %s\n", tempPath.c_str());
+        SPIFFS.remove(tempPath.c_str());
+    }
+    xSemaphoreGive(clipLock);
+    // Closed either way, so it has to be picked up again
+    xQueueSend(doneQueue, &job.tag, 0);
+    if (renamed && ingestHandle) {
+        Ingest ingest = {job.tag, job.path};
+        if (xQueueSend(ingestQueue, &ingest, 0) != pdTRUE) {
+            Serial.printf("Transcoder busy, %s stays MP3 only\n", job.path.c_str());
+        }
+    }
+}
+
+void UploadWriter::erase(const Job &job) {
+    if (onClose && !onClose(job.tag)) {
+        Serial.printf("%s is busy, not deleted\n", job.path.c_str());
+        return;
+    }
+    xSemaphoreTake(clipLock, portMAX_DELAY);
+    SPIFFS.remove(job.path.c_str());
+    String adpcmPath = ClipTranscoder::adpcmPathFor(String(job.path.c_str()));
+    if (SPIFFS.exists(adpcmPath)) {
+        SPIFFS.remove(adpcmPath);
+    }
+    xSemaphoreGive(clipLock);
+    Serial.printf("Deleted file: %s\n", job.path.c_str());
+    xQueueSend(doneQueue, &job.tag, 0);
+}
+
+bool UploadWriter::post(JobType type, uint8_t index, size_t length) {
+    Job job = {type, index, length, targetTag, target};
+    return xQueueSend(jobQueue, &job, 0) == pdTRUE;
+}
+
+bool UploadWriter::takeBuffer() {
+    activeFill = 0;
+    if (xQueueReceive(freeQueue, &active, 0) != pdTRUE) {
+        active = NO_BUFFER;
+        return false;
+    }
+    return true;
+}
+
+void UploadWriter::releaseBuffer() {
+    if (active != NO_BUFFER) {
+        xQueueSend(freeQueue, &active, 0);
+        active = NO_BUFFER;
+    }
+    activeFill = 0;
+}
+
+bool UploadWriter::start(const ClipPath &path, int tag) {
+    if (receiving) {
+        abort();
+    }
+    
+    target = path;
+    targetTag = tag;
+    received = 0;
+    elapsedMs = 0;
+    startedAt = millis();
+    if (!takeBuffer()) {
+        lastResult = UPLOAD_BUSY;
+        return false;
+    }
+    if (!post(JOB_START)) {
+        releaseBuffer();
+        lastResult = UPLOAD_BUSY;
+        return false;
+    }
+    receiving = true;
+    Serial.printf("Upload Start: %s\n", target.c_str());
+    return true;
+}
+
+// Hands the filled buffer over and takes a free one; false if the writer has
+// neither room in its queue nor a buffer to spare
+bool UploadWriter::submitActive() {
+    if (!post(JOB_BUFFER, active, activeFill)) {
+        return false;
+    }
+    return takeBuffer();
+}
+
+bool UploadWriter::write(const uint8_t *data, size_t length) {
+    if (!receiving) {
+        return false;
+    }
+    if (received + length > MAX_FILE_SIZE) {
+        Serial.printf("Upload rejected: %s exceeds %u bytes\n", target.c_str(), MAX_FILE_SIZE);
+        discard(UPLOAD_TOO_LARGE);
+        return false;
+    }
+    
+    received += length;
+    while (length > 0) {
+        size_t room = UPLOAD_BUFFER_SIZE - activeFill;
+        size_t n = length < room ? length : room;
+        memcpy(&buffers[active][activeFill], data, n);
+        activeFill += n;
+        data += n;
+        length -= n;
+        
+        if (activeFill == UPLOAD_BUFFER_SIZE && !submitActive()) {
+            Serial.printf("Upload dropped: writer behind on %s\n", target.c_str());
+            discard(UPLOAD_BUSY);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool UploadWriter::finish() {
+    if (!receiving) {
+        return false;
+    }
+    if (activeFill > 0) {
+        if (!post(JOB_BUFFER, active, activeFill)) {
+            discard(UPLOAD_BUSY);
+            return false;
+        }
+        active = NO_BUFFER; // The writer returns it
+    }
+    if (!post(JOB_FINISH)) {
+        discard(UPLOAD_BUSY);
+        return false;
+    }
+    releaseBuffer();
+    receiving = false;
+    elapsedMs = millis() - startedAt;
+    lastResult = UPLOAD_OK;
+    Serial.printf("Upload End: %s, %u bytes, %.1f KB/s\n", target.c_str(), received, getThroughputKBps());
+    return true;
+}
+
+bool UploadWriter::queueDelete(const ClipPath &path, int tag) {
+    Job job = {JOB_DELETE, 0, 0, tag, path};
+    return xQueueSend(jobQueue, &job, 0) == pdTRUE;
+}
+
+bool UploadWriter::takeDone(int &tag) {
+    return doneQueue && xQueueReceive(doneQueue, &tag, 0) == pdTRUE;
+}
+
+void UploadWriter::abort() {
+    if (receiving) {
+        Serial.printf("Upload aborted: %s\n", target.c_str());
+        discard(UPLOAD_ABORTED);
+    }
+}
+
+// The buffer being filled goes back unwritten; the writer drops the temp file,
+// or the next upload's start does if the abort finds the queue full
+void UploadWriter::discard(Result result) {
+    post(JOB_ABORT);
+    releaseBuffer();
+    receiving = false;
+    lastResult = result;
+}
+
+float UploadWriter::getThroughputKBps() const {
+    unsigned long ms = receiving ? millis() - startedAt : elapsedMs;
+    if (ms == 0) {
+        return 0.0f;
+    }
+    return (received / 1024.0f) / (ms / 1000.0f);
+}
+
+#endif
@@ -0,0 +1,271 @@
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+
+// Generated by tools/gen_web_assets.py from web_interface.h, do not edit.
+
+// 11077 bytes raw, 3054 bytes gzipped
+const uint8_t WEB_HTML_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xcd, 0x1a, 0x6b, 0x73, 0xdb, 0x36,
+    0xf2, 0x7b, 0x7e, 0xc5, 0x56, 0x4d, 0x4b, 0xaa, 0x96, 0x28, 0xdb, 0x69, 0xef, 0x83, 0x2d, 0xa9,
+    0x93, 0xc4, 0xc9, 0x34, 0xd7, 0x3c, 0x3c, 0xb5, 0xaf, 0x33, 0x37, 0x99, 0x4e, 0x05, 0x93, 0xb0,
+    0x85, 0x8a, 0x24, 0x78, 0x04, 0x24, 0x45, 0x4d, 0xf5, 0xdf, 0x6f, 0x17, 0x00, 0x69, 0x92, 0x22,
+    0xe5, 0x47, 0x7a, 0x33, 0xe7, 0x0f, 0x16, 0x09, 0x2c, 0x76, 0x17, 0xfb, 0xde, 0x95, 0xe0, 0xc9,
+    0xf8, 0xab, 0xb3, 0x0f, 0x2f, 0x2f, 0xff, 0x7d, 0xfe, 0x0a, 0xe6, 0x3a, 0x89, 0xa7, 0x4f, 0xc6,
+    0xc5, 0x07, 0x67, 0xd1, 0xf4, 0x09, 0xe0, 0xdf, 0x58, 0x0b, 0x1d, 0xf3, 0xe9, 0xab, 0x8b, 0xf3,
+    0x67, 0xc7, 0xf0, 0x7c, 0x19, 0x09, 0x09, 0x2f, 0x65, 0xaa, 0x73, 0x19, 0xc7, 0x3c, 0x1f, 0x8f,
+    0xec, 0xae, 0x85, 0x8c, 0x45, 0xba, 0x80, 0x9c, 0xc7, 0x93, 0x9e, 0xd2, 0x9b, 0x98, 0xab, 0x39,
+    0xe7, 0xba, 0x07, 0xf3, 0x9c, 0x5f, 0x4f, 0x7a, 0x23, 0xb3, 0x14, 0x84, 0x4a, 0xf5, 0x1c, 0x74,
+    0xc2, 0x35, 0x83, 0x94, 0x25, 0x7c, 0xd2, 0x5b, 0x09, 0xbe, 0xce, 0x64, 0x8e, 0xc0, 0x21, 0xa2,
+    0xe6, 0xa9, 0x9e, 0xf4, 0xd6, 0x22, 0xd2, 0xf3, 0x49, 0xc4, 0x57, 0x22, 0xe4, 0x43, 0xf3, 0x32,
+    0x00, 0x91, 0x0a, 0x2d, 0x58, 0x3c, 0x54, 0x21, 0x8b, 0xf9, 0xe4, 0x08, 0x11, 0x8d, 0x47, 0x96,
+    0xd1, 0xf1, 0x95, 0x8c, 0x36, 0x0e, 0x6f, 0x24, 0x56, 0x10, 0xc6, 0x4c, 0xa9, 0x49, 0x8f, 0xb0,
+    0x31, 0x91, 0xf2, 0xdc, 0xd1, 0x34, 0xfb, 0xf3, 0xa3, 0xce, 0xcb, 0xe0, 0xd6, 0x93, 0x5b, 0xc0,
+    0x0a, 0x22, 0x2d, 0xb3, 0x61, 0x2e, 0xd7, 0x15, 0x34, 0x4d, 0x08, 0xc5, 0x43, 0x2d, 0x64, 0xda,
+    0x80, 0xb0, 0x04, 0x8f, 0xa7, 0x2f, 0x98, 0xd6, 0x3c, 0xdf, 0xc0, 0x85, 0x66, 0x7a, 0xa9, 0x90,
+    0xd0, 0x71, 0x0b, 0x1c, 0x61, 0x13, 0xd1, 0xa4, 0x77, 0x65, 0x81, 0x87, 0x22, 0xbd, 0x96, 0x2d,
+    0xf8, 0x0c, 0xac, 0xca, 0x58, 0x5a, 0x03, 0x5e, 0xc9, 0x58, 0xb3, 0x1b, 0xde, 0x9b, 0xbe, 0x95,
+    0x2c, 0x12, 0xe9, 0x4d, 0x10, 0x04, 0xe3, 0x11, 0x41, 0x4d, 0x7f, 0x6d, 0xc7, 0x50, 0xe1, 0xbd,
+    0xc0, 0x71, 0xc5, 0xf2, 0x0e, 0x7a, 0xad, 0xfc, 0xc5, 0x7c, 0xc5, 0xe3, 0xde, 0x74, 0x3c, 0xc2,
+    0x8d, 0x0e, 0x36, 0xdb, 0xb7, 0x5a, 0x96, 0x5b, 0x96, 0x1e, 0x29, 0xea, 0x9a, 0x56, 0x3b, 0x24,
+    0x7d, 0xb5, 0xd4, 0x5a, 0xa6, 0x20, 0xd3, 0x30, 0x16, 0xe1, 0x82, 0xcc, 0x55, 0x66, 0xe6, 0x9c,
+    0xdf, 0xef, 0x95, 0x54, 0x48, 0xe7, 0x57, 0x1a, 0xc9, 0x5c, 0xe0, 0x13, 0x3c, 0x8f, 0x63, 0x6b,
+    0x30, 0xe3, 0x91, 0x3d, 0xdd, 0x82, 0x36, 0x33, 0xe2, 0xc9, 0x62, 0xb6, 0xb9, 0x62, 0xe1, 0x62,
+    0xa8, 0x50, 0xd9, 0xbc, 0xc4, 0x67, 0xb5, 0xf9, 0x26, 0x8a, 0xf9, 0x78, 0x94, 0x75, 0x68, 0xdf,
+    0x81, 0xa2, 0x2e, 0x97, 0x09, 0x1f, 0x86, 0xf6, 0x0e, 0x5d, 0x26, 0x10, 0xb3, 0x2b, 0x1e, 0x4f,
+    0x7f, 0x35, 0xb0, 0x27, 0xe3, 0x91, 0x7d, 0x6d, 0x07, 0x15, 0x69, 0xb6, 0xd4, 0xa0, 0x37, 0x19,
+    0xfa, 0x5a, 0xce, 0x52, 0x34, 0x13, 0xc3, 0xa9, 0xa3, 0xa3, 0x62, 0x11, 0xa1, 0x8b, 0x34, 0xa8,
+    0x17, 0xab, 0x89, 0x48, 0x27, 0xbd, 0x43, 0xfc, 0x64, 0x9f, 0x26, 0xbd, 0xa3, 0x43, 0x7c, 0x5a,
+    0xb1, 0x78, 0x89, 0x88, 0x7e, 0xc0, 0x47, 0x94, 0xe0, 0x9c, 0xf0, 0x91, 0x52, 0xb4, 0x65, 0xc5,
+    0xd7, 0x73, 0xa1, 0x02, 0x03, 0xd3, 0xbf, 0xd3, 0x7a, 0x1d, 0x2d, 0x03, 0xdd, 0x64, 0xc0, 0x2e,
+    0x4e, 0x7f, 0x38, 0xfc, 0xc6, 0x19, 0xf2, 0x23, 0xec, 0xa8, 0xf1, 0xda, 0xea, 0xdb, 0x09, 0x46,
+    0x88, 0xa1, 0x8b, 0x3b, 0x8f, 0x76, 0x70, 0x6b, 0x75, 0xaf, 0x05, 0x46, 0xbd, 0x0e, 0x9b, 0xcb,
+    0xea, 0x86, 0xf0, 0x8e, 0x7d, 0x12, 0xc9, 0x32, 0x81, 0x6b, 0x3c, 0x02, 0x4a, 0xfc, 0xc9, 0x4f,
+    0xe0, 0x87, 0xc3, 0xc3, 0x9f, 0x5f, 0x40, 0xc6, 0x73, 0xb3, 0x18, 0xc0, 0xc5, 0x32, 0xa3, 0xa0,
+    0xc8, 0x23, 0xb8, 0x96, 0x79, 0xc2, 0xf4, 0x09, 0x1a, 0xee, 0xf4, 0xdd, 0xf9, 0x33, 0xb4, 0xc0,
+    0x69, 0x00, 0xbf, 0xf0, 0x50, 0x26, 0x09, 0x4f, 0x23, 0x1e, 0x9d, 0xc0, 0x3f, 0xbe, 0x5f, 0x5c,
+    0x65, 0x0a, 0x12, 0x99, 0x4a, 0x90, 0x39, 0x3c, 0x3b, 0x36, 0xaf, 0x0a, 0xdd, 0x94, 0x4b, 0x3a,
+    0x0d, 0xb1, 0x44, 0x2d, 0xe5, 0xc0, 0xac, 0x05, 0x67, 0x7b, 0xa2, 0x0f, 0xd1, 0x1e, 0xc6, 0x42,
+    0xe9, 0x56, 0xcf, 0xfe, 0xfb, 0xfc, 0xf4, 0x5f, 0x59, 0x8c, 0x91, 0x0a, 0xee, 0x16, 0x1c, 0x5d,
+    0xde, 0x70, 0xb6, 0x34, 0x27, 0x86, 0xf4, 0xde, 0x03, 0x9e, 0x86, 0xd6, 0x9e, 0x93, 0x65, 0xac,
+    0x45, 0xc6, 0x72, 0x3d, 0xa2, 0x8d, 0x61, 0xc4, 0x34, 0xeb, 0x32, 0xbb, 0x0a, 0x6f, 0x0e, 0xd7,
+    0x4d, 0x2e, 0xa2, 0x5e, 0x15, 0xb9, 0x59, 0x98, 0x76, 0xc6, 0x2d, 0x22, 0xf1, 0x78, 0x83, 0x23,
+    0x3a, 0xca, 0x64, 0x00, 0x0a, 0x2a, 0xf4, 0x09, 0x09, 0x57, 0x0a, 0xc3, 0xb6, 0x82, 0xb5, 0xc0,
+    0x00, 0xc3, 0xb2, 0x8c, 0xb3, 0x1c, 0xe6, 0xa8, 0xb6, 0xa0, 0x82, 0xc9, 0x3d, 0xda, 0x67, 0x15,
+    0xe6, 0x22, 0xd3, 0xb7, 0x24, 0xae, 0x97, 0xa9, 0x11, 0x33, 0xa8, 0xb9, 0x5c, 0xbb, 0x3c, 0xe3,
+    0xbb, 0x10, 0xdd, 0x87, 0xcf, 0x35, 0x66, 0x23, 0x19, 0xa2, 0x67, 0xa5, 0x3a, 0xb8, 0xe1, 0xfa,
+    0x55, 0xcc, 0xe9, 0xf1, 0xc5, 0xe6, 0x4d, 0xe4, 0x7b, 0x8d, 0x2c, 0xe2, 0xf5, 0x03, 0xcd, 0x3f,
+    0xe9, 0x97, 0xd6, 0x29, 0x60, 0x02, 0x6e, 0x3f, 0x70, 0xfb, 0x81, 0x96, 0xaf, 0xc5, 0x27, 0x1e,
+    0xf9, 0xc7, 0xfd, 0xd3, 0x1a, 0x01, 0x74, 0x23, 0xa5, 0xc9, 0x84, 0x43, 0x3c, 0x87, 0x80, 0x95,
+    0xa3, 0x6e, 0xf1, 0xf4, 0x61, 0x0c, 0x99, 0x1c, 0x83, 0xec, 0xd8, 0xea, 0xc1, 0xd4, 0x01, 0x88,
+    0xb3, 0x42, 0xe0, 0x00, 0xbc, 0x6f, 0xbc, 0xd3, 0x6e, 0x83, 0x1c, 0x8d, 0x30, 0x17, 0xc4, 0xe8,
+    0x01, 0xa1, 0xa4, 0xb4, 0xd8, 0xc2, 0xad, 0x23, 0xf5, 0x96, 0x28, 0x21, 0xee, 0xfb, 0xb2, 0x54,
+    0xa7, 0x59, 0x45, 0x12, 0x18, 0x1b, 0x7b, 0x8b, 0x2e, 0x14, 0xe4, 0x3c, 0x91, 0x2b, 0x7e, 0x7b,
+    0xf6, 0x46, 0xca, 0xc8, 0x1b, 0x40, 0xf9, 0x9e, 0xf0, 0x48, 0x2c, 0x93, 0xea, 0x4a, 0x2c, 0xd7,
+    0x4d, 0xdc, 0xe2, 0x1a, 0xfc, 0xca, 0x8d, 0xa7, 0x18, 0x28, 0x9a, 0x8a, 0xdd, 0xc3, 0x02, 0x8b,
+    0xa2, 0x06, 0xfd, 0x06, 0xfa, 0x2d, 0xf0, 0x58, 0xf1, 0x5d, 0x2a, 0xc7, 0x8f, 0xa6, 0xe2, 0x6e,
+    0xd5, 0x4e, 0xe7, 0x71, 0x28, 0x5b, 0xc4, 0xb2, 0x7d, 0xb2, 0xfb, 0xf4, 0xa4, 0xaa, 0xf6, 0x58,
+    0x64, 0xb0, 0x00, 0x79, 0x0d, 0x2e, 0xdd, 0x0b, 0x10, 0xca, 0x3d, 0x8b, 0x20, 0xc9, 0x9e, 0x99,
+    0xc0, 0xb8, 0x40, 0x95, 0x1f, 0x0d, 0x8a, 0xe5, 0xdf, 0x17, 0x66, 0x83, 0x5d, 0x23, 0x51, 0xd0,
+    0x73, 0xa6, 0x77, 0xdd, 0x0c, 0x4b, 0x86, 0xec, 0x3d, 0x56, 0xad, 0xbe, 0x3d, 0x32, 0x80, 0x74,
+    0x99, 0x5c, 0xf1, 0xbc, 0x29, 0xab, 0x9c, 0xeb, 0x65, 0x9e, 0xa2, 0x5e, 0x0d, 0x94, 0x87, 0x76,
+    0xea, 0xb8, 0x38, 0x00, 0xdf, 0x9e, 0x40, 0x11, 0x1f, 0xc1, 0x8f, 0xe0, 0xfd, 0x4e, 0x9b, 0x6e,
+    0xe9, 0x04, 0x3c, 0xaf, 0x4f, 0x36, 0x4d, 0x6c, 0x54, 0xcc, 0xba, 0xfd, 0x86, 0x1f, 0x52, 0x0e,
+    0x36, 0x6e, 0x81, 0x8a, 0xa5, 0xf1, 0x3b, 0x28, 0xb8, 0x8a, 0x99, 0x88, 0x40, 0x62, 0xd6, 0xc7,
+    0x14, 0xcd, 0xf1, 0x2a, 0x1c, 0x6c, 0x2d, 0x8d, 0x8c, 0x51, 0x52, 0x51, 0x80, 0xd1, 0x02, 0x73,
+    0x7a, 0xba, 0x01, 0xa1, 0x61, 0xce, 0x54, 0x7b, 0x3c, 0xb1, 0x41, 0xfa, 0x02, 0x91, 0x2b, 0x3f,
+    0x94, 0xcb, 0x54, 0x0f, 0xcc, 0xfd, 0xd5, 0x39, 0xcf, 0x5f, 0x18, 0x42, 0xcd, 0x6b, 0x5b, 0x97,
+    0xa2, 0x28, 0xba, 0xcf, 0x95, 0x2a, 0xc1, 0xb6, 0xcd, 0xd8, 0x69, 0x3d, 0x08, 0xe7, 0x22, 0x8e,
+    0x72, 0x9e, 0x06, 0x31, 0x4f, 0x6f, 0xc8, 0xeb, 0x27, 0x13, 0x30, 0x2c, 0xb4, 0x59, 0xa5, 0x95,
+    0x76, 0x97, 0x7d, 0xd0, 0x9f, 0xc1, 0x29, 0x52, 0xec, 0x05, 0x7e, 0xba, 0x7c, 0xf7, 0x16, 0x99,
+    0xf3, 0x1a, 0x51, 0x83, 0x8c, 0xc1, 0x8f, 0xb9, 0x46, 0x33, 0x41, 0x8b, 0x38, 0xc5, 0x8f, 0xb1,
+    0x23, 0x88, 0xcf, 0x07, 0x07, 0x6d, 0x54, 0x09, 0x5a, 0x66, 0x24, 0x2c, 0xd5, 0x82, 0xb0, 0x86,
+    0x74, 0x61, 0x91, 0x2e, 0x0c, 0xd2, 0x9a, 0x04, 0x71, 0xb1, 0x1d, 0x3b, 0xfd, 0x15, 0xd8, 0x0f,
+    0x26, 0x30, 0x1b, 0xdb, 0x97, 0xa2, 0xfc, 0x7a, 0xfa, 0x79, 0xb1, 0xed, 0x4d, 0x9f, 0x7e, 0x2e,
+    0xed, 0x51, 0x0c, 0x60, 0xd1, 0xdf, 0x8e, 0x47, 0x16, 0x6c, 0x3a, 0xdb, 0xe5, 0x66, 0xbb, 0xb3,
+    0x62, 0xd5, 0x25, 0x34, 0x4f, 0xaa, 0xea, 0x0a, 0x73, 0x8e, 0x95, 0xab, 0xd3, 0x98, 0xef, 0x61,
+    0xf2, 0x69, 0x6a, 0xc9, 0x68, 0x0a, 0x4f, 0x59, 0x77, 0x25, 0xf2, 0x24, 0x00, 0xa7, 0x56, 0xda,
+    0xf0, 0x3a, 0xe0, 0xab, 0x1a, 0x98, 0xb9, 0x12, 0xd6, 0xca, 0x01, 0x9e, 0x7e, 0x16, 0xdb, 0x07,
+    0xd4, 0xb1, 0x54, 0xa7, 0xf4, 0x5c, 0xff, 0x68, 0x9f, 0x29, 0xf5, 0x0f, 0xad, 0xfd, 0x93, 0x78,
+    0xc4, 0xb6, 0x07, 0x2c, 0x0c, 0x79, 0x86, 0xdd, 0x24, 0xb9, 0x53, 0x67, 0x31, 0xca, 0x63, 0x2c,
+    0x54, 0xec, 0x69, 0x12, 0xa6, 0x3b, 0x8b, 0xa2, 0x75, 0xd2, 0x47, 0x99, 0x5a, 0x98, 0xbb, 0xcb,
+    0x0a, 0x4b, 0x1d, 0x0d, 0x5b, 0x2e, 0xb3, 0x7d, 0xad, 0x94, 0x8b, 0x05, 0xf6, 0x26, 0xf6, 0xa5,
+    0x77, 0xdb, 0x8e, 0x58, 0x39, 0x52, 0x4d, 0xe4, 0x13, 0x2b, 0x58, 0x46, 0x5b, 0x3f, 0xec, 0x6e,
+    0x3d, 0xee, 0x89, 0x58, 0x73, 0xa5, 0xad, 0xb4, 0x0b, 0xc4, 0x97, 0xb8, 0xb2, 0x1f, 0xad, 0x2d,
+    0x3e, 0x5a, 0xac, 0xc9, 0x78, 0x14, 0x55, 0x2c, 0x69, 0xf4, 0x92, 0x7c, 0xd5, 0x27, 0x05, 0x3f,
+    0x24, 0x46, 0xd7, 0x22, 0x8d, 0xa9, 0x00, 0x7d, 0xaa, 0x3b, 0xdb, 0x43, 0x4a, 0xdd, 0x69, 0xd0,
+    0x7a, 0x08, 0x34, 0x68, 0xac, 0xfe, 0xf5, 0x17, 0x3a, 0x59, 0xed, 0x70, 0x33, 0x88, 0x99, 0x53,
+    0xf6, 0xba, 0x6a, 0x27, 0x96, 0xb5, 0xd5, 0x32, 0x64, 0x5a, 0x94, 0x8e, 0xf6, 0x85, 0xb3, 0xb2,
+    0x64, 0x6e, 0xba, 0x49, 0x71, 0xb8, 0x1e, 0x78, 0xaa, 0x06, 0x63, 0x8e, 0xda, 0x9a, 0xb0, 0x56,
+    0x7b, 0x7a, 0xa7, 0xdd, 0x61, 0xb5, 0xc4, 0xfa, 0x9f, 0x25, 0xa6, 0xc6, 0x0b, 0x63, 0x9a, 0x32,
+    0xf7, 0xbd, 0xa0, 0x89, 0xac, 0xc9, 0xce, 0xdd, 0xf1, 0xae, 0x2a, 0x9e, 0xce, 0xb0, 0xf7, 0xa5,
+    0x41, 0xed, 0x56, 0xb0, 0xa9, 0x0d, 0x1c, 0xf5, 0x10, 0x76, 0xba, 0xe7, 0x10, 0x41, 0xd6, 0x74,
+    0x8f, 0x77, 0x4e, 0x23, 0x3f, 0x84, 0xc9, 0x14, 0xc2, 0xc0, 0xa2, 0x9b, 0x4c, 0x4a, 0xdc, 0x1d,
+    0xb8, 0x4c, 0xea, 0x8c, 0x37, 0x26, 0x2b, 0x5e, 0x8b, 0xbc, 0xc0, 0x8b, 0x95, 0x02, 0x2b, 0x6b,
+    0x05, 0x65, 0x88, 0x60, 0xef, 0xb5, 0x9e, 0x53, 0x87, 0x86, 0x49, 0x12, 0x97, 0x12, 0xa1, 0x54,
+    0xb3, 0x88, 0xac, 0x26, 0xae, 0xaf, 0x0c, 0x9e, 0x6f, 0xbf, 0x45, 0x91, 0x60, 0x72, 0xef, 0xba,
+    0xbf, 0xbb, 0x8e, 0x16, 0xe9, 0x92, 0xb7, 0x33, 0xb8, 0xdd, 0x23, 0x02, 0x32, 0x9e, 0x07, 0xc7,
+    0x6a, 0x53, 0x6b, 0x8b, 0x55, 0x3d, 0x5c, 0x57, 0xcd, 0xa5, 0x23, 0x66, 0x17, 0x59, 0x2e, 0x2c,
+    0x3b, 0x81, 0x19, 0x59, 0xef, 0xd4, 0x74, 0xf0, 0xd5, 0xc0, 0x8d, 0xd9, 0xa8, 0xa8, 0x67, 0xe0,
+    0x6b, 0x2a, 0x68, 0x16, 0xa6, 0x96, 0xd9, 0xba, 0xd6, 0x7d, 0x76, 0xda, 0x29, 0x33, 0x12, 0xd9,
+    0x1d, 0x92, 0xa2, 0x5b, 0x73, 0xcd, 0x44, 0x4c, 0x69, 0x76, 0xf6, 0xf4, 0xb3, 0x39, 0x13, 0x24,
+    0x0a, 0x46, 0x70, 0x74, 0x78, 0x78, 0xd8, 0x2f, 0xdb, 0x91, 0xa3, 0xfe, 0x16, 0xd0, 0xad, 0x6d,
+    0x52, 0x0c, 0xa8, 0x07, 0xde, 0x02, 0xfd, 0x2f, 0x97, 0xe6, 0x7f, 0x6e, 0xe1, 0xa7, 0x3f, 0xcb,
+    0xd7, 0x1b, 0x6c, 0xfd, 0xcf, 0xae, 0x60, 0x3a, 0x81, 0x43, 0xe2, 0xfc, 0xc0, 0xb3, 0x4c, 0xd7,
+    0x76, 0xb7, 0x10, 0xbd, 0xa0, 0x03, 0xef, 0x98, 0x9e, 0x07, 0x18, 0xd7, 0xc9, 0xdc, 0x68, 0xf7,
+    0x6a, 0x83, 0xd1, 0xd4, 0x70, 0x70, 0xfc, 0x3d, 0x92, 0xfd, 0x19, 0x81, 0xbe, 0x2e, 0xa8, 0x30,
+    0x35, 0xdf, 0x76, 0x5c, 0xb9, 0x50, 0x3e, 0x49, 0xd3, 0x64, 0x75, 0x33, 0x0b, 0xa9, 0x44, 0x03,
+    0xb2, 0xdb, 0x1e, 0x98, 0xb1, 0x2a, 0x65, 0x22, 0x77, 0x71, 0x93, 0x8f, 0x8a, 0xed, 0x42, 0xaa,
+    0x36, 0x54, 0xec, 0x4c, 0xb3, 0x22, 0x8c, 0x08, 0x9a, 0x9b, 0xf4, 0xe1, 0x55, 0x0e, 0x79, 0x18,
+    0xee, 0xcf, 0xe2, 0xdb, 0x68, 0xdf, 0xc1, 0x60, 0x67, 0x99, 0x7e, 0x27, 0xf7, 0xa9, 0x1c, 0x9a,
+    0x44, 0x3c, 0xfd, 0xf8, 0xde, 0x76, 0xf4, 0xbf, 0xd5, 0xf8, 0x9c, 0x3d, 0xc4, 0xd6, 0xc9, 0x58,
+    0xab, 0x41, 0xd3, 0x11, 0x6d, 0x47, 0xb1, 0x93, 0x89, 0xf0, 0x74, 0xff, 0xae, 0xf2, 0xe7, 0xfe,
+    0xa9, 0xc9, 0xcd, 0xb5, 0xec, 0x58, 0xaa, 0x3d, 0x3b, 0xd9, 0xbd, 0x73, 0xdb, 0x3e, 0x21, 0xbb,
+    0x15, 0x63, 0xb1, 0x5b, 0xf0, 0x1d, 0x99, 0x6a, 0xff, 0x9e, 0xdd, 0x6f, 0x6d, 0x04, 0x87, 0xdd,
+    0xaf, 0x29, 0xf9, 0x10, 0x6d, 0x8d, 0xcc, 0xc3, 0x70, 0x19, 0x14, 0x3b, 0x7d, 0x7d, 0x9d, 0xef,
+    0x46, 0x2f, 0x7d, 0x97, 0x5c, 0x68, 0x84, 0xc1, 0x7d, 0x33, 0xe5, 0x6c, 0x97, 0x0a, 0xd1, 0x42,
+    0x22, 0x06, 0x22, 0xa0, 0xb1, 0x28, 0xc6, 0x4e, 0xf4, 0xb3, 0xd9, 0xb9, 0x7b, 0xbc, 0x2a, 0xe2,
+    0x87, 0x85, 0xb0, 0xaf, 0xdb, 0x19, 0xb5, 0x48, 0x76, 0x65, 0x25, 0xb1, 0x63, 0x51, 0x2e, 0xb0,
+    0xcc, 0xc0, 0x3f, 0x28, 0x40, 0xdd, 0xc6, 0x10, 0x8e, 0xb6, 0x90, 0xc8, 0x9c, 0xf7, 0x67, 0xae,
+    0x75, 0xc2, 0xff, 0x34, 0x62, 0xf5, 0xee, 0x29, 0x9c, 0xfa, 0xac, 0x76, 0x47, 0x3c, 0xf4, 0xb6,
+    0x5b, 0x4f, 0x38, 0x7b, 0x28, 0x38, 0x31, 0x56, 0x71, 0x57, 0xab, 0x76, 0x79, 0xdb, 0x80, 0x65,
+    0x4b, 0x35, 0x47, 0xde, 0x5d, 0x67, 0x3b, 0x80, 0x82, 0x87, 0x81, 0xd3, 0x06, 0xb0, 0x34, 0xb2,
+    0x63, 0x41, 0x3b, 0x5b, 0x55, 0x20, 0x57, 0xd8, 0xd8, 0x49, 0x6c, 0xf6, 0x50, 0xac, 0xa9, 0x1d,
+    0xaa, 0xb5, 0xf4, 0xa5, 0x76, 0xef, 0xd5, 0x0a, 0x59, 0x57, 0x7e, 0xbb, 0x42, 0xb8, 0xd9, 0xc4,
+    0x8b, 0xa5, 0x7c, 0x0d, 0x06, 0xf2, 0x42, 0x2e, 0x51, 0xf7, 0xbe, 0x37, 0xb2, 0x5b, 0xcd, 0xdc,
+    0x61, 0x57, 0xa9, 0x15, 0x37, 0xd0, 0x54, 0x75, 0x70, 0x74, 0xca, 0xb2, 0x2f, 0xf7, 0x06, 0xc0,
+    0x29, 0xf7, 0x56, 0x67, 0x4f, 0xff, 0xbc, 0xf8, 0xf0, 0x3e, 0xc8, 0x58, 0xae, 0xb8, 0xcf, 0x03,
+    0xaa, 0xaa, 0xfb, 0xfd, 0xfb, 0x62, 0xa5, 0x5b, 0xab, 0x2a, 0x4e, 0x5b, 0x15, 0x7e, 0x01, 0x46,
+    0xab, 0xd7, 0x0a, 0x46, 0x6b, 0xb4, 0xf7, 0xc6, 0x88, 0x52, 0xcf, 0x73, 0xac, 0x77, 0x26, 0x80,
+    0x22, 0x45, 0x14, 0xbb, 0x61, 0xb1, 0xd3, 0xb6, 0x6c, 0x66, 0xdd, 0xb1, 0x29, 0xef, 0x65, 0xa9,
+    0x44, 0x88, 0xa5, 0xc2, 0x8e, 0x3a, 0xe7, 0x85, 0x5e, 0xcd, 0xd7, 0x36, 0x0d, 0xdb, 0xdd, 0x76,
+    0xf0, 0x25, 0x31, 0xdc, 0xfd, 0x0f, 0xd8, 0xe2, 0xd1, 0x1e, 0x06, 0xf6, 0x45, 0x84, 0x4a, 0xd3,
+    0x62, 0x1d, 0xf9, 0xfd, 0x32, 0x69, 0xb7, 0x42, 0xdb, 0xc5, 0x55, 0x6a, 0x98, 0x7a, 0x1d, 0x3b,
+    0x33, 0xfb, 0x1f, 0x1b, 0xdd, 0x5c, 0x89, 0x73, 0xdb, 0xfb, 0x6d, 0xd6, 0x5a, 0xa9, 0x9b, 0x2a,
+    0xd2, 0x8e, 0x51, 0xba, 0x71, 0xdb, 0x46, 0xee, 0x63, 0xad, 0xd9, 0xab, 0xa3, 0xb6, 0xc1, 0xb6,
+    0xab, 0x15, 0x40, 0xd4, 0x86, 0x3d, 0x53, 0x6b, 0xab, 0x8f, 0x87, 0xbf, 0xed, 0xa9, 0xb0, 0x4d,
+    0x45, 0x48, 0x70, 0x6d, 0xe5, 0x0d, 0x8b, 0x79, 0x8e, 0xf5, 0xda, 0x79, 0xcc, 0x19, 0x66, 0x5b,
+    0xd7, 0x83, 0x32, 0x4b, 0xc3, 0xd4, 0xa4, 0x6d, 0x65, 0xdc, 0xdd, 0x63, 0x8e, 0x1d, 0x06, 0xcc,
+    0x57, 0x09, 0xf4, 0xfd, 0x82, 0x99, 0x1b, 0xd2, 0xdf, 0x1e, 0x6e, 0x48, 0x7b, 0xa0, 0xa5, 0x84,
+    0x98, 0xe5, 0x37, 0xfc, 0x2b, 0x28, 0xbe, 0xa4, 0x30, 0xe7, 0xb1, 0xfe, 0x35, 0xdf, 0x50, 0xfc,
+    0x0d, 0x8c, 0x39, 0x79, 0xca, 0x3c, 0x39, 0x43, 0x45, 0xb8, 0x78, 0xf4, 0xda, 0xbd, 0xfa, 0xfd,
+    0x9d, 0xc1, 0x8c, 0x59, 0x77, 0x19, 0xde, 0x46, 0x09, 0x74, 0x69, 0x23, 0xd9, 0x3b, 0x40, 0xdd,
+    0xf4, 0xad, 0x98, 0xef, 0x91, 0x49, 0xee, 0x51, 0xd8, 0xdd, 0x3e, 0x53, 0x1b, 0x5f, 0xd8, 0xbe,
+    0x92, 0x12, 0x59, 0x65, 0x0a, 0x53, 0x12, 0x1a, 0x54, 0x0c, 0xb2, 0xbf, 0x45, 0xbf, 0x9e, 0xed,
+    0x9f, 0x52, 0x3f, 0x47, 0x1e, 0xd5, 0xa6, 0x48, 0x12, 0x2c, 0x55, 0x6b, 0x9e, 0x93, 0xc4, 0x9f,
+    0xc1, 0x5a, 0xe8, 0x39, 0xfc, 0xc2, 0x75, 0xbe, 0x19, 0x3e, 0xa7, 0xc1, 0xe4, 0x29, 0x9a, 0x0b,
+    0xa6, 0x08, 0x6c, 0x49, 0x18, 0x95, 0xa8, 0x64, 0x35, 0x28, 0x3e, 0x2d, 0x12, 0xae, 0x5a, 0xa4,
+    0x6c, 0x60, 0x27, 0xa4, 0xa1, 0x5c, 0x60, 0x2e, 0xc1, 0x60, 0x71, 0xcd, 0x75, 0x38, 0xc7, 0x90,
+    0x6f, 0x3d, 0xf6, 0x47, 0xe7, 0x63, 0xb7, 0x23, 0x4a, 0xe4, 0x99, 0x4a, 0x81, 0x6f, 0x8d, 0x7f,
+    0xd0, 0xf2, 0xed, 0x45, 0x06, 0x2d, 0xb6, 0x93, 0x70, 0x3d, 0x97, 0x11, 0x26, 0xde, 0xf3, 0x0f,
+    0x17, 0x97, 0xde, 0x60, 0x77, 0xbc, 0x2b, 0xa3, 0xcd, 0x49, 0xa9, 0x9a, 0xba, 0x89, 0xf4, 0x6b,
+    0xaf, 0x01, 0x36, 0x64, 0xa9, 0x9f, 0x73, 0x95, 0x21, 0xe7, 0xbc, 0x3d, 0xae, 0x91, 0x4d, 0x17,
+    0x10, 0x81, 0xd5, 0x8b, 0x69, 0xf9, 0x48, 0x50, 0xd8, 0x78, 0x15, 0xd7, 0x9c, 0xc2, 0xe1, 0xfe,
+    0xf6, 0x53, 0x51, 0xd0, 0x8d, 0x28, 0x17, 0x9a, 0x34, 0xf0, 0x06, 0x9b, 0xa7, 0x12, 0x2d, 0xfd,
+    0xa6, 0x00, 0x85, 0x4f, 0x66, 0xe0, 0x7b, 0x15, 0xc1, 0x7b, 0xfd, 0x3e, 0x8d, 0x18, 0x8e, 0x3b,
+    0xfa, 0xab, 0x87, 0x59, 0xcf, 0x99, 0x55, 0x34, 0x29, 0x7d, 0x60, 0xd8, 0x36, 0x25, 0x91, 0x30,
+    0xe5, 0x90, 0xe5, 0x0d, 0x7b, 0x99, 0x5d, 0xb3, 0x69, 0xcc, 0x97, 0xc9, 0x71, 0xce, 0x73, 0x89,
+    0x8d, 0x29, 0x27, 0xfe, 0x65, 0xbc, 0xb2, 0x99, 0x8e, 0xeb, 0x4b, 0xb4, 0x07, 0xb9, 0xd4, 0xc5,
+    0xea, 0xa0, 0xbc, 0xf1, 0x77, 0xb6, 0x69, 0xea, 0x5b, 0x69, 0xdb, 0xfc, 0x41, 0x46, 0xe2, 0x17,
+    0xb2, 0xc3, 0xaa, 0xaa, 0xdf, 0xbf, 0xcf, 0xf4, 0xd0, 0xf1, 0x50, 0xca, 0x4d, 0x2e, 0xb0, 0x4c,
+    0x2b, 0xdf, 0xfe, 0x50, 0x32, 0xf5, 0xa9, 0x22, 0x73, 0xfc, 0x05, 0x39, 0xff, 0x03, 0x83, 0x9c,
+    0xef, 0xbd, 0xe7, 0x7a, 0x2d, 0xf3, 0x45, 0x09, 0x09, 0x6b, 0xa6, 0x20, 0x95, 0x1a, 0xe4, 0x22,
+    0xd8, 0x19, 0xf2, 0x37, 0xde, 0x0d, 0xa3, 0xcf, 0xda, 0xcc, 0x26, 0x32, 0x91, 0xe4, 0x71, 0xa9,
+    0xb0, 0xaa, 0x18, 0xc2, 0x13, 0xb8, 0xaf, 0xe5, 0x5a, 0x86, 0x98, 0x26, 0xf8, 0x17, 0xf5, 0x78,
+    0x73, 0xe4, 0xdb, 0xb4, 0xe7, 0x90, 0x91, 0xa7, 0xb9, 0x0a, 0xe2, 0xcb, 0x59, 0xf3, 0xdc, 0x77,
+    0xa6, 0xd7, 0xd8, 0x11, 0xd2, 0xb7, 0xbe, 0xe4, 0x9b, 0x06, 0x79, 0xb7, 0xcc, 0xf6, 0x65, 0xec,
+    0xca, 0x34, 0xb0, 0x33, 0x63, 0x17, 0xb1, 0x82, 0x60, 0xbd, 0xc7, 0x78, 0xbf, 0xf3, 0xa5, 0x13,
+    0xf8, 0xec, 0xb9, 0x62, 0x63, 0x78, 0xb9, 0xc9, 0xb8, 0x87, 0x27, 0x30, 0x48, 0x63, 0xc3, 0xca,
+    0x88, 0x97, 0xd1, 0xa7, 0xe1, 0x7a, 0xbd, 0x36, 0x5f, 0xed, 0x0e, 0x97, 0x39, 0x36, 0xac, 0xa1,
+    0x8c, 0x78, 0xe4, 0x6d, 0xbb, 0xa2, 0x89, 0xd7, 0x16, 0xb4, 0x1e, 0x25, 0x84, 0xca, 0x4f, 0x3f,
+    0x3a, 0xae, 0x4e, 0x10, 0xf7, 0xb8, 0xfa, 0x43, 0x0c, 0x81, 0x42, 0x90, 0xc4, 0xbc, 0x6c, 0x16,
+    0x7c, 0xef, 0x95, 0x59, 0x27, 0x3a, 0x19, 0xc5, 0x00, 0xf3, 0x25, 0xfd, 0x09, 0x15, 0xad, 0xb4,
+    0xde, 0xbf, 0xe7, 0x45, 0x2a, 0x5d, 0x7f, 0x39, 0xfe, 0x6a, 0x30, 0x6d, 0xc6, 0x2d, 0x32, 0xc5,
+    0xf2, 0x22, 0xf1, 0xbd, 0xe7, 0x39, 0x87, 0x8d, 0x5c, 0x82, 0x5a, 0xba, 0x87, 0x35, 0xc3, 0x42,
+    0x50, 0x4b, 0x87, 0xc8, 0x18, 0x57, 0x39, 0xa3, 0xc3, 0x74, 0xf0, 0x23, 0x45, 0xbf, 0x96, 0x61,
+    0xa0, 0x93, 0x92, 0x3d, 0xd5, 0x2a, 0xa7, 0x16, 0x33, 0x81, 0x56, 0xa0, 0xbf, 0xdb, 0x56, 0x2a,
+    0xf6, 0x52, 0xdc, 0x64, 0x52, 0xbd, 0xd6, 0x6e, 0x88, 0xeb, 0xef, 0x2c, 0xdd, 0x27, 0x27, 0x95,
+    0xc5, 0x5e, 0x25, 0x12, 0xf6, 0x8b, 0xe8, 0xd8, 0x8c, 0x7e, 0x67, 0x24, 0x28, 0x52, 0x98, 0xf5,
+    0xe2, 0xa0, 0x73, 0x5c, 0xf7, 0xb0, 0x74, 0x62, 0x4a, 0xb7, 0xca, 0xb4, 0xc7, 0xa9, 0x31, 0x6a,
+    0xcb, 0x1f, 0x6d, 0xd7, 0x6c, 0x58, 0xe8, 0xc3, 0xa8, 0x5b, 0x43, 0x7d, 0xd4, 0xe8, 0xbf, 0xfc,
+    0xd9, 0x90, 0xfd, 0xc5, 0xd0, 0xbd, 0xa6, 0x2b, 0x65, 0xc6, 0xb6, 0x67, 0x4e, 0x3b, 0x8f, 0xbc,
+    0xc6, 0x70, 0xb9, 0x3b, 0xe6, 0x30, 0x53, 0xc3, 0xe0, 0xf0, 0x31, 0x85, 0xe0, 0xe3, 0x87, 0x29,
+    0xbb, 0xf3, 0x77, 0xe7, 0x38, 0xf6, 0xd4, 0xff, 0x53, 0x6c, 0xb5, 0x1c, 0x19, 0x4f, 0xa9, 0x88,
+    0xf1, 0xcb, 0xe3, 0x1b, 0xd7, 0xd4, 0xe1, 0x3a, 0x9c, 0xf7, 0x8d, 0x6f, 0x58, 0x19, 0xbf, 0xb1,
+    0x3f, 0xfb, 0xb4, 0x73, 0x24, 0x60, 0x79, 0x2e, 0x56, 0x58, 0xa5, 0x60, 0xcd, 0xa0, 0x24, 0x5a,
+    0x10, 0x7e, 0xd2, 0x1c, 0xdf, 0xf4, 0xc5, 0x08, 0x92, 0x73, 0x96, 0x14, 0xb3, 0x90, 0xdb, 0x72,
+    0xb8, 0x54, 0xe8, 0xee, 0x84, 0xe0, 0xec, 0xc3, 0x3b, 0x27, 0x3c, 0xfa, 0xe5, 0x24, 0xa7, 0x9f,
+    0x67, 0xd4, 0x46, 0x29, 0x8e, 0xbd, 0xf1, 0xa8, 0xf8, 0xe1, 0xcd, 0x78, 0x64, 0x7f, 0x6c, 0x3a,
+    0x1e, 0xd9, 0xdf, 0xca, 0xfe, 0x17, 0x36, 0x1a, 0x46, 0x39, 0x45, 0x2b, 0x00, 0x00,
+};
+const size_t WEB_HTML_GZ_LEN = 3054;
+const char WEB_HTML_ETAG[] = "\"d6e8395dffa4837e\"";
+
+// 3056 bytes raw, 959 bytes gzipped
+const uint8_t WEB_CSS_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xad, 0x56, 0xed, 0x8a, 0xeb, 0x36,
+    0x10, 0xfd, 0x9f, 0xa7, 0x10, 0x77, 0xb9, 0xb0, 0x0b, 0xab, 0xe0, 0x7c, 0x6e, 0x36, 0xa1, 0xa5,
+    0xa5, 0xd0, 0x97, 0x28, 0xfd, 0x21, 0x5b, 0x63, 0x5b, 0xbd, 0xb2, 0x64, 0x64, 0x39, 0x1f, 0x2d,
+    0x79, 0xf7, 0x8e, 0x64, 0x3b, 0x91, 0x1d, 0x3b, 0xed, 0x2d, 0xc5, 0x24, 0x60, 0x79, 0x74, 0xe6,
+    0xcc, 0x9c, 0x99, 0x91, 0x66, 0xb1, 0xe6, 0x17, 0xf2, 0x17, 0x49, 0xb5, 0xb2, 0x34, 0x65, 0x85,
+    0x90, 0x97, 0x3d, 0xa9, 0x98, 0xaa, 0x68, 0x05, 0x46, 0xa4, 0x07, 0x12, 0xb3, 0xe4, 0x5b, 0x66,
+    0x74, 0xad, 0x38, 0x4d, 0xb4, 0xd4, 0x66, 0x4f, 0x5e, 0xd2, 0xb5, 0x7b, 0x0e, 0xa4, 0x7b, 0x5f,
+    0xad, 0x56, 0x07, 0x52, 0x30, 0x93, 0x09, 0xb5, 0x27, 0xd1, 0x81, 0x94, 0x8c, 0x73, 0xa1, 0xb2,
+    0x3d, 0x59, 0x44, 0xe5, 0xf9, 0x40, 0xae, 0xb3, 0x79, 0x82, 0xe8, 0x4c, 0x28, 0x30, 0xe8, 0xa9,
+    0x60, 0x67, 0x7a, 0x12, 0xdc, 0xe6, 0x7b, 0xb2, 0x8b, 0xbc, 0x41, 0xb7, 0x95, 0xd5, 0x56, 0x87,
+    0x0e, 0xf7, 0xe4, 0x94, 0x0b, 0x0b, 0x0f, 0x80, 0xb1, 0x36, 0x1c, 0x0c, 0x35, 0x8c, 0x8b, 0xba,
+    0x42, 0x94, 0x66, 0xed, 0x4c, 0xab, 0x9c, 0x71, 0x7d, 0x42, 0x0a, 0x64, 0x59, 0x9e, 0xc9, 0x1a,
+    0x7f, 0x26, 0x8b, 0xd9, 0x6b, 0xf4, 0xee, 0x9f, 0xf9, 0xe2, 0xcd, 0x71, 0xc9, 0x17, 0xef, 0x24,
+    0x5f, 0x22, 0x8f, 0x8e, 0x7d, 0x14, 0x6d, 0xb6, 0xf1, 0xca, 0xd3, 0xac, 0x20, 0xb1, 0x42, 0x2b,
+    0x4f, 0xd2, 0x51, 0xa2, 0xb1, 0xb6, 0x56, 0x17, 0xe8, 0x77, 0x73, 0xf7, 0x8b, 0x6f, 0x88, 0x5c,
+    0x69, 0x29, 0x38, 0x79, 0xe1, 0x9c, 0xff, 0x13, 0xbd, 0x4d, 0x9b, 0x03, 0xab, 0x4b, 0x6a, 0xf4,
+    0x09, 0xc1, 0xb9, 0xa8, 0x4a, 0xc9, 0x30, 0xcf, 0xa9, 0x04, 0xfc, 0x96, 0xb1, 0xb2, 0xf3, 0xe0,
+    0x16, 0xe8, 0xc9, 0xb8, 0x05, 0xf7, 0x7f, 0x18, 0xe7, 0x11, 0x80, 0x05, 0x94, 0xdd, 0x5e, 0xb4,
+    0xc0, 0x3d, 0xb8, 0xa1, 0x4d, 0xf0, 0x72, 0x13, 0x24, 0xf8, 0x86, 0x12, 0x79, 0x08, 0xa1, 0x52,
+    0xdd, 0x09, 0x5f, 0x89, 0x3f, 0x01, 0xd7, 0xe7, 0x9f, 0x50, 0xdc, 0x65, 0xdd, 0x6e, 0xb7, 0xce,
+    0xf0, 0x25, 0x66, 0xd6, 0x82, 0xb9, 0xd0, 0x76, 0xc3, 0x80, 0x3d, 0x93, 0x22, 0x53, 0x14, 0x65,
+    0x2a, 0x30, 0xd6, 0x04, 0x14, 0x9a, 0x7a, 0xf8, 0x02, 0xf5, 0xa6, 0x4e, 0x77, 0x5c, 0x0a, 0x77,
+    0x65, 0x46, 0x60, 0xca, 0xdc, 0x3f, 0xc5, 0x3d, 0xb8, 0x66, 0xc1, 0x15, 0x56, 0x5d, 0x28, 0xdc,
+    0xbf, 0x48, 0x4d, 0x2f, 0x1f, 0xd7, 0xd9, 0x4f, 0x05, 0x70, 0xc1, 0xc8, 0x6b, 0x10, 0xd4, 0xc7,
+    0x16, 0x15, 0x7f, 0x43, 0xcc, 0xa1, 0x8f, 0x69, 0xd0, 0x06, 0xf8, 0xea, 0x78, 0x75, 0xd1, 0xc4,
+    0xcc, 0x15, 0x63, 0x0b, 0xb9, 0x68, 0x0a, 0x31, 0x07, 0x91, 0xe5, 0x16, 0xd3, 0x16, 0x4d, 0xc8,
+    0x9d, 0x24, 0xc9, 0x83, 0xbe, 0xeb, 0x20, 0xc3, 0x12, 0x52, 0x7b, 0x2b, 0x83, 0xc7, 0xc6, 0x81,
+    0x4f, 0xf7, 0xf4, 0x92, 0x2a, 0xe1, 0x08, 0x12, 0x89, 0x74, 0xae, 0x91, 0xc9, 0xd7, 0x07, 0x17,
+    0xab, 0x56, 0xf5, 0x6e, 0x53, 0xa6, 0x35, 0xc7, 0x3d, 0x23, 0x1e, 0xd6, 0xbf, 0xfc, 0xfc, 0xeb,
+    0x26, 0xea, 0x19, 0xbb, 0x04, 0xd6, 0xc5, 0xb8, 0x79, 0x9a, 0x26, 0x8b, 0xe8, 0xa3, 0x67, 0x2e,
+    0x7d, 0x89, 0x8e, 0x76, 0xfd, 0x7a, 0xb5, 0xf2, 0x15, 0x31, 0xaf, 0x4b, 0xa9, 0x19, 0xa7, 0x2e,
+    0xdf, 0xff, 0x41, 0xda, 0x69, 0x65, 0xb7, 0x4e, 0x06, 0xaf, 0x6c, 0xdf, 0xc3, 0x04, 0xa4, 0x81,
+    0x12, 0x98, 0x7d, 0x5d, 0xbe, 0x3b, 0xf0, 0xb7, 0x56, 0xdf, 0x76, 0xa7, 0x2b, 0xc8, 0x5e, 0x1c,
+    0x2e, 0x82, 0x4f, 0xf7, 0x04, 0xfd, 0xba, 0x9c, 0x6a, 0xd7, 0xa9, 0x4e, 0x1f, 0xd4, 0xbe, 0x6f,
+    0x57, 0x2e, 0x4c, 0xd3, 0x83, 0x7b, 0xd2, 0x30, 0x3b, 0x0c, 0x69, 0x48, 0x16, 0x7b, 0x8d, 0x7d,
+    0xab, 0x9d, 0x5a, 0xa1, 0x63, 0x2d, 0x43, 0xc0, 0x58, 0xea, 0xe4, 0xdb, 0x43, 0xa7, 0x76, 0xed,
+    0x1e, 0xa2, 0x55, 0x20, 0xd1, 0xdf, 0xc8, 0x8c, 0x8a, 0x46, 0x8c, 0xe7, 0x71, 0x8d, 0x5f, 0x15,
+    0x75, 0x39, 0x28, 0x27, 0x46, 0xcf, 0x26, 0x28, 0x60, 0x9c, 0x2b, 0xdd, 0x1c, 0x7e, 0x8a, 0xd4,
+    0xbc, 0x20, 0xe0, 0x2d, 0x97, 0x6e, 0xdc, 0xfa, 0x49, 0xdc, 0x1b, 0x28, 0x3b, 0x37, 0x50, 0xae,
+    0x33, 0xa1, 0xca, 0xda, 0xfe, 0x66, 0x2f, 0x25, 0xfc, 0xf0, 0x25, 0x15, 0x12, 0xbe, 0xfc, 0x1e,
+    0x72, 0x19, 0x8f, 0xbd, 0x89, 0xe7, 0xde, 0xa0, 0x5f, 0x1d, 0x50, 0xe3, 0xf7, 0x1d, 0xe7, 0x9e,
+    0x9b, 0x80, 0xb1, 0x55, 0xe3, 0xb5, 0x1a, 0x45, 0x1f, 0x71, 0x9a, 0xde, 0x46, 0x59, 0x7b, 0x8c,
+    0x74, 0xaa, 0x2a, 0xad, 0xc2, 0x43, 0x05, 0xe3, 0x0f, 0x55, 0xef, 0x37, 0x76, 0x52, 0x9b, 0xca,
+    0x41, 0x94, 0x5a, 0x34, 0xa3, 0x2d, 0x08, 0x6f, 0xd1, 0x04, 0xd7, 0x70, 0xda, 0xe7, 0xfa, 0x08,
+    0x26, 0x60, 0xd6, 0x2c, 0x4c, 0xf1, 0xbb, 0x9f, 0x39, 0x4f, 0x03, 0xe1, 0xc9, 0x6a, 0xb3, 0xde,
+    0xf4, 0x0c, 0x9f, 0xe1, 0x26, 0xbb, 0xa5, 0x3f, 0x8c, 0xd1, 0xdc, 0xa5, 0xb9, 0xeb, 0x82, 0x81,
+    0xea, 0x7f, 0xd4, 0x95, 0x15, 0xe9, 0xa5, 0x9b, 0x9c, 0x78, 0xde, 0x97, 0x2c, 0x01, 0x1a, 0x83,
+    0x3d, 0x01, 0xa8, 0x89, 0x91, 0x7e, 0x4b, 0xd7, 0x2e, 0x48, 0xd5, 0x4d, 0xab, 0x7b, 0x9f, 0x00,
+    0xc0, 0xdd, 0x7f, 0x65, 0x99, 0xad, 0xab, 0xef, 0x1b, 0x14, 0xc3, 0xae, 0xf6, 0x35, 0xba, 0x6b,
+    0x6b, 0x3b, 0x44, 0x7d, 0xd6, 0xe2, 0x23, 0x0d, 0xec, 0x89, 0x8d, 0x46, 0xd1, 0x13, 0xfc, 0xf1,
+    0x3c, 0xfc, 0x3f, 0xb2, 0x37, 0x46, 0xfd, 0x47, 0x44, 0x3e, 0x3e, 0xaa, 0x33, 0x35, 0x54, 0x9c,
+    0xea, 0xa9, 0x74, 0xf7, 0x9b, 0x5c, 0x70, 0x0e, 0x6a, 0x1c, 0xd4, 0xaf, 0x28, 0x56, 0xc0, 0xf8,
+    0xbc, 0xe9, 0x5d, 0xd9, 0x86, 0x0d, 0xe8, 0xdb, 0x84, 0xfa, 0x70, 0x5c, 0x93, 0x34, 0x37, 0x90,
+    0x47, 0xb7, 0x16, 0xce, 0x96, 0xde, 0x97, 0x41, 0x4a, 0x51, 0x56, 0xa2, 0x9a, 0xe0, 0xa3, 0x34,
+    0x75, 0x8b, 0xc1, 0x85, 0x6b, 0xb7, 0xdb, 0x8d, 0xdb, 0x7e, 0xd7, 0x50, 0x79, 0xd2, 0x2c, 0xbd,
+    0xc3, 0xb8, 0x1b, 0xa1, 0x47, 0x97, 0x46, 0xf0, 0xaa, 0x19, 0x2d, 0xff, 0xe5, 0x3d, 0xa6, 0xb9,
+    0x8a, 0x44, 0xc3, 0x01, 0x79, 0x1b, 0xb5, 0x2d, 0x68, 0x85, 0x05, 0x06, 0xc1, 0x75, 0x62, 0x19,
+    0x0d, 0x0c, 0x8e, 0x4c, 0xd6, 0x2e, 0x05, 0xc1, 0x59, 0xb7, 0x8e, 0x6e, 0x71, 0xf5, 0x25, 0xf2,
+    0xad, 0xee, 0x92, 0x72, 0x1f, 0xf1, 0x8d, 0x53, 0x1f, 0xc9, 0xf0, 0xae, 0x39, 0x7a, 0xc9, 0x48,
+    0x20, 0x1d, 0x2f, 0xee, 0xeb, 0xec, 0x6f, 0x2b, 0x6e, 0xab, 0xab, 0xf0, 0x0b, 0x00, 0x00,
+};
+const size_t WEB_CSS_GZ_LEN = 959;
+const char WEB_CSS_ETAG[] = "\"bd7e20c16e360743\"";
+
+#endif
@@ -22,6 +22,7 @@ h1, h2 { color: #0056b3; }
 @media (min-width: 600px) { .upload-grid { grid-template-columns: repeat(2, 1fr); } }
 .upload-item { background: #f9f9f9; padding: 2px; border-radius: 5px; border: 1px solid #ddd; display: flex; flex-direction: column; }
 .upload-item label { font-weight: bold; display: block; margin-bottom: 5px; }
+.upload-item select { margin-bottom: 10px; }
 .upload-item .button-group { display: flex; gap: 5px; margin-top: auto; }
 .upload-item .button-group button { padding: 4px 8px; font-size: 0.8em; }
 input[type="file"] { display: block; margin-bottom: 10px; width: 100%; }
@@ -69,6 +70,7 @@ const char* WEB_HTML = R"=====(
             <div class="section">
                 <h2>Audio Control</h2>
                 <button onclick="stopAudio()" class="stop-btn">Stop All Audio</button>
+                <p id="playback-state" class="info">Idle</p>
                 <div class="volume-control">
                     <label>Volume:</label>
                     <input type="range" id="volume-slider" class="volume-slider" min="0" max="100" value="50" onchange="setVolume(this.value)">
@@ -87,56 +89,7 @@ const char* WEB_HTML = R"=====(
             <div class="section">
                 <h2>Upload Audio Files</h2>
                 <form id="upload-form" enctype="multipart/form-data">
-                    <div class="upload-grid">
-                        <div class="upload-item">
-                            <label>Button 1:</label>
-                            <input type="file" name="file" data-button="1" accept=".mp3">
-                            <div class="button-group">
-                                <button type="button" onclick="uploadFile(1)">Upload</button>
-                                <button type="button" onclick="testButton(1)">Test</button>
-                            </div>
-                        </div>
-                        <div class="upload-item">
-                            <label>Button 2:</label>
-                            <input type="file" name="file" data-button="2" accept=".mp3">
-                            <div class="button-group">
-                                <button type="button" onclick="uploadFile(2)">Upload</button>
-                                <button type="button" onclick="testButton(2)">Test</button>
-                            </div>
-                        </div>
-                        <div class="upload-item">
-                            <label>Button 3:</label>
-                            <input type="file" name="file" data-button="3" accept=".mp3">
-                            <div class="button-group">
-                                <button type="button" onclick="uploadFile(3)">Upload</button>
-                                <button type="button" onclick="testButton(3)">Test</button>
-                            </div>
-                        </div>
-                        <div class="upload-item">
-                            <label>Button 4:</label>
-                            <input type="file" name="file" data-button="4" accept=".mp3">
-                            <div class="button-group">
-                                <button type="button" onclick="uploadFile(4)">Upload</button>
-                                <button type="button" onclick="testButton(4)">Test</button>
-                            </div>
-                        </div>
-                        <div class="upload-item">
-                            <label>Button 5:</label>
-                            <input type="file" name="file" data-button="5" accept=".mp3">
-                            <div class="button-group">
-                                <button type="button" onclick="uploadFile(5)">Upload</button>
-                                <button type="button" onclick="testButton(5)">Test</button>
-                            </div>
-                        </div>
-                        <div class="upload-item">
-                            <label>Button 6:</label>
-                            <input type="file" name="file" data-button="6" accept=".mp3">
-                            <div class="button-group">
-                                <button type="button" onclick="uploadFile(6)">Upload</button>
-                                <button type="button" onclick="testButton(6)">Test</button>
-                            </div>
-                        </div>
-                    </div>
+                    <div class="upload-grid" id="upload-grid"></div>
                 </form>
             </div>
         </div>
@@ -145,62 +98,112 @@ const char* WEB_HTML = R"=====(
     </div>
 
     <script>
-        function updateBattery() {
-            fetch('/battery')
-                .then(response => response.ok ? response.json() : Promise.reject('Network response was not ok.'))
-                .then(data => {
-                    document.getElementById('battery-voltage').textContent = data.voltage.toFixed(2);
-                    const percentage = Math.min(100, Math.max(0, (data.voltage - 3.0) / (4.2 - 3.0) * 100));
-                    document.getElementById('battery-level').style.width = percentage + '%';
-                    
-                    // Color coding
-                    const batteryLevel = document.getElementById('battery-level');
-                    batteryLevel.classList.remove('battery-good', 'battery-medium', 'battery-low');
-                    if (percentage > 50) {
-                        batteryLevel.classList.add('battery-good');
-                    } else if (percentage > 20) {
-                        batteryLevel.classList.add('battery-medium');
+        function showBattery(battery) {
+            document.getElementById('battery-voltage').textContent = battery.voltage.toFixed(2);
+            const percentage = battery.percent;
+            document.getElementById('battery-level').style.width = percentage + '%';
+            
+            // Color coding
+            const batteryLevel = document.getElementById('battery-level');
+            batteryLevel.classList.remove('battery-good', 'battery-medium', 'battery-low');
+            if (percentage > 50) {
+                batteryLevel.classList.add('battery-good');
+            } else if (percentage > 20) {
+                batteryLevel.classList.add('battery-medium');
+            } else {
+                batteryLevel.classList.add('battery-low');
+            }
+        }
+        
+        // Clip k of button i is buttoni.mp3 for k = 1, buttoni_k.mp3 after that
+        function clipName(button, number) {
+            return 'button' + button + (number > 1 ? '_' + number : '') + '.mp3';
+        }
+        
+        // One upload slot per button, laid out once the device reports how many it has
+        function showUploadSlots(count, clipsPerButton) {
+            const grid = document.getElementById('upload-grid');
+            if (grid.children.length === count) {
+                return;
+            }
+            grid.innerHTML = '';
+            for (let i = 1; i <= count; i++) {
+                let options = '';
+                for (let k = 1; k <= clipsPerButton; k++) {
+                    options += `<option value="${k}">${clipName(i, k)}</option>`;
+                }
+                const item = document.createElement('div');
+                item.className = 'upload-item';
+                item.innerHTML = `<label>Button ${i}:</label>
+                    <input type="file" name="file" data-button="${i}" accept=".mp3">
+                    <select data-clip="${i}">${options}</select>
+                    <div class="button-group">
+                        <button type="button" onclick="uploadFile(${i})">Upload</button>
+                        <button type="button" onclick="testButton(${i})">Test</button>
+                    </div>`;
+                grid.appendChild(item);
+            }
+        }
+        
+        function showFiles(list) {
+            const clipsPerButton = list.clipsPerButton || 1;
+            showUploadSlots(list.buttons, clipsPerButton);
+            const fileList = document.getElementById('file-list');
+            fileList.innerHTML = '<div class="file-status-grid"></div>';
+            const grid = fileList.querySelector('.file-status-grid');
+            
+            for (let i = 1; i <= list.buttons; i++) {
+                for (let k = 1; k <= clipsPerButton; k++) {
+                    const filename = clipName(i, k);
+                    const clip = list.clips.find(c => c.name === filename);
+                    // Only the first clip of a button is listed while it is missing
+                    if (!clip && k > 1) {
+                        continue;
+                    }
+                    const div = document.createElement('div');
+                    div.className = 'file-status-item';
+                    let content = `<div><span>Button ${i}${k > 1 ? ' #' + k : ''}</span>`;
+                    if (clip) {
+                        const details = `${(clip.ms / 1000).toFixed(1)} s, ${clip.kbps} kbps, ${clip.hz} Hz, ${clip.gainDb >= 0 ? '+' : ''}${clip.gainDb} dB, ${Math.round(clip.bytes / 1024)} KB, #${clip.hash}`;
+                        content += `<span class="filename" title="${details}">${filename}</span></div><button onclick="deleteFile('${filename}')">Dlt</button>`;
                     } else {
-                        batteryLevel.classList.add('battery-low');
+                        content += `<span class="no-file">[No File]</span></div>`;
                     }
-                })
-                .catch(error => {
-                    console.error('Error fetching battery status:', error);
-                    document.getElementById('status').textContent = 'Error fetching battery status.';
-                });
+                    div.innerHTML = content;
+                    grid.appendChild(div);
+                }
+            }
         }
         
-        function updateFileList() {
-            fetch('/files')
-                .then(response => response.ok ? response.json() : Promise.reject('Network response was not ok.'))
-                .then(data => {
-                    const fileList = document.getElementById('file-list');
-                    fileList.innerHTML = '<div class="file-status-grid"></div>';
-                    const grid = fileList.querySelector('.file-status-grid');
-                    
-                    for (let i = 1; i <= 6; i++) {
-                        const filename = 'button' + i + '.mp3';
-                        const exists = data.files && data.files.includes(filename);
-                        const div = document.createElement('div');
-                        div.className = 'file-status-item';
-                        let content = `<div><span>Button ${i}</span>`;
-                        if (exists) {
-                            content += `<span class="filename" title="${filename}">${filename}</span></div><button onclick="deleteFile('${filename}')">Dlt</button>`;
-                        } else {
-                            content += `<span class="no-file">[No File]</span></div>`;
-                        }
-                        div.innerHTML = content;
-                        grid.appendChild(div);
-                    }
-                })
-                .catch(error => {
-                    console.error('Error updating file list:', error);
-                    document.getElementById('status').textContent = 'Error updating file list.';
-                });
+        function showVolume(volume) {
+            const volumePercent = Math.round(volume * 100);
+            document.getElementById('volume-slider').value = volumePercent;
+            document.getElementById('volume-value').textContent = volumePercent + '%';
+        }
+        
+        function showState(state) {
+            const text = state.playing ? `Playing button ${state.button}` + (state.voices > 1 ? ` (+${state.voices - 1} more)` : '') : 'Idle';
+            document.getElementById('playback-state').textContent = text;
+            showVolume(state.volume);
+        }
+        
+        // The device pushes battery, playback, volume and file changes over one connection
+        function connectEvents() {
+            const events = new EventSource('/events');
+            events.addEventListener('battery', e => showBattery(JSON.parse(e.data)));
+            events.addEventListener('files', e => showFiles(JSON.parse(e.data)));
+            events.addEventListener('state', e => showState(JSON.parse(e.data)));
+            events.onerror = () => {
+                document.getElementById('status').textContent = 'Connection lost, reconnecting...';
+            };
+            events.onopen = () => {
+                document.getElementById('status').textContent = 'Connected.';
+            };
         }
         
         function uploadFile(buttonNum) {
             const input = document.querySelector(`input[data-button="${buttonNum}"]`);
+            const clipNumber = document.querySelector(`select[data-clip="${buttonNum}"]`).value;
             const file = input.files[0];
             
             if (!file) {
@@ -217,18 +220,25 @@ const char* WEB_HTML = R"=====(
             formData.append('file', file);
             formData.append('button', buttonNum);
             
-            document.getElementById('status').innerHTML = `Uploading to button ${buttonNum}...`;
+            document.getElementById('status').innerHTML = `Uploading ${clipName(buttonNum, clipNumber)}...`;
             
-            fetch('/upload?button=' + buttonNum, {
+            // A busy device answers 503 with Retry-After; send it again a few times
+            const send = retries => fetch('/upload?button=' + buttonNum + '&clip=' + clipNumber, {
                 method: 'POST',
                 body: formData
             })
-            .then(response => response.ok ? response.json() : Promise.reject('Network response was not ok.'))
+            .then(response => {
+                if (response.status === 503 && retries > 0) {
+                    const seconds = parseInt(response.headers.get('Retry-After')) || 2;
+                    document.getElementById('status').innerHTML = `Device busy, retrying in ${seconds} s...`;
+                    return new Promise(resolve => setTimeout(resolve, seconds * 1000)).then(() => send(retries - 1));
+                }
+                return response.ok ? response.json() : Promise.reject('Network response was not ok.');
+            });
+            send(3)
             .then(data => {
                 document.getElementById('status').innerHTML = data.message;
                 input.value = '';
-                // Update file list after successful upload
-                updateFileList();
             })
             .catch(error => {
                 document.getElementById('status').innerHTML = 'Upload failed: ' + error;
@@ -260,7 +270,6 @@ const char* WEB_HTML = R"=====(
                 .then(response => {
                     if (!response.ok) return Promise.reject('Deletion failed.');
                     document.getElementById('status').innerHTML = `File ${filename} deleted.`;
-                    updateFileList();
                 })
                 .catch(error => document.getElementById('status').innerHTML = error);
             }
@@ -280,27 +289,8 @@ const char* WEB_HTML = R"=====(
             .catch(error => console.error('Error setting volume:', error));
         }
         
-        function getVolume() {
-            fetch('/volume')
-                .then(response => response.ok ? response.json() : Promise.reject('Network response was not ok.'))
-                .then(data => {
-                    const volumePercent = Math.round(data.volume * 100);
-                    document.getElementById('volume-slider').value = volumePercent;
-                    document.getElementById('volume-value').textContent = volumePercent + '%';
-                })
-                .catch(error => {
-                    console.error('Error getting volume:', error);
-                    document.getElementById('status').textContent = 'Error getting volume.';
-                });
-        }
-        
-        // Initial load and periodic updates
-        document.addEventListener('DOMContentLoaded', () => {
-            updateBattery();
-            updateFileList();
-            getVolume();
-            setInterval(updateBattery, 10000);
-        });
+        // Initial state arrives as soon as the event stream connects
+        document.addEventListener('DOMContentLoaded', connectEvents);
     </script>
 </body>
 </html>
@@ -1,17 +1,67 @@
 #ifndef WEB_SERVER_H
 #define WEB_SERVER_H
 
-#include <WebServer.h>
+#include <atomic>
+#include <ESPAsyncWebServer.h>
 #include <SPIFFS.h>
 #include <FS.h>
-#include "web_interface.h"
+#include "web_assets.h"
+#include "upload_writer.h"
+#include "metrics.h"
+#include "response_writer.h"
+#include "pad_topology.h"
+#include "battery_monitor.h"
+#include "clip_index.h"
+#include "playlist.h"
 #include "config.h"
 
-class WebServerManager {
+// Upload state kept on the request itself (_tempObject is freed with the request)
+struct UploadState {
+    int clip;
+    bool owner;     // This request holds the upload writer
+    int rejectCode; // HTTP status to answer with instead of the upload result, 0 if none
+};
+
+// One cue of a /schedule request
+struct CueRequest {
+    int buttonNum;
+    unsigned long startAt; // micros() time
+    float gain;
+};
+
+// Playback snapshot pushed to the web UI
+struct PlaybackStatus {
+    bool playing;
+    int button;  // Most recently started button, 0 when idle
+    int voices;
+    float volume;
+};
+
+// HTTP front end. Requests are handled on the AsyncTCP task as data arrives,
+// so a slow or stalled client never holds up loop(), the buttons or audio.
+// Callbacks therefore run on the AsyncTCP task too, except onClipChanged,
+// which is deferred to handleClient() on the loop task.
+template<typename Pad>
+class BasicWebServerManager {
 private:
-    WebServer* server;
-    File uploadFile;
-    String uploadFilename;
+    static constexpr size_t FILE_LIST_BYTES = 48 + Pad::clips * 112;
+    static constexpr size_t PLAYLIST_LIST_BYTES = 16 + Pad::buttons * (40 + 7 * PLAYLIST_MAX_CLIPS);
+    static_assert(FILE_LIST_BYTES <= WEB_RESPONSE_BYTES && PLAYLIST_LIST_BYTES <= WEB_RESPONSE_BYTES,
+                  "Raise WEB_RESPONSE_BYTES for this many clips");
+    static constexpr int CLIP_CHANGE_WORDS = Pad::clips / 32 + 1;
+    
+    AsyncWebServer* server;
+    UploadWriter uploadWriter;
+    int activeRequests;                        // Only touched on the AsyncTCP task
+    std::atomic<uint32_t> pendingClipChanges[CLIP_CHANGE_WORDS]; // Bit per clip, drained in handleClient()
+    AsyncEventSource *events;                  // Push channel for the web UI at /events
+    std::atomic<bool> eventClientJoined;
+    char fileList[FILE_LIST_BYTES];            // Event payload, built on the loop task
+    uint32_t indexRevision;                    // Of clipIndex when the file list was last pushed
+    PlaybackStatus lastStatus;
+    unsigned long lastStatusPoll;
+    unsigned long lastBatteryPush;
+    bool listening;
     
     // Function pointers for callbacks
     void (*onTestButton)(int buttonNum) = nullptr;
@@ -19,241 +69,789 @@ private:
     void (*onSetVolume)(float volume) = nullptr;
     float (*onGetVolume)() = nullptr;
     void (*onWebActivity)() = nullptr; // New callback for web activity
+    void (*onClipChanged)(int clip) = nullptr; // Called after a clip is uploaded or deleted
+    void (*onGetStatus)(PlaybackStatus &status) = nullptr;
+    bool (*onSchedule)(const CueRequest *cues, int count) = nullptr; // All or none
     
     // Helper to update activity for all requests
     void updateWebActivity();
-    
+    void route(const char *uri, WebRequestMethodComposite method,
+               void (BasicWebServerManager::*handler)(AsyncWebServerRequest *));
+    bool admit(AsyncWebServerRequest *request, bool respond = true);
+    void markClipChanged(int clip);
+    void sendUploadBusy(AsyncWebServerRequest *request);
+    void sendAsset(AsyncWebServerRequest *request, const uint8_t *data, size_t length, const char *contentType,
+                   const char *etag);
+    static bool getParam(AsyncWebServerRequest *request, const char *name, String &value);
+    static void writeBattery(ResponseWriter &json);
+    static void buildFileList(ResponseWriter &json);
+    static void writePlaylist(ResponseWriter &json, int buttonNum);
+    void pushEvents(bool clipsChanged);
+
 public:
-    WebServerManager();
-    ~WebServerManager();
+    BasicWebServerManager();
+    ~BasicWebServerManager();
     void init();
+    // Open and close the listening socket as the network comes and goes; init() starts it
+    void start();
+    void stop();
     void handleClient();
     void setTestButtonCallback(void (*callback)(int));
     void setStopAudioCallback(void (*callback)());
     void setVolumeCallbacks(void (*setCallback)(float), float (*getCallback)());
     void setWebActivityCallback(void (*callback)()); // New method
+    void setClipChangedCallback(void (*callback)(int));
+    void setClipCloseCallback(bool (*callback)(int));
+    void setStatusCallback(void (*callback)(PlaybackStatus &));
+    void setScheduleCallback(bool (*callback)(const CueRequest *, int));
     
     // Handler functions
-    void handleRoot();
-    void handleCSS();
-    void handleBattery();
-    void handleFileUpload();
-    void handleUploadResult();
-    void handleListFiles();
-    void handleDeleteFile();
-    void handleTestButton();
-    void handleStopAudio();
-    void handleSetVolume();
-    void handleGetVolume();
+    void handleRoot(AsyncWebServerRequest *request);
+    void handleCSS(AsyncWebServerRequest *request);
+    void handleBattery(AsyncWebServerRequest *request);
+    void handleFileUpload(AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data,
+                          size_t len, bool final);
+    void handleUploadResult(AsyncWebServerRequest *request);
+    void handleListFiles(AsyncWebServerRequest *request);
+    void handleDeleteFile(AsyncWebServerRequest *request);
+    void handleTestButton(AsyncWebServerRequest *request);
+    void handleSchedule(AsyncWebServerRequest *request);
+    void handleSetPlaylist(AsyncWebServerRequest *request);
+    void handleGetPlaylists(AsyncWebServerRequest *request);
+    void handleStopAudio(AsyncWebServerRequest *request);
+    void handleSetVolume(AsyncWebServerRequest *request);
+    void handleGetVolume(AsyncWebServerRequest *request);
+#if METRICS_ENABLED
+    void handleMetrics(AsyncWebServerRequest *request);
+#endif
 };
 
+typedef BasicWebServerManager<Pads> WebServerManager;
+
 // Implementation
-WebServerManager::WebServerManager() {
-    server = new WebServer(80);
+template<typename Pad>
+BasicWebServerManager<Pad>::BasicWebServerManager() : eventClientJoined(false) {
+    for (int i = 0; i < CLIP_CHANGE_WORDS; i++) {
+        pendingClipChanges[i] = 0;
+    }
+    server = new AsyncWebServer(80);
+    events = new AsyncEventSource("/events");
+    activeRequests = 0;
+    lastStatus = {false, 0, 0, -1.0f};
+    lastStatusPoll = 0;
+    lastBatteryPush = 0;
+    indexRevision = 0;
+    listening = false;
 }
 
-WebServerManager::~WebServerManager() {
+template<typename Pad>
+BasicWebServerManager<Pad>::~BasicWebServerManager() {
     if (server) {
+        server->end();
         delete server;
         server = nullptr;
     }
+    if (events) {
+        delete events;
+        events = nullptr;
+    }
 }
 
-void WebServerManager::updateWebActivity() {
+template<typename Pad>
+void BasicWebServerManager<Pad>::updateWebActivity() {
     if (onWebActivity != nullptr) {
         onWebActivity();
     }
 }
 
-void WebServerManager::init() {
+template<typename Pad>
+void BasicWebServerManager<Pad>::init() {
     // Setup web server routes
-    server->on("/", HTTP_GET, [this](){ this->handleRoot(); });
-    server->on("/battery", HTTP_GET, [this](){ this->handleBattery(); }); 
-    server->on("/upload", HTTP_POST, [this](){ this->handleUploadResult(); }, [this](){ this->handleFileUpload(); });
-    server->on("/files", HTTP_GET, [this](){ this->handleListFiles(); });
-    server->on("/delete", HTTP_POST, [this](){ this->handleDeleteFile(); });
-    server->on("/test", HTTP_POST, [this](){ this->handleTestButton(); });
-    server->on("/stop", HTTP_POST, [this](){ this->handleStopAudio(); });
-    server->on("/volume", HTTP_POST, [this](){ this->handleSetVolume(); });
-    server->on("/volume", HTTP_GET, [this](){ this->handleGetVolume(); });
-    server->on("/style.css", HTTP_GET, [this](){ this->handleCSS(); });
+    route("/", HTTP_GET, &BasicWebServerManager::handleRoot);
+    route("/battery", HTTP_GET, &BasicWebServerManager::handleBattery);
+    server->on("/upload", HTTP_POST, [this](AsyncWebServerRequest *r){ this->handleUploadResult(r); },
+               [this](AsyncWebServerRequest *r, const String &filename, size_t index, uint8_t *data, size_t len, bool final){
+                   METRIC_TIMER_START(started);
+                   this->handleFileUpload(r, filename, index, data, len, final);
+                   METRIC_OBSERVE_SINCE(httpHandler, started);
+               });
+    route("/files", HTTP_GET, &BasicWebServerManager::handleListFiles);
+    route("/delete", HTTP_POST, &BasicWebServerManager::handleDeleteFile);
+    route("/test", HTTP_POST, &BasicWebServerManager::handleTestButton);
+    route("/schedule", HTTP_POST, &BasicWebServerManager::handleSchedule);
+    route("/playlist", HTTP_POST, &BasicWebServerManager::handleSetPlaylist);
+    route("/playlist", HTTP_GET, &BasicWebServerManager::handleGetPlaylists);
+    route("/stop", HTTP_POST, &BasicWebServerManager::handleStopAudio);
+    route("/volume", HTTP_POST, &BasicWebServerManager::handleSetVolume);
+    route("/volume", HTTP_GET, &BasicWebServerManager::handleGetVolume);
+    route("/style.css", HTTP_GET, &BasicWebServerManager::handleCSS);
+#if METRICS_ENABLED
+    route("/metrics", HTTP_GET, &BasicWebServerManager::handleMetrics);
+#endif
+
+    // A new subscriber gets a full snapshot on the next handleClient()
+    events->onConnect([this](AsyncEventSourceClient *client){
+        if (events->count() > WEB_MAX_EVENT_CLIENTS) {
+            client->client()->close();
+            return;
+        }
+        eventClientJoined = true;
+    });
+    server->addHandler(events);
+    server->onNotFound([](AsyncWebServerRequest *r){ sendText(r, 404, "text/plain", "Not found"); });
     
+    uploadWriter.init();
+    start();
+}
+
+template<typename Pad>
+void BasicWebServerManager<Pad>::start() {
+    if (listening) {
+        return;
+    }
     server->begin();
+    listening = true;
     Serial.println("HTTP server started");
 }
 
-void WebServerManager::handleClient() {
-    server->handleClient();
+template<typename Pad>
+void BasicWebServerManager<Pad>::stop() {
+    if (!listening) {
+        return;
+    }
+    server->end();
+    listening = false;
+    Serial.println("HTTP server stopped");
+}
+
+// Requests are served by the AsyncTCP task; this only runs work deferred to the loop task
+template<typename Pad>
+void BasicWebServerManager<Pad>::handleClient() {
+    // The writer task swapped in, deleted or transcoded a clip; let the audio side pick it up
+    int changedClip;
+    while (uploadWriter.takeDone(changedClip)) {
+        markClipChanged(changedClip);
+    }
+    
+    // The clip preparation task rescans changed clips after they were reported here
+    uint32_t revision = clipIndex.getRevision();
+    bool anyChanged = revision != indexRevision;
+    indexRevision = revision;
+    for (int word = 0; word < CLIP_CHANGE_WORDS; word++) {
+        uint32_t changed = pendingClipChanges[word].exchange(0);
+        anyChanged |= changed != 0;
+        for (int bit = 0; changed != 0 && bit < 32; bit++) {
+            if ((changed & (1UL << bit)) && onClipChanged != nullptr) {
+                onClipChanged(word * 32 + bit);
+            }
+        }
+    }
+    
+    if (listening) {
+        pushEvents(anyChanged);
+    }
+}
+
+// Sends only what changed since the last push, as small JSON events
+template<typename Pad>
+void BasicWebServerManager<Pad>::pushEvents(bool clipsChanged) {
+    if (events->count() == 0) {
+        return;
+    }
+    bool full = eventClientJoined.exchange(false);
+    unsigned long now = millis();
+    
+    if (full || clipsChanged) {
+        ResponseWriter json(fileList, sizeof(fileList));
+        buildFileList(json);
+        events->send(json.c_str(), "files");
+    }
+    
+    char buffer[96];
+    if (full || now - lastBatteryPush >= BATTERY_UPDATE_INTERVAL) {
+        lastBatteryPush = now;
+        ResponseWriter json(buffer, sizeof(buffer));
+        writeBattery(json);
+        events->send(json.c_str(), "battery");
+    }
+    
+    if (onGetStatus == nullptr || (!full && now - lastStatusPoll < EVENT_STATUS_INTERVAL_MS)) {
+        return;
+    }
+    lastStatusPoll = now;
+    PlaybackStatus status;
+    onGetStatus(status);
+    bool changedStatus = status.playing != lastStatus.playing || status.button != lastStatus.button ||
+                         status.voices != lastStatus.voices || status.volume != lastStatus.volume;
+    if (full || changedStatus) {
+        lastStatus = status;
+        ResponseWriter json(buffer, sizeof(buffer));
+        json.text("{" JSON_KEY("playing")).boolean(status.playing)
+            .text("," JSON_KEY("button")).integer(status.button)
+            .text("," JSON_KEY("voices")).integer(status.voices)
+            .text("," JSON_KEY("volume")).decimal(status.volume).text("}");
+        events->send(json.c_str(), "state");
+    }
 }
 
-void WebServerManager::setTestButtonCallback(void (*callback)(int)) {
+template<typename Pad>
+void BasicWebServerManager<Pad>::markClipChanged(int clip) {
+    pendingClipChanges[clip / 32].fetch_or(1UL << (clip % 32));
+}
+
+// Registers a handler; its run time goes into the HTTP handler histogram
+template<typename Pad>
+void BasicWebServerManager<Pad>::route(const char *uri, WebRequestMethodComposite method,
+                             void (BasicWebServerManager::*handler)(AsyncWebServerRequest *)) {
+    server->on(uri, method, [this, handler](AsyncWebServerRequest *r){
+        METRIC_TIMER_START(started);
+        (this->*handler)(r);
+        METRIC_OBSERVE_SINCE(httpHandler, started);
+    });
+}
+
+// Caps the number of requests in flight; each one holds buffers until its client disconnects
+template<typename Pad>
+bool BasicWebServerManager<Pad>::admit(AsyncWebServerRequest *request, bool respond) {
+    if (activeRequests >= WEB_MAX_CONNECTIONS) {
+        if (respond) {
+            sendText(request, 503, "text/plain", "Server busy");
+        }
+        return false;
+    }
+    activeRequests++;
+    request->onDisconnect([this](){ activeRequests--; });
+    return true;
+}
+
+// Form fields arrive in the body, the upload button comes in the query string
+template<typename Pad>
+bool BasicWebServerManager<Pad>::getParam(AsyncWebServerRequest *request, const char *name, String &value) {
+    if (request->hasParam(name, true)) {
+        value = request->getParam(name, true)->value();
+        return true;
+    }
+    if (request->hasParam(name)) {
+        value = request->getParam(name)->value();
+        return true;
+    }
+    return false;
+}
+
+template<typename Pad>
+void BasicWebServerManager<Pad>::setTestButtonCallback(void (*callback)(int)) {
     onTestButton = callback;
 }
 
-void WebServerManager::setStopAudioCallback(void (*callback)()) {
+template<typename Pad>
+void BasicWebServerManager<Pad>::setStopAudioCallback(void (*callback)()) {
     onStopAudio = callback;
 }
 
-void WebServerManager::setVolumeCallbacks(void (*setCallback)(float), float (*getCallback)()) {
+template<typename Pad>
+void BasicWebServerManager<Pad>::setVolumeCallbacks(void (*setCallback)(float), float (*getCallback)()) {
     onSetVolume = setCallback;
     onGetVolume = getCallback;
 }
 
-void WebServerManager::setWebActivityCallback(void (*callback)()) {
+template<typename Pad>
+void BasicWebServerManager<Pad>::setWebActivityCallback(void (*callback)()) {
     onWebActivity = callback;
 }
 
-void WebServerManager::handleCSS() {
+template<typename Pad>
+void BasicWebServerManager<Pad>::setClipChangedCallback(void (*callback)(int)) {
+    onClipChanged = callback;
+}
+
+template<typename Pad>
+void BasicWebServerManager<Pad>::setClipCloseCallback(bool (*callback)(int)) {
+    uploadWriter.setCloseCallback(callback);
+}
+
+template<typename Pad>
+void BasicWebServerManager<Pad>::setStatusCallback(void (*callback)(PlaybackStatus &)) {
+    onGetStatus = callback;
+}
+
+template<typename Pad>
+void BasicWebServerManager<Pad>::setScheduleCallback(bool (*callback)(const CueRequest *, int)) {
+    onSchedule = callback;
+}
+
+// Sends a pre-gzipped asset from web_assets.h, or 304 when the browser already has it.
+// Every browser that can run the UI accepts gzip, so Accept-Encoding is not checked.
+template<typename Pad>
+void BasicWebServerManager<Pad>::sendAsset(AsyncWebServerRequest *request, const uint8_t *data, size_t length,
+                                 const char *contentType, const char *etag) {
+    unsigned long started = micros();
+    AsyncWebServerResponse *response;
+    bool notModified = request->hasHeader("If-None-Match") && request->header("If-None-Match") == etag;
+    if (notModified) {
+        response = request->beginResponse(304);
+    } else {
+        response = request->beginResponse_P(200, contentType, data, length);
+        response->addHeader("Content-Encoding", "gzip");
+    }
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", "no-cache"); // Revalidate every time, the ETag makes that cheap
+    request->send(response);
+    
+    if (notModified) {
+        Serial.printf("%s: 304 in %lu us\n", contentType, micros() - started);
+    } else {
+        Serial.printf("%s: %u bytes in %lu us\n", contentType, length, micros() - started);
+    }
+}
+
+template<typename Pad>
+void BasicWebServerManager<Pad>::handleCSS(AsyncWebServerRequest *request) {
     updateWebActivity();
-    server->send(200, "text/css", WEB_CSS);
+    if (!admit(request)) {
+        return;
+    }
+    sendAsset(request, WEB_CSS_GZ, WEB_CSS_GZ_LEN, "text/css", WEB_CSS_ETAG);
 }
 
-void WebServerManager::handleRoot() {
+template<typename Pad>
+void BasicWebServerManager<Pad>::handleRoot(AsyncWebServerRequest *request) {
     updateWebActivity();
-    server->send(200, "text/html", WEB_HTML);
+    if (!admit(request)) {
+        return;
+    }
+    sendAsset(request, WEB_HTML_GZ, WEB_HTML_GZ_LEN, "text/html", WEB_HTML_ETAG);
 }
 
-void WebServerManager::handleTestButton() {
+template<typename Pad>
+void BasicWebServerManager<Pad>::handleTestButton(AsyncWebServerRequest *request) {
     updateWebActivity();
-    if (server->hasArg("button")) {
-        int buttonNum = server->arg("button").toInt();
-        if (buttonNum >= 1 && buttonNum <= 6) {
+    if (!admit(request)) {
+        return;
+    }
+    String value;
+    if (getParam(request, "button", value)) {
+        int buttonNum = value.toInt();
+        if (Pad::isButton(buttonNum)) {
             if (onTestButton != nullptr) {
                 onTestButton(buttonNum);
             }
-            server->send(200, "text/plain", "Testing button " + String(buttonNum));
+            FixedResponse *response = new FixedResponse(200, "text/plain");
+            response->content().text("Testing button ").integer(buttonNum);
+            request->send(response);
         } else {
-            server->send(400, "text/plain", "Invalid button number");
+            sendText(request, 400, "text/plain", "Invalid button number");
         }
     } else {
-        server->send(400, "text/plain", "Missing button parameter");
+        sendText(request, 400, "text/plain", "Missing button parameter");
+    }
+}
+
+// cues=button:offsetMs[:gain],... with offsets measured from one shared
+// reference, so the spacing between cues in a request is exact
+template<typename Pad>
+void BasicWebServerManager<Pad>::handleSchedule(AsyncWebServerRequest *request) {
+    updateWebActivity();
+    if (!admit(request)) {
+        return;
+    }
+    String cues;
+    if (!getParam(request, "cues", cues)) {
+        sendText(request, 400, "text/plain", "Missing cues parameter");
+        return;
+    }
+    
+    // The whole batch is checked before any of it is queued, so a rejected request changes nothing
+    unsigned long base = micros() + SCHEDULE_LEAD_MS * 1000;
+    CueRequest batch[SCHEDULE_MAX_BATCH];
+    int count = 0;
+    int start = 0;
+    while (start < (int)cues.length()) {
+        int end = cues.indexOf(',', start);
+        if (end < 0) {
+            end = cues.length();
+        }
+        String cue = cues.substring(start, end);
+        start = end + 1;
+        
+        int firstColon = cue.indexOf(':');
+        int secondColon = cue.indexOf(':', firstColon + 1);
+        if (firstColon < 0) {
+            sendText(request, 400, "text/plain", "Cues look like button:offsetMs[:gain]");
+            return;
+        }
+        int buttonNum = cue.substring(0, firstColon).toInt();
+        long offsetMs = cue.substring(firstColon + 1, secondColon < 0 ? cue.length() : secondColon).toInt();
+        float gain = secondColon < 0 ? 1.0f : cue.substring(secondColon + 1).toFloat();
+        if (!Pad::isButton(buttonNum) || offsetMs < 0 || offsetMs > (long)SCHEDULE_MAX_OFFSET_MS) {
+            FixedResponse *response = new FixedResponse(400, "text/plain");
+            response->content().text("Invalid cue: ").append(cue.c_str());
+            request->send(response);
+            return;
+        }
+        if (count == SCHEDULE_MAX_BATCH) {
+            sendText(request, 400, "text/plain", "Too many cues in one request");
+            return;
+        }
+        batch[count++] = {buttonNum, base + offsetMs * 1000, gain};
+    }
+    if (count > 0 && (onSchedule == nullptr || !onSchedule(batch, count))) {
+        sendText(request, 503, "text/plain", "Schedule full, no cues scheduled");
+        return;
+    }
+    FixedResponse *response = new FixedResponse(200, "application/json");
+    response->content().text("{" JSON_KEY("scheduled")).integer(count).text("}");
+    request->send(response);
+}
+
+// button=N&clips=3,1,4&mode=round-robin|random|sequence|loop, where clips are
+// the clip slots (button numbers) to play in order
+template<typename Pad>
+void BasicWebServerManager<Pad>::handleSetPlaylist(AsyncWebServerRequest *request) {
+    updateWebActivity();
+    if (!admit(request)) {
+        return;
+    }
+    String button, clips, mode;
+    if (!getParam(request, "button", button) || !getParam(request, "clips", clips)) {
+        sendText(request, 400, "text/plain", "Missing button or clips parameter");
+        return;
+    }
+    PlaylistMode playlistMode = PLAYLIST_ROUND_ROBIN;
+    if (getParam(request, "mode", mode) && !PlaylistTable::parseMode(mode.c_str(), playlistMode)) {
+        sendText(request, 400, "text/plain", "Mode is round-robin, random, sequence or loop");
+        return;
+    }
+    
+    uint8_t slots[PLAYLIST_MAX_CLIPS];
+    int count = 0;
+    const char *p = clips.c_str();
+    while (*p) {
+        const char *end = p;
+        int clip = Pad::clipFromLabel(p, &end);
+        if (clip == 0 || (*end != ',' && *end != '\0') || count == PLAYLIST_MAX_CLIPS) {
+            sendText(request, 400, "text/plain", "Clips are labels such as 3 or 3_2 separated by commas");
+            return;
+        }
+        slots[count++] = clip;
+        p = *end == ',' ? end + 1 : end;
     }
+    
+    int buttonNum = button.toInt();
+    if (!playlists.set(buttonNum, slots, count, playlistMode)) {
+        sendText(request, 400, "text/plain", "Invalid button number");
+        return;
+    }
+    FixedResponse *response = new FixedResponse(200, "application/json");
+    writePlaylist(response->content(), buttonNum);
+    request->send(response);
 }
 
-void WebServerManager::handleStopAudio() {
+// {"playlists":[{"button":1,"mode":"round-robin","clips":["1"]},...]}, clips
+// labelled as in their file names ("3_2" is button3_2.mp3)
+template<typename Pad>
+void BasicWebServerManager<Pad>::handleGetPlaylists(AsyncWebServerRequest *request) {
     updateWebActivity();
+    if (!admit(request)) {
+        return;
+    }
+    FixedResponse *response = new FixedResponse(200, "application/json");
+    ResponseWriter &json = response->content();
+    json.text("{" JSON_KEY("playlists") "[");
+    for (int i = 1; i <= Pad::buttons; i++) {
+        if (i > 1) {
+            json.text(",");
+        }
+        writePlaylist(json, i);
+    }
+    json.text("]}");
+    request->send(response);
+}
+
+template<typename Pad>
+void BasicWebServerManager<Pad>::writePlaylist(ResponseWriter &json, int buttonNum) {
+    Playlist list = playlists.get(buttonNum);
+    json.text("{" JSON_KEY("button")).integer(buttonNum)
+        .text("," JSON_KEY("mode")).quoted(PlaylistTable::modeName(list.mode))
+        .text("," JSON_KEY("clips") "[");
+    for (int i = 0; i < list.count; i++) {
+        if (i > 0) {
+            json.text(",");
+        }
+        json.quoted(Pad::clipPath(list.clips[i], "").label());
+    }
+    json.text("]}");
+}
+
+template<typename Pad>
+void BasicWebServerManager<Pad>::handleStopAudio(AsyncWebServerRequest *request) {
+    updateWebActivity();
+    if (!admit(request)) {
+        return;
+    }
     if (onStopAudio != nullptr) {
         onStopAudio();
     }
-    server->send(200, "text/plain", "Audio stopped");
+    sendText(request, 200, "text/plain", "Audio stopped");
 }
 
-void WebServerManager::handleBattery() {
+template<typename Pad>
+void BasicWebServerManager<Pad>::handleBattery(AsyncWebServerRequest *request) {
     updateWebActivity();
-    int adcValue = analogRead(BATTERY_PIN);
-    float voltage = adcValue * ADC_TO_VOLT;
-    String json = "{\"voltage\": " + String(voltage) + "}";
-    server->send(200, "application/json", json);
+    if (!admit(request)) {
+        return;
+    }
+    FixedResponse *response = new FixedResponse(200, "application/json");
+    writeBattery(response->content());
+    request->send(response);
 }
 
-void WebServerManager::handleFileUpload() {
-    updateWebActivity();
-    HTTPUpload& upload = server->upload();
-    if (upload.status == UPLOAD_FILE_START) {
-        if (!server->hasArg("button")) {
-            Serial.println("Upload started without button number!");
+// {"voltage":3.92,"percent":70} from the battery monitor's last sample
+template<typename Pad>
+void BasicWebServerManager<Pad>::writeBattery(ResponseWriter &json) {
+    BatteryReading battery = batteryMonitor.get();
+    json.text("{" JSON_KEY("voltage")).decimal(battery.volts)
+        .text("," JSON_KEY("percent")).integer(lroundf(battery.percent)).text("}");
+}
+
+template<typename Pad>
+void BasicWebServerManager<Pad>::handleFileUpload(AsyncWebServerRequest *request, const String &filename, size_t index,
+                                        uint8_t *data, size_t len, bool final) {
+    (void)filename; // The clip comes from the button and clip parameters
+    UploadState *state = static_cast<UploadState *>(request->_tempObject);
+    if (index == 0 && !state) {
+        updateWebActivity();
+        state = (UploadState *)malloc(sizeof(UploadState));
+        if (!state) {
             return;
         }
-        uploadFilename = "/audio/button" + server->arg("button") + ".mp3";
+        state->clip = 0;
+        state->owner = false;
+        state->rejectCode = 0;
+        request->_tempObject = state;
         
-        if (SPIFFS.exists(uploadFilename)) {
-            SPIFFS.remove(uploadFilename);
+        // The body is still arriving, so refusals are answered in handleUploadResult
+        if (!admit(request, false)) {
+            state->rejectCode = 503;
+            return;
         }
-        
-        uploadFile = SPIFFS.open(uploadFilename, "w");
-        if (!uploadFile) {
-            Serial.printf("Failed to create file: %s\n", uploadFilename.c_str());
+        // "clip" picks one of the button's files, buttonN.mp3 when it is left out
+        String value;
+        int buttonNum = getParam(request, "button", value) ? value.toInt() : 0;
+        int number = getParam(request, "clip", value) ? value.toInt() : 1;
+        if (!Pad::isButton(buttonNum) || number < 1 || number > MAX_CLIPS_PER_BUTTON) {
+            Serial.println("Upload started without a valid button or clip number!");
+            state->rejectCode = 400;
             return;
         }
-        Serial.printf("Upload Start: %s\n", uploadFilename.c_str());
-    } else if (upload.status == UPLOAD_FILE_WRITE) {
-        if (uploadFile) {
-            size_t bytesWritten = uploadFile.write(upload.buf, upload.currentSize);
-            if (bytesWritten != upload.currentSize) {
-                Serial.println("File write failed");
-                uploadFile.close();
-            }
+        state->clip = Pad::clipOf(buttonNum, number);
+        // One writer serves every connection, so a second concurrent upload is turned away
+        if (uploadWriter.isReceiving()) {
+            state->rejectCode = 409;
+            return;
         }
-    } else if (upload.status == UPLOAD_FILE_END) {
-        if (uploadFile) {
-            uploadFile.close();
-            Serial.printf("Upload End: %s, %u bytes\n", uploadFilename.c_str(), upload.totalSize);
-        } else {
-            Serial.println("Upload file not open.");
+        state->owner = uploadWriter.start(Pad::clipPath(state->clip), state->clip);
+        if (state->owner) {
+            // Replaces the handler set by admit(): also release the writer if the client goes away mid-upload
+            request->onDisconnect([this, request](){
+                activeRequests--;
+                UploadState *s = static_cast<UploadState *>(request->_tempObject);
+                if (s && s->owner && uploadWriter.isReceiving()) {
+                    uploadWriter.abort();
+                }
+            });
         }
     }
+    if (!state || !state->owner) {
+        return;
+    }
+    
+    // Size is enforced as the bytes arrive; a rejected upload is dropped here.
+    // write() never blocks: if the flash writer falls behind the upload is
+    // dropped and answered with 503. The writer task swaps the file in and
+    // reports the clip through takeDone().
+    if (len > 0) {
+        uploadWriter.write(data, len);
+    }
+    if (final) {
+        uploadWriter.finish();
+        state->owner = false;
+    }
 }
 
-void WebServerManager::handleUploadResult() {
-    updateWebActivity();
-    // The file upload is complete. Now we can safely report success.
-    String json = "{\"status\":\"success\", \"message\":\"File uploaded successfully!\"}";
-    server->send(200, "application/json", json);
-    delay(100); 
+template<typename Pad>
+void BasicWebServerManager<Pad>::handleUploadResult(AsyncWebServerRequest *request) {
+    UploadState *state = static_cast<UploadState *>(request->_tempObject);
+    if (!state) {
+        sendText(request, 400, "application/json", "{\"status\":\"error\", \"message\":\"No file received\"}");
+        return;
+    }
+    switch (state->rejectCode) {
+        case 0:
+            break;
+        case 503:
+            sendUploadBusy(request);
+            return;
+        case 409:
+            sendText(request, 409, "application/json", "{\"status\":\"error\", \"message\":\"Another upload is in progress\"}");
+            return;
+        default:
+            sendText(request, 400, "application/json", "{\"status\":\"error\", \"message\":\"Invalid button or clip number\"}");
+            return;
+    }
+    
+    switch (uploadWriter.getLastResult()) {
+        case UploadWriter::UPLOAD_OK: {
+            // Received in full; the swap follows on the writer task and shows in the file list
+            FixedResponse *response = new FixedResponse(202, "application/json");
+            response->content().text("{" JSON_KEY("status") "\"success\","
+                                     JSON_KEY("message") "\"File uploaded, saving it\","
+                                     JSON_KEY("kbps")).decimal(uploadWriter.getThroughputKBps()).text("}");
+            request->send(response);
+            break;
+        }
+        case UploadWriter::UPLOAD_BUSY:
+            sendUploadBusy(request);
+            break;
+        case UploadWriter::UPLOAD_TOO_LARGE:
+            sendText(request, 413, "application/json", "{\"status\":\"error\", \"message\":\"File too large! Maximum size is 500KB\"}");
+            break;
+        default:
+            sendText(request, 500, "application/json", "{\"status\":\"error\", \"message\":\"Upload failed\"}");
+            break;
+    }
+}
+
+// The server or the flash writer had no room for the upload; the client may send it again shortly
+template<typename Pad>
+void BasicWebServerManager<Pad>::sendUploadBusy(AsyncWebServerRequest *request) {
+    FixedResponse *response = new FixedResponse(503, "application/json");
+    response->content().text("{\"status\":\"error\", \"message\":\"Server busy, try again\"}");
+    response->addHeader("Retry-After", String(UPLOAD_RETRY_AFTER_S));
+    request->send(response);
 }
 
-void WebServerManager::handleListFiles() {
+template<typename Pad>
+void BasicWebServerManager<Pad>::handleListFiles(AsyncWebServerRequest *request) {
     updateWebActivity();
-    Serial.println("Listing files in /audio directory:");
-    
-    String json = "{\"files\":[";
+    if (!admit(request)) {
+        return;
+    }
+    FixedResponse *response = new FixedResponse(200, "application/json");
+    buildFileList(response->content());
+    request->send(response);
+}
+
+// {"buttons":N,"clipsPerButton":K,"clips":[{"name":"button1.mp3","bytes":...,"ms":...,"kbps":...,"hz":...,
+// "gainDb":...,"hash":"..."},...]}
+// from the clip index; the UI lays out one slot per button
+template<typename Pad>
+void BasicWebServerManager<Pad>::buildFileList(ResponseWriter &json) {
+    json.text("{" JSON_KEY("buttons")).integer(Pad::buttons)
+        .text("," JSON_KEY("clipsPerButton")).integer(MAX_CLIPS_PER_BUTTON).text("," JSON_KEY("clips") "[");
     bool first = true;
-    
-    // Check each specific button file
-    for (int i = 1; i <= NUM_BUTTONS; i++) {
-        String buttonFile = "/audio/button" + String(i) + ".mp3";
-        if (SPIFFS.exists(buttonFile)) {
-            if (!first) {
-                json += ",";
-            }
-            json += "\"button" + String(i) + ".mp3\"";
-            first = false;
-            Serial.println("Found: " + buttonFile);
+    for (int i = 1; i <= Pad::clips; i++) {
+        ClipInfo info = clipIndex.get(i);
+        if (info.size == 0) {
+            continue;
         }
+        char hash[9];
+        for (int digit = 0; digit < 8; digit++) {
+            hash[digit] = "0123456789abcdef"[(info.hash >> (28 - digit * 4)) & 0xF];
+        }
+        hash[8] = '\0';
+        if (!first) {
+            json.text(",");
+        }
+        json.text("{" JSON_KEY("name")).quoted(Pad::clipPath(i).name())
+            .text("," JSON_KEY("bytes")).integer(info.size)
+            .text("," JSON_KEY("ms")).integer(info.durationMs)
+            .text("," JSON_KEY("kbps")).integer(info.bitrateKbps)
+            .text("," JSON_KEY("hz")).integer(info.sampleRate)
+            .text("," JSON_KEY("gainDb")).decimal(info.gainCentiDb / 100.0f)
+            .text("," JSON_KEY("hash")).quoted(hash).text("}");
+        first = false;
     }
-    
-    json += "]}";
-    Serial.println("JSON response: " + json);
-    server->send(200, "application/json", json); 
+    json.text("]}");
 }
 
-void WebServerManager::handleDeleteFile() {
+template<typename Pad>
+void BasicWebServerManager<Pad>::handleDeleteFile(AsyncWebServerRequest *request) {
     updateWebActivity();
-    if (server->hasArg("filename")) {
-        String filename = "/audio/" + server->arg("filename");
-        if (SPIFFS.exists(filename)) {
-            SPIFFS.remove(filename);
-            server->send(200, "text/plain", "File deleted");
-            Serial.println("Deleted file: " + filename);
-        } else {
-            server->send(404, "text/plain", "File not found");
+    if (!admit(request)) {
+        return;
+    }
+    String name;
+    if (!getParam(request, "filename", name)) {
+        sendText(request, 400, "text/plain", "Missing filename");
+        return;
+    }
+    // Only clip names such as "button3.mp3" or "button3_2.mp3" are accepted
+    int clip = Pad::clipFromName(name.c_str());
+    if (clip == 0) {
+        sendText(request, 400, "text/plain", "Invalid filename");
+        return;
+    }
+    ClipPath path = Pad::clipPath(clip);
+    ClipInfo info = clipIndex.get(clip);
+    if (info.size > 0) {
+        // The writer task closes the clip and removes it; the file list follows
+        if (!uploadWriter.queueDelete(path, clip)) {
+            sendText(request, 503, "text/plain", "Server busy");
+            return;
         }
+        sendText(request, 202, "text/plain", "Deleting file");
     } else {
-        server->send(400, "text/plain", "Missing filename");
+        sendText(request, 404, "text/plain", "File not found");
     }
 }
 
-void WebServerManager::handleSetVolume() {
+template<typename Pad>
+void BasicWebServerManager<Pad>::handleSetVolume(AsyncWebServerRequest *request) {
     updateWebActivity();
-    if (server->hasArg("volume")) {
-        float volume = server->arg("volume").toFloat();
+    if (!admit(request)) {
+        return;
+    }
+    String value;
+    if (getParam(request, "volume", value)) {
+        // Clamped here as the audio manager does, so the reply names the volume that is used
+        float volume = value.toFloat();
+        volume = constrain(volume, MIN_AUDIO_GAIN, MAX_AUDIO_GAIN);
         if (onSetVolume != nullptr) {
             onSetVolume(volume);
         }
-        server->send(200, "text/plain", "Volume set to " + String(volume));
+        FixedResponse *response = new FixedResponse(200, "text/plain");
+        response->content().text("Volume set to ").decimal(volume);
+        request->send(response);
     } else {
-        server->send(400, "text/plain", "Missing volume parameter");
+        sendText(request, 400, "text/plain", "Missing volume parameter");
     }
 }
 
-void WebServerManager::handleGetVolume() {
+template<typename Pad>
+void BasicWebServerManager<Pad>::handleGetVolume(AsyncWebServerRequest *request) {
     updateWebActivity();
+    if (!admit(request)) {
+        return;
+    }
     float volume = 0.5; // Default value
     if (onGetVolume != nullptr) {
         volume = onGetVolume();
     }
-    String json = "{\"volume\": " + String(volume) + "}";
-    server->send(200, "application/json", json);
+    FixedResponse *response = new FixedResponse(200, "application/json");
+    response->content().text("{" JSON_KEY("volume")).decimal(volume).text("}");
+    request->send(response);
+}
+
+#if METRICS_ENABLED
+template<typename Pad>
+void BasicWebServerManager<Pad>::handleMetrics(AsyncWebServerRequest *request) {
+    if (!admit(request)) {
+        return;
+    }
+    AsyncResponseStream *response = request->beginResponseStream("text/plain; version=0.0.4");
+    metrics.write(*response);
+    request->send(response);
 }
+#endif
 
-#endif
\ No newline at end of file
+#endif
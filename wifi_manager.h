@@ -0,0 +1,253 @@
+#ifndef WIFI_MANAGER_H
+#define WIFI_MANAGER_H
+
+#include <WiFi.h>
+#include "secrets.h"
+#include "metrics.h"
+#include "config.h"
+
+enum WifiState : uint8_t {
+    WIFI_STATE_IDLE,
+    WIFI_STATE_FAST_CONNECT, // Joining with the channel, BSSID and address cached before deep sleep
+    WIFI_STATE_CONNECTING,   // Full scan and DHCP
+    WIFI_STATE_CONNECTED,
+    WIFI_STATE_BACKOFF       // Waiting before the next attempt
+};
+
+// Last good connection, kept in RTC memory. It survives deep sleep but not a
+// power cycle or reset, so it is only used when waking from sleep.
+struct WifiCache {
+    uint32_t magic;
+    int32_t channel;
+    uint8_t bssid[6];
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+};
+
+// Non-blocking WiFi connection, driven by update() from loop(). After a deep
+// sleep wake it first joins the cached access point on its known channel
+// with the cached address, skipping the scan and DHCP. Failed attempts retry
+// with exponential backoff. After WIFI_AP_FALLBACK_FAILURES of them it also
+// opens a local access point, as long as WIFI_AP_PASSWORD is defined in
+// secrets.h. The network callbacks fire when the device becomes reachable
+// (station connected or access point up) and when it stops being reachable.
+class WifiManager {
+private:
+    WifiState state;
+    unsigned long stateSince;
+    unsigned long sequenceStarted; // First attempt since the last connection
+    unsigned long backoffMs;
+    uint32_t failures;
+    bool accessPoint;
+    bool reachable;
+    bool fastAttempt; // The current attempt uses the cache
+    
+    // Run on the loop task
+    void (*onUp)() = nullptr;
+    void (*onDown)() = nullptr;
+    
+    void enter(WifiState next);
+    void connectFast();
+    void connectFull();
+    void connected();
+    void failed();
+    void startAccessPoint();
+    void stopAccessPoint();
+    void saveCache();
+    static bool cacheValid();
+
+public:
+    WifiManager();
+    void begin();
+    void update();
+    void setNetworkCallbacks(void (*up)(), void (*down)());
+    WifiState getState() const { return state; }
+    bool isConnected() const { return state == WIFI_STATE_CONNECTED; }
+    bool isAccessPointActive() const { return accessPoint; }
+};
+
+WifiManager wifiManager;
+
+// Implementation
+static const uint32_t WIFI_CACHE_MAGIC = 0x57494649; // "WIFI"
+RTC_DATA_ATTR static WifiCache wifiCache;
+
+WifiManager::WifiManager() {
+    state = WIFI_STATE_IDLE;
+    stateSince = 0;
+    sequenceStarted = 0;
+    backoffMs = WIFI_BACKOFF_MIN_MS;
+    failures = 0;
+    accessPoint = false;
+    reachable = false;
+    fastAttempt = false;
+}
+
+void WifiManager::begin() {
+    // The state machine reconnects itself; the core must not write credentials to flash on every begin()
+    WiFi.persistent(false);
+    WiFi.setAutoReconnect(false);
+    WiFi.mode(WIFI_STA);
+    sequenceStarted = millis();
+    if (cacheValid()) {
+        connectFast();
+    } else {
+        connectFull();
+    }
+}
+
+void WifiManager::setNetworkCallbacks(void (*up)(), void (*down)()) {
+    onUp = up;
+    onDown = down;
+}
+
+void WifiManager::update() {
+    unsigned long inState = millis() - stateSince;
+    wl_status_t status = WiFi.status();
+    
+    switch (state) {
+        case WIFI_STATE_FAST_CONNECT:
+        case WIFI_STATE_CONNECTING: {
+            unsigned long timeout = state == WIFI_STATE_FAST_CONNECT ? WIFI_FAST_CONNECT_TIMEOUT_MS
+                                                                      : WIFI_CONNECT_TIMEOUT_MS;
+            if (status == WL_CONNECTED) {
+                connected();
+            } else if (status == WL_CONNECT_FAILED || status == WL_NO_SSID_AVAIL || inState >= timeout) {
+                failed();
+            }
+            break;
+        }
+        case WIFI_STATE_CONNECTED:
+            if (status != WL_CONNECTED) {
+                Serial.println("WiFi connection lost");
+                sequenceStarted = millis();
+                connectFull();
+            }
+            break;
+        case WIFI_STATE_BACKOFF:
+            if (inState >= backoffMs) {
+                connectFull();
+            }
+            break;
+        default:
+            break;
+    }
+    
+    bool nowReachable = state == WIFI_STATE_CONNECTED || accessPoint;
+    if (nowReachable != reachable) {
+        reachable = nowReachable;
+        void (*callback)() = reachable ? onUp : onDown;
+        if (callback) {
+            callback();
+        }
+    }
+}
+
+void WifiManager::enter(WifiState next) {
+    state = next;
+    stateSince = millis();
+}
+
+void WifiManager::connectFast() {
+    fastAttempt = true;
+    WiFi.config(IPAddress(wifiCache.ip), IPAddress(wifiCache.gateway), IPAddress(wifiCache.subnet),
+                IPAddress(wifiCache.dns));
+    WiFi.begin(ssid, password, wifiCache.channel, wifiCache.bssid);
+    enter(WIFI_STATE_FAST_CONNECT);
+}
+
+void WifiManager::connectFull() {
+    fastAttempt = false;
+    WiFi.disconnect();
+    WiFi.config((uint32_t)0, (uint32_t)0, (uint32_t)0); // Back to DHCP
+    WiFi.begin(ssid, password);
+    enter(WIFI_STATE_CONNECTING);
+}
+
+void WifiManager::connected() {
+    unsigned long took = millis() - sequenceStarted;
+    if (fastAttempt) {
+        METRIC_OBSERVE(wifiConnectCached, took);
+    } else {
+        METRIC_OBSERVE(wifiConnectScan, took);
+    }
+    Serial.printf("WiFi connected in %lu ms (%s), IP address: %s\n", took, fastAttempt ? "cached" : "scan",
+                  WiFi.localIP().toString().c_str());
+    
+    failures = 0;
+    backoffMs = WIFI_BACKOFF_MIN_MS;
+    saveCache();
+    stopAccessPoint();
+    enter(WIFI_STATE_CONNECTED);
+}
+
+void WifiManager::failed() {
+    if (fastAttempt) {
+        // The access point moved or the address is taken: forget the cache and scan
+        Serial.println("WiFi fast reconnect failed, scanning");
+        wifiCache.magic = 0;
+        connectFull();
+        return;
+    }
+    
+    failures++;
+    if (failures >= WIFI_AP_FALLBACK_FAILURES) {
+        startAccessPoint();
+    }
+    Serial.printf("WiFi connection failed (%lu), retrying in %lu ms\n", (unsigned long)failures, backoffMs);
+    WiFi.disconnect();
+    enter(WIFI_STATE_BACKOFF);
+    // The wait doubles after every failure, up to WIFI_BACKOFF_MAX_MS
+    backoffMs = backoffMs * 2 < WIFI_BACKOFF_MAX_MS ? backoffMs * 2 : WIFI_BACKOFF_MAX_MS;
+}
+
+void WifiManager::startAccessPoint() {
+    if (accessPoint) {
+        return;
+    }
+#ifdef WIFI_AP_PASSWORD
+    WiFi.mode(WIFI_AP_STA);
+    if (WiFi.softAP(WIFI_AP_SSID, WIFI_AP_PASSWORD)) {
+        accessPoint = true;
+        Serial.printf("Fallback access point \"%s\" at %s\n", WIFI_AP_SSID, WiFi.softAPIP().toString().c_str());
+    }
+#else
+    static bool warned = false;
+    if (!warned) {
+        Serial.println("No fallback access point: define WIFI_AP_PASSWORD in secrets.h");
+        warned = true;
+    }
+#endif
+}
+
+void WifiManager::stopAccessPoint() {
+    if (!accessPoint) {
+        return;
+    }
+    WiFi.softAPdisconnect(true);
+    WiFi.mode(WIFI_STA);
+    accessPoint = false;
+    Serial.println("Fallback access point closed");
+}
+
+void WifiManager::saveCache() {
+    const uint8_t *bssid = WiFi.BSSID();
+    if (!bssid) {
+        return;
+    }
+    wifiCache.channel = WiFi.channel();
+    memcpy(wifiCache.bssid, bssid, sizeof(wifiCache.bssid));
+    wifiCache.ip = WiFi.localIP();
+    wifiCache.gateway = WiFi.gatewayIP();
+    wifiCache.subnet = WiFi.subnetMask();
+    wifiCache.dns = WiFi.dnsIP();
+    wifiCache.magic = WIFI_CACHE_MAGIC;
+}
+
+bool WifiManager::cacheValid() {
+    return wifiCache.magic == WIFI_CACHE_MAGIC && wifiCache.channel > 0 && wifiCache.ip != 0;
+}
+
+#endif